@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "cista/arena.h"
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+struct entry {
+  std::uint64_t id_;
+  data::string name_;
+  data::vector<std::uint32_t> values_;
+};
+
+struct database {
+  data::vector<entry> entries_;
+};
+
+void fill(database& db, std::uint32_t const n) {
+  db.entries_.reserve(n);
+  for (auto i = 0U; i != n; ++i) {
+    auto& e = db.entries_.emplace_back();
+    e.id_ = i;
+    e.name_ = "entry " + std::to_string(i) + " with a name longer than SSO";
+    e.values_ = {i, i + 1U, i + 2U};
+  }
+}
+
+int main() {
+  constexpr auto const n = 2U * 1024U * 1024U;
+
+  auto heap = database{};
+  auto a = cista::arena{1024U * 1024U * 1024U};
+  auto const db = a.create<database>();
+
+  std::printf("%20s %16s\n", "", "time [ms]");
+  std::printf("%20s %16.2f\n", "build heap", measure([&]() { fill(heap, n); }));
+  std::printf("%20s %16.2f\n", "build arena", measure([&]() {
+                auto const scope = cista::arena_scope{a};
+                fill(*db, n);
+              }));
+
+  auto size = std::size_t{0U};
+  std::printf("%20s %16.2f\n", "serialize", measure([&]() {
+                size += cista::serialize(heap).size();
+              }));
+  std::printf("%20s %16.2f\n", "serialize_arena", measure([&]() {
+                size += cista::serialize_arena(a, *db).size();
+              }));
+  std::printf("%20s %16.2f\n", "to file", measure([&]() {
+                auto f = cista::file{"arena.bin", "w+"};
+                cista::serialize(f, heap);
+              }));
+  std::printf("%20s %16.2f\n", "arena to file", measure([&]() {
+                auto f = cista::file{"arena.bin", "w+"};
+                cista::serialize_arena(f, a, *db);
+              }));
+  std::remove("arena.bin");
+  std::printf("\n(%zu)\n", size);
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+
+#include "cista/compressed.h"
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+struct entry {
+  std::uint64_t id_;
+  data::string name_;
+  data::vector<std::uint32_t> values_;
+};
+
+struct database {
+  data::vector<entry> entries_;
+};
+
+int main() {
+  constexpr auto const n = 1024U * 1024U;
+  constexpr auto const n_reads = 1000U;
+
+  auto db = database{};
+  db.entries_.reserve(n);
+  for (auto i = 0U; i != n; ++i) {
+    auto& e = db.entries_.emplace_back();
+    e.id_ = i;
+    e.name_ = "entry " + std::to_string(i) + " with a name longer than SSO";
+    e.values_ = {i % 7U, i % 11U, i % 13U};
+  }
+  auto const buf = cista::serialize(db);
+
+  auto compressed = cista::byte_buf{};
+  std::printf("%24s %16s\n", "", "time [ms]");
+  std::printf("%24s %16.2f\n", "compress",
+              measure([&]() { compressed = cista::compress(buf); }));
+
+  auto sum = std::uint64_t{0U};
+  std::printf("%24s %16.2f\n", "decompress", measure([&]() {
+                sum += cista::decompress(compressed).size();
+              }));
+
+  auto rng = std::mt19937{42U};
+  auto idx = std::vector<std::uint32_t>(n_reads);
+  for (auto& i : idx) {
+    i = static_cast<std::uint32_t>(rng() % n);
+  }
+
+  std::printf("%24s %16.2f\n", "decompress + 1k reads", measure([&]() {
+                auto d = cista::decompress(compressed);
+                auto const r = cista::deserialize<database>(d);
+                for (auto const i : idx) {
+                  sum += r->entries_[i].values_[1U];
+                }
+              }));
+  std::printf("%24s %16.2f\n", "view + 1k reads", measure([&]() {
+                auto const img = cista::compressed_image{compressed};
+                auto const r = cista::view_compressed<database>(img);
+                auto const entries = r.get(&database::entries_);
+                for (auto const i : idx) {
+                  sum += entries[i].get(&entry::values_)[1U];
+                }
+              }));
+
+  std::printf("\nsize: %zu -> %zu bytes (%.2fx)\n(%" PRIu64 ")\n", buf.size(),
+              compressed.size(),
+              static_cast<double>(buf.size()) /
+                  static_cast<double>(compressed.size()),
+              sum);
+}
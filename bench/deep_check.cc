@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+struct item {
+  std::uint32_t id_;
+  data::indexed_vector<std::uint64_t> values_;
+  data::vector<data::ptr<std::uint64_t>> refs_;  // into other items' values
+};
+
+struct items {
+  data::vector<data::ptr<item>> roots_;
+  data::indexed_vector<item> items_;
+};
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+  constexpr auto const degree = 4U;
+
+  std::printf("%12s %16s %16s %16s\n", "items", "checked [ms]",
+              "deep check [ms]", "pointers");
+  for (auto const n : {10'000U, 100'000U, 1'000'000U, 4'000'000U}) {
+    auto x = items{};
+    x.items_.resize(n);
+
+    auto rng = std::mt19937{n};
+    auto dist = std::uniform_int_distribution<std::uint32_t>{0U, n - 1U};
+    for (auto i = 0U; i != n; ++i) {
+      x.items_[i].id_ = i;
+      x.items_[i].values_ = {i, i + 1U};
+      if (i % 4U == 0U) {
+        x.roots_.push_back(&x.items_[i]);
+      }
+    }
+    for (auto i = 0U; i != n; ++i) {
+      for (auto j = 0U; j != degree; ++j) {
+        x.items_[i].refs_.push_back(&x.items_[dist(rng)].values_[j % 2U]);
+      }
+    }
+
+    constexpr auto const DEEP = cista::mode::DEEP_CHECK;
+    auto const buf = cista::serialize(x);
+    auto const deep_buf = cista::serialize<DEEP>(x);
+
+    auto copy = buf;
+    auto const checked = measure([&]() { cista::deserialize<items>(copy); });
+    copy = deep_buf;
+    auto const deep =
+        measure([&]() { cista::deserialize<items, DEEP>(copy); });
+
+    std::printf("%12u %16.2f %16.2f %16zu\n", n, checked, deep,
+                x.roots_.size() + static_cast<std::size_t>(n) * degree);
+  }
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+struct record {
+  std::uint64_t id_;
+  std::uint32_t a_;
+  std::uint32_t b_;
+};
+
+// Same layout as `record` but opted out of the pointer-free fast path:
+// deserialization walks (and checks) every element individually.
+struct walked_record {
+  std::uint64_t id_;
+  std::uint32_t a_;
+  std::uint32_t b_;
+};
+
+template <>
+struct cista::is_pointer_free<walked_record> : std::false_type {};
+
+template <typename Record>
+double run(std::uint32_t const n, unsigned const repetitions) {
+  auto v = data::vector<Record>{};
+  v.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    v[i] = Record{i, i * 2U, i * 3U};
+  }
+  auto b = cista::serialize(v);
+
+  auto const start = std::chrono::steady_clock::now();
+  auto sum = std::uint64_t{0U};
+  for (auto r = 0U; r != repetitions; ++r) {
+    sum += cista::deserialize<data::vector<Record>>(b)->size();
+  }
+  auto const stop = std::chrono::steady_clock::now();
+
+  if (sum != static_cast<std::uint64_t>(n) * repetitions) {
+    std::printf("unexpected result\n");
+  }
+  return std::chrono::duration<double, std::milli>(stop - start).count() /
+         repetitions;
+}
+
+int main() {
+  constexpr auto const repetitions = 10U;
+  std::printf("%12s %16s %16s\n", "elements", "bulk [ms]", "walk [ms]");
+  for (auto const n : {1'000U, 100'000U, 1'000'000U, 10'000'000U}) {
+    std::printf("%12u %16.4f %16.4f\n", n, run<record>(n, repetitions),
+                run<walked_record>(n, repetitions));
+  }
+}
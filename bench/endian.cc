@@ -0,0 +1,91 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "cista/endian_view.h"
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+struct integers {
+  data::vector<std::uint16_t> u16_;
+  data::vector<std::uint32_t> u32_;
+  data::vector<std::uint64_t> u64_;
+  data::u16string text_;
+};
+
+int main() {
+  constexpr auto const n = 8U * 1024U * 1024U;  // 112 MB
+
+  auto x = integers{};
+  x.u16_.resize(n);
+  x.u32_.resize(n);
+  x.u64_.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    x.u16_[i] = static_cast<std::uint16_t>(i);
+    x.u32_[i] = i * 0x9E3779B9U;
+    x.u64_[i] = i * 0x9E3779B97F4A7C15ULL;
+  }
+  x.text_.set_owning(std::u16string(n, u'x'));
+
+  constexpr auto const BE = cista::mode::SERIALIZE_BIG_ENDIAN;
+  auto const buf = cista::serialize<BE>(x);
+
+  auto copy = buf;
+  std::printf("%20s %16s\n", "", "time [ms]");
+  std::printf("%20s %16.2f\n", "serialize",
+              measure([&]() { return cista::serialize<BE>(x).size(); }));
+  std::printf("%20s %16.2f\n", "serialize_parallel", measure([&]() {
+                return cista::serialize_parallel<BE>(x).size();
+              }));
+  std::printf("%20s %16.2f\n", "to file", measure([&]() {
+                auto f = cista::file{"endian.bin", "w+"};
+                cista::serialize<BE>(f, x);
+              }));
+  std::remove("endian.bin");
+  std::printf("%20s %16.2f\n", "deserialize",
+              measure([&]() { cista::deserialize<integers, BE>(copy); }));
+  copy = buf;
+  std::printf("%20s %16.2f\n", "deserialize_parallel", measure([&]() {
+                cista::deserialize_parallel<integers, BE>(copy);
+              }));
+
+  // Reading one value of each vector: in place conversion pays for the whole
+  // image upfront, the view only for what is read.
+  auto sum = std::uint64_t{0U};
+  copy = buf;
+  std::printf("\n%20s %16s\n", "", "read 3 values [ms]");
+  std::printf("%20s %16.2f\n", "deserialize", measure([&]() {
+                auto const d = cista::deserialize<integers, BE>(copy);
+                sum += d->u16_[n / 2U] + d->u32_[n / 2U] + d->u64_[n / 2U];
+              }));
+  std::printf("%20s %16.2f\n", "view", measure([&]() {
+                auto const v = cista::view<integers, BE>(buf);
+                sum += v.get(&integers::u16_)[n / 2U] +
+                       v.get(&integers::u32_)[n / 2U] +
+                       v.get(&integers::u64_)[n / 2U];
+              }));
+
+  std::printf("\n%20s %16s\n", "", "sum u64 [ms]");
+  auto const d = cista::deserialize<integers, BE>(copy = buf);
+  std::printf("%20s %16.2f\n", "deserialized", measure([&]() {
+                for (auto const x : d->u64_) {
+                  sum += x;
+                }
+              }));
+  std::printf("%20s %16.2f\n", "view", measure([&]() {
+                for (auto const x :
+                     cista::view<integers, BE>(buf).get(&integers::u64_)) {
+                  sum += x;
+                }
+              }));
+  std::printf("\n(%" PRIu64 ")\n", sum);
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+struct node {
+  std::uint32_t id_;
+  data::vector<data::ptr<node>> edges_;
+  data::indexed_vector<std::uint32_t> labels_;
+  data::ptr<std::uint32_t> best_label_;  // points into another node's labels
+};
+
+struct graph {
+  // Serialized before the nodes: every root is a forward reference.
+  data::vector<data::ptr<node>> roots_;
+  data::indexed_vector<node> nodes_;
+};
+
+int main() {
+  constexpr auto const degree = 4U;
+
+  std::printf("%12s %16s %16s\n", "nodes", "serialize [ms]", "size [MB]");
+  for (auto const n : {10'000U, 100'000U, 1'000'000U, 4'000'000U}) {
+    auto g = graph{};
+    g.nodes_.resize(n);
+
+    auto rng = std::mt19937{n};
+    auto dist = std::uniform_int_distribution<std::uint32_t>{0U, n - 1U};
+    for (auto i = 0U; i != n; ++i) {
+      g.nodes_[i].id_ = i;
+      for (auto j = 0U; j != degree; ++j) {
+        g.nodes_[i].edges_.push_back(&g.nodes_[dist(rng)]);
+      }
+      g.nodes_[i].labels_ = {i, i + 1U};
+      if (i % 16U == 0U) {
+        g.roots_.push_back(&g.nodes_[i]);
+      }
+    }
+
+    for (auto i = 0U; i != n; ++i) {
+      g.nodes_[i].best_label_ = &g.nodes_[dist(rng)].labels_[i % 2U];
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const buf = cista::serialize(g);
+    auto const stop = std::chrono::steady_clock::now();
+
+    std::printf("%12u %16.2f %16.2f\n", n,
+                std::chrono::duration<double, std::milli>(stop - start).count(),
+                static_cast<double>(buf.size()) / (1024.0 * 1024.0));
+  }
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+
+#include "cista/containers/hash_map.h"
+
+namespace data = cista::offset;
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+  constexpr auto const n = 16U * 1024U * 1024U;
+  constexpr auto const n_lookups = 16U * 1024U * 1024U;
+
+  auto rng = std::mt19937_64{42U};
+  auto keys = std::vector<std::uint64_t>(n_lookups);
+  for (auto& k : keys) {
+    k = rng() % n;
+  }
+
+  auto sum = std::uint64_t{0U};
+  auto const run = [&](char const* name) {
+    auto m = data::hash_map<std::uint64_t, std::uint64_t>{};
+    auto const build = measure([&]() {
+      for (auto i = 0U; i != n; ++i) {
+        m[i] = i;
+      }
+    });
+    auto const find = measure([&]() {
+      for (auto const k : keys) {
+        sum += m.find(k)->second;
+      }
+    });
+    std::printf("%20s %16.2f %16.2f\n", name, build, find);
+  };
+
+  std::printf("%20s %16s %16s\n", "", "build [ms]", "16M finds [ms]");
+  run("4k pages");
+  cista::huge_page_threshold() = cista::HUGE_PAGE_SIZE;
+  run("huge pages");
+  std::printf("\n(%" PRIu64 ")\n", sum);
+}
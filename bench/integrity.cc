@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <thread>
+
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+  constexpr auto const size = 64U * 1024U * 1024U;  // 512 MB
+
+  auto v = data::vector<std::uint64_t>{};
+  v.resize(size);
+  for (auto i = 0U; i != size; ++i) {
+    v[i] = i * 0x9E3779B97F4A7C15ULL;
+  }
+
+  constexpr auto const SEQ = cista::mode::WITH_INTEGRITY;
+  constexpr auto const CHUNKED = cista::mode::WITH_CHUNKED_INTEGRITY;
+  auto const seq_buf = cista::serialize<SEQ>(v);
+  auto const chunked_buf = cista::serialize<CHUNKED>(v);
+
+  std::printf("%16s %16s %16s\n", "", "serialize [ms]", "check [ms]");
+  std::printf("%16s %16.2f %16.2f\n", "WITH_INTEGRITY",
+              measure([&]() { return cista::serialize<SEQ>(v).size(); }),
+              measure([&]() {
+                cista::check<data::vector<std::uint64_t>, SEQ>(
+                    seq_buf.data(), seq_buf.data() + seq_buf.size());
+              }));
+  std::printf("%16s %16.2f %16.2f\n", "CHUNKED",
+              measure([&]() { return cista::serialize<CHUNKED>(v).size(); }),
+              measure([&]() {
+                cista::check<data::vector<std::uint64_t>, CHUNKED>(
+                    chunked_buf.data(),
+                    chunked_buf.data() + chunked_buf.size());
+              }));
+
+  std::printf("\n%16s %16s\n", "", "to file [ms]");
+  std::printf("%16s %16.2f\n", "WITH_INTEGRITY", measure([&]() {
+                auto f = cista::file{"integrity.bin", "w+"};
+                cista::serialize<SEQ>(f, v);
+              }));
+  std::printf("%16s %16.2f\n", "CHUNKED", measure([&]() {
+                auto f = cista::file{"integrity.bin", "w+"};
+                cista::serialize<CHUNKED>(f, v);
+              }));
+  std::remove("integrity.bin");
+
+  auto const data = std::string_view{
+      reinterpret_cast<char const*>(chunked_buf.data()), chunked_buf.size()};
+  std::printf("\n%16s %16s %16s\n", "threads", "CISTA_HASH [ms]",
+              "CRC32C [ms]");
+  for (auto const n_threads :
+       {1U, 2U, 4U, 8U, std::thread::hardware_concurrency()}) {
+    auto const list_hash = [&](cista::integrity_hash const algo) {
+      return measure([&]() {
+        return cista::chunk_list_hash(data, algo, n_threads);
+      });
+    };
+    std::printf("%16u %16.2f %16.2f\n", n_threads,
+                list_hash(cista::integrity_hash::CISTA_HASH),
+                list_hash(cista::integrity_hash::CRC32C));
+  }
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "cista/lazy.h"
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+struct entry {
+  std::uint64_t id_;
+  data::string name_;
+  data::vector<std::uint32_t> values_;
+};
+
+struct database {
+  data::vector<entry> entries_;
+};
+
+int main() {
+  constexpr auto const n = 2U * 1024U * 1024U;
+
+  auto db = database{};
+  db.entries_.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    auto& e = db.entries_[i];
+    e.id_ = i;
+    e.name_ = "entry " + std::to_string(i) + " with a name longer than SSO";
+    e.values_ = {i, i + 1U, i + 2U};
+  }
+  auto const buf = cista::serialize(db);
+
+  // Reading a few entries: full validation pays for the whole image upfront,
+  // lazy validation only for what is read.
+  auto sum = std::uint64_t{0U};
+  std::printf("%20s %16s\n", "", "read 100 [ms]");
+  std::printf("%20s %16.2f\n", "deserialize", measure([&]() {
+                auto const d = cista::deserialize<database>(buf);
+                for (auto i = 0U; i != 100U; ++i) {
+                  sum += d->entries_[i * 997U].values_[1U];
+                }
+              }));
+  std::printf("%20s %16.2f\n", "lazy_deserialize", measure([&]() {
+                auto const img = cista::lazy_deserialize<database>(buf);
+                auto const entries = img.root().get(&database::entries_);
+                for (auto i = 0U; i != 100U; ++i) {
+                  sum += entries[i * 997U].get(&entry::values_)[1U];
+                }
+              }));
+
+  std::printf("\n%20s %16s\n", "", "read all [ms]");
+  std::printf("%20s %16.2f\n", "deserialize", measure([&]() {
+                auto const d = cista::deserialize<database>(buf);
+                for (auto const& e : d->entries_) {
+                  sum += e.values_[1U];
+                }
+              }));
+  std::printf("%20s %16.2f\n", "lazy_deserialize", measure([&]() {
+                auto const img = cista::lazy_deserialize<database>(buf);
+                for (auto const e : img.root().get(&database::entries_)) {
+                  sum += e.get(&entry::values_)[1U];
+                }
+              }));
+  std::printf("\n(%" PRIu64 ")\n", sum);
+}
@@ -0,0 +1,68 @@
+#include <fcntl.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "cista/load.h"
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+constexpr auto const path = "load.bin";
+
+// Drops the file from the page cache: every load reads from the disk.
+void evict() {
+#ifdef POSIX_FADV_DONTNEED
+  auto f = cista::file{path, "r"};
+  ::posix_fadvise(f.fd(), 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+int main() {
+  constexpr auto const size = std::size_t{1024U} * 1024U * 1024U;
+  {
+    auto data = std::vector<std::uint8_t>(size);
+    for (auto i = std::size_t{0U}; i != size; ++i) {
+      data[i] = static_cast<std::uint8_t>(i * 7U);
+    }
+    auto f = cista::file{path, "w+"};
+    f.write(data.data(), data.size(), 0U);
+  }
+
+  auto sum = std::uint64_t{0U};
+  auto const run = [&](char const* name, auto&& load) {
+    evict();
+    auto const t = measure([&]() {
+      auto const b = load();
+      sum += b[size / 2U];
+    });
+    std::printf("%24s %16.2f %16.2f\n", name, t,
+                static_cast<double>(size) / (1024.0 * 1024.0) / t * 1000.0);
+  };
+
+  std::printf("%24s %16s %16s\n", "", "time [ms]", "MiB/s");
+  run("file::content()", []() { return cista::file{path, "r"}.content(); });
+  for (auto const n_threads : {1U, 4U, 8U}) {
+    for (auto const direct : {false, true}) {
+      auto opt = cista::load_options{};
+      opt.n_threads_ = n_threads;
+      opt.direct_ = direct;
+      auto const name = std::string{"load_file "} + std::to_string(n_threads) +
+                        (direct ? " direct" : "");
+      run(name.c_str(), [&]() { return cista::load_file(path, opt); });
+    }
+  }
+  auto opt = cista::load_options{};
+  opt.huge_pages_ = true;
+  run("load_file huge pages", [&]() { return cista::load_file(path, opt); });
+
+  std::remove(path);
+  std::printf("\n(%" PRIu64 ")\n", sum);
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "cista/mmap.h"
+#include "cista/targets/buf.h"
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+  constexpr auto const total = std::size_t{768U} * 1024U * 1024U;
+  constexpr auto const block = std::size_t{64U} * 1024U;
+  constexpr auto const path = "mmap_growth.bin";
+
+  auto const data = std::vector<std::uint8_t>(block, 0xABU);
+  auto const run = [&](char const* name, cista::growth_policy const& g,
+                       bool const reserve) {
+    auto opt = cista::mmap_options{};
+    opt.growth_ = g;
+    auto capacity = std::size_t{0U};
+    auto const t = measure([&]() {
+      auto b = cista::buf<cista::mmap>{
+          cista::mmap{path, cista::mmap::protection::WRITE, opt}};
+      if (reserve) {
+        b.reserve(total);
+      }
+      for (auto written = std::size_t{0U}; written < total; written += block) {
+        b.write(data.data(), data.size());
+      }
+      capacity = b.buf_.capacity();
+    });
+    std::printf("%24s %16.2f %16.1f\n", name, t,
+                static_cast<double>(capacity) / (1024.0 * 1024.0));
+  };
+
+  std::printf("%24s %16s %16s\n", "", "time [ms]", "mapped [MiB]");
+  run("power of two", cista::growth_policy::power_of_two(), false);
+  run("fixed 64 MiB", cista::growth_policy::fixed_chunk(64U << 20U), false);
+  run("geometric 1.25", cista::growth_policy::geometric(1.25), false);
+  run("exact + reserve", cista::growth_policy::exact(), true);
+  std::remove(path);
+}
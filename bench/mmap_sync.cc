@@ -0,0 +1,52 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "cista/containers/mmap_vec.h"
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+  constexpr auto const path = "mmap_sync.bin";
+  constexpr auto const initial = 128U * 1024U * 1024U;  // 1 GiB of uint64_t
+  constexpr auto const batch = 128U * 1024U;  // 1 MiB appended per flush
+  constexpr auto const n_flushes = 32U;
+
+  auto v = cista::mmap_vec<std::uint64_t>{
+      cista::mmap{path, cista::mmap::protection::WRITE}};
+  v.resize(initial);
+  for (auto i = 0U; i != initial; ++i) {
+    v[i] = i;
+  }
+  v.sync();
+
+  auto const append = [&]() {
+    for (auto i = 0U; i != batch; ++i) {
+      v.push_back(i);
+    }
+  };
+
+  std::printf("%24s %16s\n", "", "flush [ms]");
+  auto full = 0.0;
+  auto dirty = 0.0;
+  auto dirty_async = 0.0;
+  for (auto i = 0U; i != n_flushes; ++i) {
+    append();
+    full += measure([&]() { v.sync(); });
+    append();
+    dirty += measure([&]() { v.sync_dirty(); });
+    append();
+    dirty_async += measure([&]() { v.sync_dirty(true); });
+  }
+  std::printf("%24s %16.3f\n", "sync()", full / n_flushes);
+  std::printf("%24s %16.3f\n", "sync_dirty()", dirty / n_flushes);
+  std::printf("%24s %16.3f\n", "sync_dirty(async)", dirty_async / n_flushes);
+
+  std::remove(path);
+}
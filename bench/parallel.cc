@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <thread>
+
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+struct node {
+  std::uint32_t id_;
+  data::vector<data::ptr<node>> edges_;
+  data::vector<std::uint64_t> payload_;
+};
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+  constexpr auto const n = 200'000U;
+  constexpr auto const payload_size = 512U;  // 4 kB per node, ~800 MB total
+
+  auto nodes = data::indexed_vector<node>{};
+  nodes.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    nodes[i].id_ = i;
+    nodes[i].edges_.push_back(&nodes[(i * 7U) % n]);
+    nodes[i].payload_.resize(payload_size, i);
+  }
+
+  std::printf("%12s %16s\n", "threads", "serialize [ms]");
+  std::printf("%12s %16.2f\n", "sequential",
+              measure([&]() { return cista::serialize(nodes).size(); }));
+  for (auto const n_threads :
+       {1U, 2U, 4U, 8U, std::thread::hardware_concurrency()}) {
+    std::printf("%12u %16.2f\n", n_threads, measure([&]() {
+                  return cista::serialize_parallel(nodes, n_threads).size();
+                }));
+  }
+
+  constexpr auto const MODE = cista::mode::DEEP_CHECK;
+  auto const buf = cista::serialize<MODE>(nodes);
+  auto copy = buf;
+  std::printf("\n%12s %16s\n", "threads", "deserialize [ms]");
+  std::printf("%12s %16.2f\n", "sequential", measure([&]() {
+                copy = buf;
+                return cista::deserialize<decltype(nodes), MODE>(copy)->size();
+              }));
+  for (auto const n_threads :
+       {1U, 2U, 4U, 8U, std::thread::hardware_concurrency()}) {
+    std::printf("%12u %16.2f\n", n_threads, measure([&]() {
+                  copy = buf;
+                  return cista::deserialize_parallel<decltype(nodes), MODE>(
+                             copy, n_threads)
+                      ->size();
+                }));
+  }
+}
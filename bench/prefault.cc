@@ -0,0 +1,94 @@
+#include <fcntl.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+
+#include "cista/io.h"
+#include "cista/serialization.h"
+
+namespace data = cista::offset;
+
+template <typename Fn>
+double measure(Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  fn();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+struct database {
+  data::vector<std::uint64_t> values_;
+};
+
+constexpr auto const path = "prefault.bin";
+constexpr auto const MODE =  // No integrity check: it would read everything.
+    cista::mode::WITH_STATIC_VERSION | cista::mode::UNCHECKED;
+
+// Drops the file from the page cache so the first accesses are major faults.
+void evict() {
+#ifdef POSIX_FADV_DONTNEED
+  auto f = cista::file{path, "r"};
+  ::posix_fadvise(f.fd(), 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+long major_faults() {
+  auto usage = rusage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_majflt;
+}
+
+int main() {
+  constexpr auto const n = 64U * 1024U * 1024U;
+  constexpr auto const n_queries = 100000U;
+
+  {
+    auto db = database{};
+    db.values_.resize(n);
+    for (auto i = 0U; i != n; ++i) {
+      db.values_[i] = i;
+    }
+    cista::write<MODE>(path, db);
+  }
+
+  auto rng = std::mt19937{42U};
+  auto idx = std::vector<std::uint32_t>(n_queries);
+  for (auto& i : idx) {
+    i = static_cast<std::uint32_t>(rng() % n);
+  }
+
+  auto sum = std::uint64_t{0U};
+  auto const run = [&](char const* name, cista::mmap_options const& opt) {
+    evict();
+    auto const faults_before = major_faults();
+    auto const open = measure([&]() {
+      auto const db = cista::read_mmap<database, MODE>(path, opt);
+      auto const queries = measure([&]() {
+        for (auto const i : idx) {
+          sum += db->values_[i];
+        }
+      });
+      std::printf("%24s %16.2f", name, queries);
+    });
+    std::printf(" %16.2f %16ld\n", open, major_faults() - faults_before);
+  };
+
+  std::printf("%24s %16s %16s %16s\n", "", "queries [ms]", "total [ms]",
+              "major faults");
+  auto opt = cista::mmap_options{};
+  run("plain", opt);
+  opt.advice_ = cista::advice::RANDOM;
+  run("random advice", opt);
+  opt = cista::mmap_options{};
+  opt.populate_ = true;
+  run("populate", opt);
+  opt = cista::mmap_options{};
+  opt.prefault_threads_ = 8U;
+  run("prefault 8 threads", opt);
+
+  std::remove(path);
+  std::printf("\n(%" PRIu64 ")\n", sum);
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "cista/serialization.h"
+
+namespace data = cista::raw;
+
+struct node {
+  std::uint32_t id_;
+  std::uint32_t flags_;
+  std::uint64_t created_;
+  std::uint64_t updated_;
+  double weight_;
+  std::int32_t x_, y_, z_;
+  data::vector<data::ptr<node>> edges_;
+  data::string name_;
+  node* parent_;
+};
+
+template <cista::mode const Mode>
+double run(data::indexed_vector<node>& nodes, unsigned const repetitions,
+           unsigned const n_threads = 1U) {
+  auto const buf = cista::serialize<Mode>(nodes);
+  auto total = 0.0;
+  for (auto r = 0U; r != repetitions; ++r) {
+    auto copy = buf;
+    auto const start = std::chrono::steady_clock::now();
+    auto const d = cista::deserialize_parallel<data::indexed_vector<node>,
+                                               Mode | cista::mode::UNCHECKED>(
+        copy, n_threads);
+    auto const stop = std::chrono::steady_clock::now();
+    if (d->back().parent_->id_ != (d->size() - 1U) / 2U) {
+      std::printf("unexpected result\n");
+    }
+    total += std::chrono::duration<double, std::milli>(stop - start).count();
+  }
+  return total / repetitions;
+}
+
+int main() {
+  constexpr auto const repetitions = 5U;
+  std::printf("%12s %16s %16s %16s\n", "nodes", "walk [ms]", "table [ms]",
+              "table 4T [ms]");
+  for (auto const n : {10'000U, 100'000U, 1'000'000U, 4'000'000U}) {
+    auto nodes = data::indexed_vector<node>{};
+    nodes.resize(n);
+    for (auto i = 0U; i != n; ++i) {
+      nodes[i].id_ = i;
+      nodes[i].edges_.push_back(&nodes[(i * 7U) % n]);
+      nodes[i].edges_.push_back(&nodes[(i + 1U) % n]);
+      nodes[i].name_ = "node name that does not fit into the short buffer";
+      nodes[i].parent_ = i == 0U ? nullptr : &nodes[i / 2U];
+    }
+    std::printf("%12u %16.2f %16.2f %16.2f\n", n,
+                run<cista::mode::NONE>(nodes, repetitions),
+                run<cista::mode::WITH_RELOCATIONS>(nodes, repetitions),
+                run<cista::mode::WITH_RELOCATIONS>(nodes, repetitions, 4U));
+  }
+}
@@ -1,8 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
 #include <memory>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 #include "cista/next_power_of_2.h"
+#include "cista/unused_param.h"
 
 namespace cista {
 
@@ -17,7 +25,7 @@ T1 to_next_multiple(T1 const n, T2 const multiple) noexcept {
 #if CISTA_USE_MIMALLOC
 
 #include "mimalloc.h"
-#define CISTA_ALIGNED_ALLOC(alignment, size)                                  \
+#define CISTA_SYSTEM_ALIGNED_ALLOC(alignment, size)                           \
   (mi_malloc_aligned(                                                         \
       cista::to_next_multiple((size), cista::next_power_of_two((alignment))), \
       cista::next_power_of_two((alignment))))
@@ -26,23 +34,83 @@ T1 to_next_multiple(T1 const n, T2 const multiple) noexcept {
 
 #elif defined(_MSC_VER)
 
-#define CISTA_ALIGNED_ALLOC(alignment, size) \
+#define CISTA_SYSTEM_ALIGNED_ALLOC(alignment, size) \
   (_aligned_malloc((size), cista::next_power_of_two((alignment))))
 #define CISTA_ALIGNED_FREE(alignment, ptr) (_aligned_free((ptr)))
 
 #elif defined(_LIBCPP_HAS_C11_FEATURES) || defined(_GLIBCXX_HAVE_ALIGNED_ALLOC)
 
 #include <memory>
-#define CISTA_ALIGNED_ALLOC(alignment, size) \
-  (std::aligned_alloc(                       \
-      cista::next_power_of_two((alignment)), \
+#define CISTA_SYSTEM_ALIGNED_ALLOC(alignment, size) \
+  (std::aligned_alloc(                              \
+      cista::next_power_of_two((alignment)),        \
       cista::to_next_multiple((size), cista::next_power_of_two((alignment)))))
 #define CISTA_ALIGNED_FREE(alignment, ptr) std::free((ptr))
 
 #else
 
 #include <cstdlib>
-#define CISTA_ALIGNED_ALLOC(alignment, size) (std::malloc((size)))
+#define CISTA_SYSTEM_ALIGNED_ALLOC(alignment, size) (std::malloc((size)))
 #define CISTA_ALIGNED_FREE(alignment, ptr) (std::free((ptr)))
 
 #endif
+
+namespace cista {
+
+constexpr auto const HUGE_PAGE_SIZE = std::size_t{2U * 1024U * 1024U};
+
+// Allocations through CISTA_ALIGNED_ALLOC (hash_map, hash_set, arena,
+// aligned_allocator) of at least this many bytes are 2 MB aligned and
+// marked as eligible for transparent huge pages to reduce TLB misses.
+// Linux only, disabled by default (set to e.g. HUGE_PAGE_SIZE to enable).
+inline std::size_t& huge_page_threshold() noexcept {
+  static auto threshold = std::numeric_limits<std::size_t>::max();
+  return threshold;
+}
+
+inline void* aligned_alloc_with_hints(std::size_t const alignment,
+                                      std::size_t const size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (size >= huge_page_threshold()) {
+    auto const huge_size = to_next_multiple(size, HUGE_PAGE_SIZE);
+    auto const p = CISTA_SYSTEM_ALIGNED_ALLOC(HUGE_PAGE_SIZE, huge_size);
+    if (p != nullptr) {
+      ::madvise(p, huge_size, MADV_HUGEPAGE);  // Only a hint.
+    }
+    return p;
+  }
+#endif
+  return CISTA_SYSTEM_ALIGNED_ALLOC(alignment, size);
+}
+
+// Same for memory released with std::free (vector, buffer). huge_pages
+// forces huge pages below the threshold. alignment > 0: aligned (and sized)
+// to a multiple of alignment. Windows: std::malloc, no hints.
+inline void* malloc_with_hints(std::size_t const size,
+                               std::size_t const alignment = 0U,
+                               bool const huge_pages = false) {
+#ifdef _WIN32
+  CISTA_UNUSED_PARAM(alignment)
+  CISTA_UNUSED_PARAM(huge_pages)
+#else
+  if (huge_pages || size >= huge_page_threshold()) {
+    auto const huge_size = to_next_multiple(size, HUGE_PAGE_SIZE);
+    auto const p = std::aligned_alloc(HUGE_PAGE_SIZE, huge_size);
+#ifdef MADV_HUGEPAGE
+    if (p != nullptr) {
+      ::madvise(p, huge_size, MADV_HUGEPAGE);  // Only a hint.
+    }
+#endif
+    return p;
+  }
+  if (alignment != 0U) {
+    return std::aligned_alloc(alignment, to_next_multiple(size, alignment));
+  }
+#endif
+  return std::malloc(size);  // NOLINT
+}
+
+}  // namespace cista
+
+#define CISTA_ALIGNED_ALLOC(alignment, size) \
+  (::cista::aligned_alloc_with_hints((alignment), (size)))
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "cista/aligned_alloc.h"
+#include "cista/exception.h"
+
+namespace cista {
+
+// Bump allocator for building data in one contiguous region. While an
+// arena_scope is active, the containers (vector, string, hash_map / set,
+// unique_ptr via make_unique) allocate from the arena instead of the heap.
+// Arena memory is not owned by the containers (self_allocated_ is false):
+// nothing is freed individually, memory given up by a container (e.g. on
+// vector growth) stays unused until the arena is destroyed. Destructors of
+// objects in the arena are not called.
+//
+// Offset containers built in an arena - with the root as the first object -
+// form a valid image: see serialize_arena(), read it with mode::ARENA. Data
+// allocated outside of the scope (modifications after leaving it, heap
+// containers moved in) is not part of the arena: such images fail the
+// checks of deserialize().
+struct arena {
+  static constexpr auto const ALIGNMENT = std::size_t{64U};
+
+  // Reserves capacity bytes (only touched pages use physical memory).
+  explicit arena(std::size_t const capacity)
+      : mem_{static_cast<std::uint8_t*>(CISTA_ALIGNED_ALLOC(
+            ALIGNMENT, to_next_multiple(capacity, ALIGNMENT)))},
+        capacity_{capacity},
+        owning_{true} {
+    if (mem_ == nullptr) {
+      throw_exception(std::bad_alloc{});
+    }
+  }
+
+  // Uses memory provided by the caller (e.g. a mapped file).
+  arena(std::uint8_t* mem, std::size_t const capacity) noexcept
+      : mem_{mem}, capacity_{capacity}, owning_{false} {}
+
+  arena(arena const&) = delete;
+  arena(arena&&) = delete;
+  arena& operator=(arena const&) = delete;
+  arena& operator=(arena&&) = delete;
+
+  ~arena() {
+    if (owning_) {
+      CISTA_ALIGNED_FREE(ALIGNMENT, mem_);
+    }
+  }
+
+  void* allocate(std::size_t const size, std::size_t const alignment) {
+    auto const mem = try_allocate(size, alignment);
+    if (mem == nullptr) {
+      throw_exception(std::bad_alloc{});
+    }
+    return mem;
+  }
+
+  // nullptr if the arena is full.
+  void* try_allocate(std::size_t const size,
+                     std::size_t const alignment) noexcept {
+    auto const a = alignment == 0U ? std::size_t{1U} : alignment;
+    auto const start = to_next_multiple(used_, a);
+    if (start > capacity_ || size > capacity_ - start) {
+      return nullptr;
+    }
+    used_ = start + size;
+    max_alignment_ = std::max(max_alignment_, a);
+#if defined(CISTA_ZERO_OUT)
+    std::memset(mem_ + start, 0, size);
+#endif
+    return mem_ + start;
+  }
+
+  // Constructs a T in the arena, allocating its contents from the arena.
+  template <typename T, typename... Args>
+  T* create(Args&&... args);
+
+  // Shared copy of a constant (the control bytes of empty hash maps):
+  // pointers to it have to stay within the arena. nullptr if full.
+  void* empty_group(void const* src, std::size_t const size,
+                    std::size_t const alignment) noexcept {
+    if (empty_group_ == nullptr) {
+      empty_group_ = try_allocate(size, alignment);
+      if (empty_group_ != nullptr) {
+        std::memcpy(empty_group_, src, size);
+      }
+    }
+    return empty_group_;
+  }
+
+  bool contains(void const* p) const noexcept {
+    auto const b = static_cast<std::uint8_t const*>(p);
+    return b >= mem_ && b < mem_ + used_;
+  }
+
+  std::uint8_t* data() const noexcept { return mem_; }
+  std::size_t size() const noexcept { return used_; }
+  std::size_t capacity() const noexcept { return capacity_; }
+  std::size_t max_alignment() const noexcept { return max_alignment_; }
+
+  std::uint8_t* mem_;
+  std::size_t capacity_;
+  std::size_t used_{0U};
+  std::size_t max_alignment_{1U};
+  void* empty_group_{nullptr};
+  bool owning_;
+};
+
+namespace detail {
+inline thread_local arena* active_arena = nullptr;
+}  // namespace detail
+
+inline arena* active_arena() noexcept { return detail::active_arena; }
+
+// Makes the arena the allocation target of the containers on this thread.
+struct arena_scope {
+  explicit arena_scope(arena& a) noexcept : prev_{detail::active_arena} {
+    detail::active_arena = &a;
+  }
+
+  arena_scope(arena_scope const&) = delete;
+  arena_scope& operator=(arena_scope const&) = delete;
+
+  ~arena_scope() { detail::active_arena = prev_; }
+
+  arena* prev_;
+};
+
+template <typename T, typename... Args>
+T* arena::create(Args&&... args) {
+  auto const scope = arena_scope{*this};
+  return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+}
+
+// Container memory: from the active arena (not owned), else from fallback().
+struct allocation {
+  void* ptr_;
+  bool owned_;
+};
+
+template <typename Fallback>
+allocation allocate(std::size_t const size, std::size_t const alignment,
+                    Fallback&& fallback) {
+  if (auto const a = active_arena(); a != nullptr) {
+    return {a->allocate(size, alignment), false};
+  }
+  auto const ptr = fallback();
+  if (ptr == nullptr) {
+    throw_exception(std::bad_alloc{});
+  }
+  return {ptr, true};
+}
+
+}  // namespace cista
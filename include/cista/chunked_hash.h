@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cista/chunk.h"
+#include "cista/crc32c.h"
+#include "cista/endian/conversion.h"
+#include "cista/hash.h"
+#include "cista/parallel_for.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Hash chained over fixed size chunks: h = hash(chunk_n, ... hash(chunk_0)).
+// Can be computed incrementally (streaming writer, file target) and over
+// contiguous memory (buffer, reader) with the same result.
+constexpr auto const HASH_CHUNK_SIZE = 512U * 1024U;  // 512kB
+
+inline hash_t chunked_hash(std::string_view s, hash_t h = BASE_HASH) {
+  chunk(HASH_CHUNK_SIZE, s.size(), [&](std::size_t const from, unsigned size) {
+    h = hash(s.substr(from, size), h);
+  });
+  return h;
+}
+
+// Hash functions for integrity checksums, recorded in the image header
+// (mode::WITH_CHUNKED_INTEGRITY). Independent of the CISTA_HASH used for
+// containers and type hashes. CISTA_HASH images can only be checked by
+// builds using the same CISTA_HASH.
+enum class integrity_hash : std::uint64_t { CISTA_HASH = 0U, CRC32C = 1U };
+
+#ifndef CISTA_INTEGRITY_HASH
+#define CISTA_INTEGRITY_HASH ::cista::integrity_hash::CRC32C
+#endif
+
+constexpr integrity_hash const DEFAULT_INTEGRITY_HASH = CISTA_INTEGRITY_HASH;
+
+inline hash_t integrity_hash_of(integrity_hash const algo,
+                                std::string_view s) {
+  if (algo == integrity_hash::CRC32C) {
+    return crc32c(s);
+  }
+  verify(algo == integrity_hash::CISTA_HASH, "unknown integrity hash");
+  return hash(s);
+}
+
+// List hash: chunks of HASH_CHUNK_SIZE are hashed independently, the result
+// is the hash over the chunk hashes (little endian). The chunks can be
+// hashed in any order and in parallel.
+inline hash_t combine_chunk_hashes(integrity_hash const algo,
+                                   std::vector<hash_t>& chunk_hashes) {
+  for (auto& h : chunk_hashes) {
+    h = convert_endian<mode::NONE>(h);
+  }
+  return integrity_hash_of(
+      algo, std::string_view{reinterpret_cast<char const*>(chunk_hashes.data()),
+                             chunk_hashes.size() * sizeof(hash_t)});
+}
+
+inline hash_t chunk_list_hash(
+    std::string_view s, integrity_hash const algo = DEFAULT_INTEGRITY_HASH,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  auto const n_chunks = (s.size() + HASH_CHUNK_SIZE - 1U) / HASH_CHUNK_SIZE;
+  auto chunk_hashes = std::vector<hash_t>(n_chunks);
+  parallel_for(n_chunks, n_threads, [&](std::size_t const i) {
+    chunk_hashes[i] =
+        integrity_hash_of(algo, s.substr(i * HASH_CHUNK_SIZE, HASH_CHUNK_SIZE));
+  });
+
+  return combine_chunk_hashes(algo, chunk_hashes);
+}
+
+// Computes chunk_list_hash() over the data while it is written, so it does
+// not have to be read again. Complete chunks are hashed from a staging copy.
+// Chunks patched after they were hashed are marked dirty and hashed again
+// from the target in finish().
+struct incremental_chunk_list_hash {
+  static constexpr auto const CHUNK_SIZE = std::size_t{HASH_CHUNK_SIZE};
+
+  explicit incremental_chunk_list_hash(std::size_t const start,
+                                       integrity_hash const algo)
+      : algo_{algo}, start_{start}, end_{start} {
+    staging_.reserve(CHUNK_SIZE);
+  }
+
+  // Data written at pos (>= end of the previous write, the gap is zeros).
+  void append(std::size_t const pos, void const* data, std::size_t const size) {
+    verify(pos >= end_, "incremental checksum: write out of order");
+    feed(nullptr, pos - end_);
+    feed(static_cast<std::uint8_t const*>(data), size);
+    end_ = pos + size;
+  }
+
+  // Data overwritten at [pos, pos + size).
+  void patch(std::size_t pos, void const* data, std::size_t size) {
+    auto src = static_cast<std::uint8_t const*>(data);
+    if (pos < start_) {
+      auto const skip = std::min(size, start_ - pos);
+      pos += skip;
+      src += skip;
+      size -= skip;
+    }
+    verify(pos + size <= end_, "incremental checksum: patch out of bounds");
+    for (; size != 0U;) {
+      auto const chunk_idx = (pos - start_) / CHUNK_SIZE;
+      auto const chunk_offset = (pos - start_) % CHUNK_SIZE;
+      auto const n = std::min(size, CHUNK_SIZE - chunk_offset);
+      if (chunk_idx < chunk_hashes_.size()) {
+        dirty_.emplace_back(chunk_idx);
+      } else {
+        std::memcpy(&staging_[chunk_offset], src, n);
+      }
+      pos += n;
+      src += n;
+      size -= n;
+    }
+  }
+
+  // hash_range(pos, size) has to hash the final data of the given range.
+  template <typename HashRangeFn>
+  hash_t finish(HashRangeFn&& hash_range) {
+    if (!staging_.empty()) {
+      hash_staging();
+    }
+    std::sort(begin(dirty_), end(dirty_));
+    dirty_.erase(std::unique(begin(dirty_), end(dirty_)), end(dirty_));
+    for (auto const chunk_idx : dirty_) {
+      auto const pos = start_ + chunk_idx * CHUNK_SIZE;
+      chunk_hashes_[chunk_idx] =
+          hash_range(pos, std::min(CHUNK_SIZE, end_ - pos));
+    }
+    return combine_chunk_hashes(algo_, chunk_hashes_);
+  }
+
+private:
+  void feed(std::uint8_t const* data, std::size_t size) {
+    for (; size != 0U;) {
+      auto const n = std::min(size, CHUNK_SIZE - staging_.size());
+      if (data == nullptr) {
+        staging_.resize(staging_.size() + n);
+      } else {
+        staging_.insert(end(staging_), data, data + n);
+        data += n;
+      }
+      size -= n;
+      if (staging_.size() == CHUNK_SIZE) {
+        hash_staging();
+      }
+    }
+  }
+
+  void hash_staging() {
+    chunk_hashes_.emplace_back(integrity_hash_of(
+        algo_, std::string_view{reinterpret_cast<char const*>(staging_.data()),
+                                staging_.size()}));
+    staging_.clear();
+  }
+
+  integrity_hash algo_{integrity_hash::CISTA_HASH};
+  std::size_t start_{0U}, end_{0U};
+  std::vector<std::uint8_t> staging_;
+  std::vector<hash_t> chunk_hashes_;
+  std::vector<std::size_t> dirty_;
+};
+
+}  // namespace cista
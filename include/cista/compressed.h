@@ -0,0 +1,571 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "cista/chunked_hash.h"
+#include "cista/containers/array.h"
+#include "cista/containers/offset_ptr.h"
+#include "cista/containers/string.h"
+#include "cista/containers/unique_ptr.h"
+#include "cista/containers/vector.h"
+#include "cista/endian/conversion.h"
+#include "cista/mode.h"
+#include "cista/parallel_for.h"
+#include "cista/reflection/to_tuple.h"
+#include "cista/serialization.h"
+#include "cista/targets/buf.h"
+#include "cista/lz.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Block compressed image: the image is split into blocks of a fixed size,
+// each compressed independently (cista/lz.h). Layout (integers little endian):
+//
+//   compressed_header
+//   compressed_block[n_blocks]   position of the compressed data,
+//                                integrity hash of the uncompressed block
+//   compressed data              blocks that do not compress are stored
+//
+// compressed_image decompresses blocks on demand into a bounded cache and
+// checks each block hash on decompression. compressed_view gives random
+// access to offset containers in the image without decompressing it.
+constexpr auto const COMPRESSED_MAGIC = std::uint64_t{0x425A4C4154534943ULL};
+constexpr auto const COMPRESSED_VERSION = std::uint64_t{1U};
+constexpr auto const DEFAULT_BLOCK_SIZE = std::size_t{64U * 1024U};
+constexpr auto const MAX_BLOCK_SIZE = std::size_t{16U * 1024U * 1024U};
+
+struct compressed_header {
+  std::uint64_t magic_, version_, size_, block_size_, n_blocks_,
+      integrity_algo_;
+};
+
+struct compressed_block {
+  std::uint64_t offset_, size_, hash_;
+};
+
+inline void convert_compressed_endian(compressed_header& h) noexcept {
+  for (auto f : {&h.magic_, &h.version_, &h.size_, &h.block_size_,
+                 &h.n_blocks_, &h.integrity_algo_}) {
+    *f = convert_endian<mode::NONE>(*f);
+  }
+}
+
+inline void convert_compressed_endian(compressed_block& b) noexcept {
+  for (auto f : {&b.offset_, &b.size_, &b.hash_}) {
+    *f = convert_endian<mode::NONE>(*f);
+  }
+}
+
+// Blocks are compressed in parallel with n_threads threads.
+inline byte_buf compress(
+    std::uint8_t const* data, std::size_t const size,
+    std::size_t const block_size = DEFAULT_BLOCK_SIZE,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  verify(block_size != 0U && block_size <= MAX_BLOCK_SIZE,
+         "compress: invalid block size");
+
+  auto const algo = DEFAULT_INTEGRITY_HASH;
+  auto const n_blocks = (size + block_size - 1U) / block_size;
+  auto blocks = std::vector<byte_buf>(n_blocks);
+  auto hashes = std::vector<hash_t>(n_blocks);
+  parallel_for(n_blocks, n_threads, [&](std::size_t const i) {
+    auto const from = data + i * block_size;
+    auto const n = std::min(block_size, size - i * block_size);
+    hashes[i] = integrity_hash_of(
+        algo, std::string_view{reinterpret_cast<char const*>(from), n});
+    auto& b = blocks[i];
+    b.resize(lz::compress_bound(n));
+    auto const compressed = lz::compress(from, n, b.data(), b.size());
+    if (compressed != 0U && compressed < n) {
+      b.resize(compressed);
+      b.shrink_to_fit();
+    } else {
+      b.assign(from, from + n);
+    }
+  });
+
+  auto header = compressed_header{
+      COMPRESSED_MAGIC, COMPRESSED_VERSION,
+      size,             block_size,
+      n_blocks,         static_cast<std::uint64_t>(algo)};
+  convert_compressed_endian(header);
+
+  auto const table_size = n_blocks * sizeof(compressed_block);
+  auto out = byte_buf(sizeof(header) + table_size);
+  std::memcpy(out.data(), &header, sizeof(header));
+  auto offset = std::uint64_t{0U};
+  for (auto i = std::size_t{0U}; i != n_blocks; ++i) {
+    auto b = compressed_block{offset, blocks[i].size(), hashes[i]};
+    convert_compressed_endian(b);
+    std::memcpy(out.data() + sizeof(header) + i * sizeof(b), &b, sizeof(b));
+    offset += blocks[i].size();
+  }
+  out.reserve(out.size() + offset);
+  for (auto const& b : blocks) {
+    out.insert(end(out), begin(b), end(b));
+  }
+  return out;
+}
+
+template <typename Container>
+byte_buf compress(
+    Container const& c, std::size_t const block_size = DEFAULT_BLOCK_SIZE,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  return compress(reinterpret_cast<std::uint8_t const*>(c.data()), c.size(),
+                  block_size, n_threads);
+}
+
+template <mode const Mode = mode::NONE, typename T>
+byte_buf serialize_compressed(
+    T const& el, std::size_t const block_size = DEFAULT_BLOCK_SIZE,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  return compress(serialize<Mode>(el), block_size, n_threads);
+}
+
+// Reads a compressed image in place (e.g. from a read-only mapping).
+// Decompressed blocks are kept in a cache of cache_blocks blocks (least
+// recently used are evicted). Not thread safe: use one compressed_image per
+// thread, they can share the compressed data.
+struct compressed_image {
+  static constexpr auto const DEFAULT_CACHE_BLOCKS = std::size_t{64U};
+  static constexpr auto const NO_SLOT = std::numeric_limits<std::size_t>::max();
+
+  struct cache_slot {
+    std::size_t block_{NO_SLOT};
+    std::uint64_t last_use_{0U};
+    byte_buf data_;
+  };
+
+  compressed_image(std::uint8_t const* from, std::uint8_t const* to,
+                   std::size_t const cache_blocks = DEFAULT_CACHE_BLOCKS) {
+    auto const size = static_cast<std::size_t>(to - from);
+    verify(size >= sizeof(compressed_header), "compressed: invalid image");
+    auto header = compressed_header{};
+    std::memcpy(&header, from, sizeof(header));
+    convert_compressed_endian(header);
+    verify(header.magic_ == COMPRESSED_MAGIC, "compressed: invalid magic");
+    verify(header.version_ == COMPRESSED_VERSION,
+           "compressed: unknown version");
+    verify(header.block_size_ != 0U && header.block_size_ <= MAX_BLOCK_SIZE,
+           "compressed: invalid block size");
+    verify(header.n_blocks_ ==
+               header.size_ / header.block_size_ +
+                   (header.size_ % header.block_size_ == 0U ? 0U : 1U),
+           "compressed: invalid block count");
+    verify(header.n_blocks_ <=
+               (size - sizeof(header)) / sizeof(compressed_block),
+           "compressed: block table out of bounds");
+
+    size_ = header.size_;
+    block_size_ = header.block_size_;
+    algo_ = integrity_hash{header.integrity_algo_};
+    blocks_.resize(header.n_blocks_);
+    if (!blocks_.empty()) {
+      std::memcpy(blocks_.data(), from + sizeof(header),
+                  blocks_.size() * sizeof(compressed_block));
+    }
+    data_ = from + sizeof(header) + blocks_.size() * sizeof(compressed_block);
+    // Blocks are stored in order. A block is either stored as is or
+    // compressed to fewer bytes that can expand to its length: this bounds
+    // the decompressed size (allocated by block() and decompress()) by the
+    // size of the image.
+    auto const data_size = static_cast<std::size_t>(to - data_);
+    auto offset = std::size_t{0U};
+    for (auto i = std::size_t{0U}; i != blocks_.size(); ++i) {
+      auto& b = blocks_[i];
+      convert_compressed_endian(b);
+      verify(b.offset_ == offset && b.size_ <= data_size - offset,
+             "compressed: block out of bounds");
+      auto const length = block_length(i);
+      verify(b.size_ == length ||
+                 (b.size_ < length && length <= lz::decompress_bound(b.size_)),
+             "compressed: invalid block size");
+      offset += static_cast<std::size_t>(b.size_);
+    }
+
+    cache_.resize(std::max(cache_blocks, std::size_t{1U}));
+    slot_of_.resize(blocks_.size(), NO_SLOT);
+  }
+
+  template <typename Container>
+  explicit compressed_image(
+      Container const& c, std::size_t const cache_blocks = DEFAULT_CACHE_BLOCKS)
+      : compressed_image{reinterpret_cast<std::uint8_t const*>(c.data()),
+                         reinterpret_cast<std::uint8_t const*>(c.data()) +
+                             c.size(),
+                         cache_blocks} {}
+
+  std::size_t size() const noexcept { return size_; }
+  std::size_t block_size() const noexcept { return block_size_; }
+  std::size_t n_blocks() const noexcept { return blocks_.size(); }
+  std::size_t n_decompressed() const noexcept { return n_decompressed_; }
+
+  std::size_t block_length(std::size_t const i) const noexcept {
+    return std::min(block_size_, size_ - i * block_size_);
+  }
+
+  // Decompressed block i: valid until the next access (may be evicted).
+  std::uint8_t const* block(std::size_t const i) const {
+    verify(i < blocks_.size(), "compressed: block out of bounds");
+    auto slot = slot_of_[i];
+    if (slot == NO_SLOT) {
+      slot = static_cast<std::size_t>(
+          std::min_element(begin(cache_), end(cache_),
+                           [](cache_slot const& a, cache_slot const& b) {
+                             return a.last_use_ < b.last_use_;
+                           }) -
+          begin(cache_));
+      auto& s = cache_[slot];
+      if (s.block_ != NO_SLOT) {
+        slot_of_[s.block_] = NO_SLOT;
+        s.block_ = NO_SLOT;
+      }
+      s.data_.resize(block_size_);
+      decompress_block(i, s.data_.data());
+      s.block_ = i;
+      slot_of_[i] = slot;
+    }
+    cache_[slot].last_use_ = ++use_count_;
+    return cache_[slot].data_.data();
+  }
+
+  void read(std::size_t pos, void* dst, std::size_t n) const {
+    verify(pos <= size_ && n <= size_ - pos, "compressed: out of bounds");
+    auto out = static_cast<std::uint8_t*>(dst);
+    while (n != 0U) {
+      auto const i = pos / block_size_;
+      auto const offset = pos % block_size_;
+      auto const length = std::min(n, block_length(i) - offset);
+      std::memcpy(out, block(i) + offset, length);
+      out += length;
+      pos += length;
+      n -= length;
+    }
+  }
+
+  template <typename T>
+  T read(std::size_t const pos) const {
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto v = T{};
+    read(pos, &v, sizeof(T));
+    return v;
+  }
+
+  // Decompresses the whole image (not cached).
+  byte_buf decompress() const {
+    auto out = byte_buf(size_);
+    for (auto i = std::size_t{0U}; i != blocks_.size(); ++i) {
+      decompress_block(i, out.data() + i * block_size_);
+    }
+    return out;
+  }
+
+  void decompress_block(std::size_t const i, std::uint8_t* dst) const {
+    auto const& b = blocks_[i];
+    auto const length = block_length(i);
+    auto const src = data_ + b.offset_;
+    if (b.size_ == length) {
+      std::memcpy(dst, src, length);
+    } else {
+      verify(lz::decompress(src, b.size_, dst, length) == length,
+             "compressed: corrupt block");
+    }
+    verify(integrity_hash_of(algo_,
+                             std::string_view{reinterpret_cast<char*>(dst),
+                                              length}) == b.hash_,
+           "compressed: invalid block checksum");
+    ++n_decompressed_;
+  }
+
+  std::size_t size_{0U}, block_size_{0U};
+  integrity_hash algo_{DEFAULT_INTEGRITY_HASH};
+  std::vector<compressed_block> blocks_;
+  std::uint8_t const* data_{nullptr};
+
+  std::vector<cache_slot> mutable cache_;
+  std::vector<std::size_t> mutable slot_of_;
+  std::uint64_t mutable use_count_{0U};
+  std::size_t mutable n_decompressed_{0U};
+};
+
+template <typename Container>
+byte_buf decompress(Container const& c) {
+  return compressed_image{c, 1U}.decompress();
+}
+
+// Storage with the layout of T that is never read: addresses of its members
+// give the member offsets.
+template <typename T>
+T const& layout_probe() noexcept {
+  alignas(T) static std::uint8_t const probe[sizeof(T)] = {};
+  return *reinterpret_cast<T const*>(probe);
+}
+
+template <typename T, typename Member>
+std::size_t layout_offset(T const& probe, Member const& member) noexcept {
+  return static_cast<std::size_t>(
+      reinterpret_cast<std::uint8_t const*>(&member) -
+      reinterpret_cast<std::uint8_t const*>(&probe));
+}
+
+constexpr auto const COMPRESSED_NULLPTR =
+    std::numeric_limits<std::size_t>::max();
+
+// Target position of the offset_ptr at pos, COMPRESSED_NULLPTR for nullptr.
+template <mode Mode>
+std::size_t compressed_target(compressed_image const& img,
+                              std::size_t const pos) {
+  auto const offset = convert_endian<Mode>(img.read<offset_t>(pos));
+  return offset == NULLPTR_OFFSET
+             ? COMPRESSED_NULLPTR
+             : pos + static_cast<std::size_t>(offset);  // wraps for offset<0
+}
+
+// Random access to offset containers in a compressed image, with the same
+// interface as endian_view: values are read (copied) from the decompressed
+// blocks and converted to the host byte order. All reads are bounds
+// checked, the data itself is not validated.
+template <typename T, mode Mode = mode::NONE>
+struct compressed_view {
+  using value_type = T;
+
+  // Scalars: the value in host byte order.
+  T get() const {
+    static_assert(std::is_scalar_v<T>, "use get(&T::member) or get<I>()");
+    auto const v = img_->read<T>(pos_);
+    if constexpr (std::numeric_limits<T>::is_integer) {
+      return convert_endian<Mode>(v);
+    } else {
+      return v;
+    }
+  }
+
+  operator T() const { return get(); }
+
+  // Structs: view of a member.
+  template <typename Member, typename Class>
+  compressed_view<Member, Mode> get(
+      Member Class::*const member) const noexcept {
+    static_assert(std::is_base_of_v<Class, T>);
+    auto const& probe = layout_probe<T>();
+    return {img_, pos_ + layout_offset(probe, probe.*member)};
+  }
+
+  template <std::size_t I>
+  auto get() const noexcept {
+    auto const& probe = layout_probe<T>();
+    auto const& member = std::get<I>(to_tuple(probe));
+    return compressed_view<decay_t<decltype(member)>, Mode>{
+        img_, pos_ + layout_offset(probe, member)};
+  }
+
+  compressed_image const* img_;
+  std::size_t pos_;
+};
+
+template <typename T, mode Mode>
+struct compressed_view<offset_ptr<T>, Mode> {
+  using value_type = T;
+
+  std::size_t target() const { return compressed_target<Mode>(*img_, pos_); }
+  explicit operator bool() const { return target() != COMPRESSED_NULLPTR; }
+  compressed_view<T, Mode> operator*() const {
+    auto const pos = target();
+    verify(pos != COMPRESSED_NULLPTR, "compressed_view: nullptr");
+    return {img_, pos};
+  }
+
+  compressed_image const* img_;
+  std::size_t pos_;
+};
+
+template <typename T, mode Mode>
+struct compressed_view<basic_unique_ptr<T, offset_ptr<T>>, Mode>
+    : public compressed_view<offset_ptr<T>, Mode> {
+  using unique_ptr_t = basic_unique_ptr<T, offset_ptr<T>>;
+
+  compressed_view(compressed_image const* img, std::size_t const pos) noexcept
+      : compressed_view<offset_ptr<T>, Mode>{
+            img, pos + layout_offset(layout_probe<unique_ptr_t>(),
+                                     layout_probe<unique_ptr_t>().el_)} {}
+};
+
+// Random access to a contiguous range of serialized elements.
+template <typename T, mode Mode>
+struct compressed_range_view {
+  struct iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = compressed_view<T, Mode>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type*;
+    using reference = value_type;
+
+    value_type operator*() const noexcept { return {img_, pos_}; }
+    iterator& operator++() noexcept {
+      pos_ += sizeof(T);
+      return *this;
+    }
+    iterator operator++(int) noexcept {
+      auto const tmp = *this;
+      pos_ += sizeof(T);
+      return tmp;
+    }
+    friend bool operator==(iterator const a, iterator const b) noexcept {
+      return a.pos_ == b.pos_;
+    }
+    friend bool operator!=(iterator const a, iterator const b) noexcept {
+      return a.pos_ != b.pos_;
+    }
+
+    compressed_image const* img_;
+    std::size_t pos_;
+  };
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0U; }
+
+  compressed_view<T, Mode> operator[](std::size_t const i) const noexcept {
+    return {img_, pos_ + i * sizeof(T)};
+  }
+
+  compressed_view<T, Mode> at(std::size_t const i) const {
+    verify(i < size_, "compressed_view: out of bounds");
+    return (*this)[i];
+  }
+
+  iterator begin() const noexcept { return {img_, pos_}; }
+  iterator end() const noexcept { return {img_, pos_ + size_ * sizeof(T)}; }
+  friend iterator begin(compressed_range_view const& v) noexcept {
+    return v.begin();
+  }
+  friend iterator end(compressed_range_view const& v) noexcept {
+    return v.end();
+  }
+
+  compressed_image const* img_;
+  std::size_t pos_;
+  std::size_t size_;
+};
+
+template <typename T, bool Indexed, typename TemplateSizeType, mode Mode>
+struct compressed_view<basic_vector<T, offset::ptr, Indexed, TemplateSizeType>,
+                       Mode> : public compressed_range_view<T, Mode> {
+  using value_type = T;
+  using vector_t = basic_vector<T, offset::ptr, Indexed, TemplateSizeType>;
+
+  compressed_view(compressed_image const* img, std::size_t const pos)
+      : compressed_range_view<T, Mode>{img, 0U, 0U} {
+    auto const& probe = layout_probe<vector_t>();
+    this->size_ = static_cast<std::size_t>(
+        convert_endian<Mode>(img->read<TemplateSizeType>(
+            pos + layout_offset(probe, probe.used_size_))));
+    this->pos_ =
+        compressed_target<Mode>(*img, pos + layout_offset(probe, probe.el_));
+    verify(this->size_ == 0U || this->pos_ != COMPRESSED_NULLPTR,
+           "compressed_view: invalid vector");
+  }
+};
+
+template <typename T, std::size_t Size, mode Mode>
+struct compressed_view<array<T, Size>, Mode>
+    : public compressed_range_view<T, Mode> {
+  using value_type = T;
+
+  compressed_view(compressed_image const* img, std::size_t const pos) noexcept
+      : compressed_range_view<T, Mode>{img, pos, Size} {}
+};
+
+template <typename Ptr, mode Mode>
+struct compressed_view<generic_string<Ptr>, Mode> {
+  using string_t = generic_string<Ptr>;
+  using CharT = typename string_t::CharT;
+  static_assert(!std::is_pointer_v<Ptr>, "offset strings only");
+
+  compressed_view(compressed_image const* img, std::size_t const pos)
+      : img_{img} {
+    auto const& probe = layout_probe<string_t>();
+    if (img->read<std::uint8_t>(pos + layout_offset(probe, probe.s_)) != 0U) {
+      CharT s[string_t::short_length_limit];
+      pos_ = pos + layout_offset(probe, probe.s_.s_);
+      img->read(pos_, s, sizeof(s));
+      auto const end = std::char_traits<CharT>::find(
+          s, string_t::short_length_limit, CharT{0});
+      size_ = end == nullptr ? string_t::short_length_limit
+                             : static_cast<std::size_t>(end - s);
+    } else {
+      pos_ = compressed_target<Mode>(
+          *img, pos + layout_offset(probe, probe.h_.ptr_));
+      size_ = convert_endian<Mode>(img->read<std::uint32_t>(
+          pos + layout_offset(probe, probe.h_.size_)));
+      verify(size_ == 0U || pos_ != COMPRESSED_NULLPTR,
+             "compressed_view: invalid string");
+    }
+  }
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0U; }
+
+  CharT operator[](std::size_t const i) const {
+    return compressed_view<CharT, Mode>{img_, pos_ + i * sizeof(CharT)};
+  }
+
+  std::basic_string<CharT> str() const {
+    auto s = std::basic_string<CharT>(size_, CharT{0});
+    if (size_ != 0U) {
+      img_->read(pos_, s.data(), size_ * sizeof(CharT));
+    }
+    if constexpr (sizeof(CharT) != 1U && endian_conversion_necessary<Mode>()) {
+      endian_swap_n(s.data(), s.size());
+    }
+    return s;
+  }
+
+  compressed_image const* img_;
+  std::size_t pos_;
+  std::size_t size_;
+};
+
+template <typename Ptr, mode Mode>
+struct compressed_view<basic_string<Ptr>, Mode>
+    : public compressed_view<generic_string<Ptr>, Mode> {
+  compressed_view(compressed_image const* img, std::size_t const pos)
+      : compressed_view<generic_string<Ptr>, Mode>{img, pos} {}
+};
+
+template <typename Ptr, mode Mode>
+struct compressed_view<basic_string_view<Ptr>, Mode>
+    : public compressed_view<generic_string<Ptr>, Mode> {
+  compressed_view(compressed_image const* img, std::size_t const pos)
+      : compressed_view<generic_string<Ptr>, Mode>{img, pos} {}
+};
+
+// Checks the version header and returns a view of the root element. Only the
+// blocks that are accessed get decompressed. Image integrity hashes are not
+// checked: every block is checked against its own hash when decompressed.
+template <typename T, mode const Mode = mode::NONE>
+compressed_view<T, Mode> view_compressed(compressed_image const& img) {
+  static_assert(is_mode_disabled(Mode, mode::CAST));
+  verify(img.size() > data_start(Mode) + trailer_size(Mode), "invalid range");
+  if constexpr (is_mode_enabled(Mode, mode::WITH_VERSION)) {
+    verify(convert_endian<Mode>(img.read<hash_t>(0U)) == type_hash<T>(),
+           "invalid version");
+  } else if constexpr (is_mode_enabled(Mode, mode::WITH_STATIC_VERSION)) {
+    verify(convert_endian<Mode>(img.read<hash_t>(0U)) ==
+               static_type_hash<T>(),
+           "invalid static version");
+  }
+  return compressed_view<T, Mode>{&img, data_start(Mode)};
+}
+
+}  // namespace cista
@@ -9,6 +9,7 @@
 #include <type_traits>
 
 #include "cista/aligned_alloc.h"
+#include "cista/arena.h"
 #include "cista/bit_counting.h"
 #include "cista/containers/ptr.h"
 #include "cista/decay.h"
@@ -227,6 +228,13 @@ struct hash_storage {
     alignas(16) static constexpr ctrl_t empty_group[] = {
         END,   EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
         EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY};
+    if (auto const a = active_arena(); a != nullptr) {
+      if (auto const g = a->empty_group(empty_group, sizeof(empty_group),
+                                        alignof(ctrl_t));
+          g != nullptr) {
+        return static_cast<ctrl_t*>(g);
+      }
+    }
     return const_cast<ctrl_t*>(empty_group);
   }
 
@@ -590,14 +598,14 @@ struct hash_storage {
   }
 
   void initialize_entries() {
-    self_allocated_ = true;
     auto const size = static_cast<size_type>(
         capacity_ * sizeof(T) + (capacity_ + 1U + WIDTH) * sizeof(ctrl_t));
-    entries_ = reinterpret_cast<T*>(
-        CISTA_ALIGNED_ALLOC(ALIGNMENT, static_cast<std::size_t>(size)));
-    if (entries_ == nullptr) {
-      throw_exception(std::bad_alloc{});
-    }
+    auto const mem =
+        ::cista::allocate(static_cast<std::size_t>(size), ALIGNMENT, [&]() {
+          return CISTA_ALIGNED_ALLOC(ALIGNMENT, static_cast<std::size_t>(size));
+        });
+    entries_ = reinterpret_cast<T*>(mem.ptr_);
+    self_allocated_ = mem.owned_;
 #if defined(CISTA_ZERO_OUT)
     std::memset(entries_, 0, size);
 #endif
@@ -30,6 +30,7 @@ struct basic_mmap_vec {
     ++used_size_;
     mmap_.resize(sizeof(T) * used_size_);
     (*this)[Key{used_size_ - 1U}] = t;
+    mark_dirty_from(used_size_ - 1U);
   }
 
   template <typename... Args>
@@ -38,6 +39,7 @@ struct basic_mmap_vec {
     new (data() + used_size_) T{std::forward<Args>(el)...};
     T* ptr = data() + used_size_;
     ++used_size_;
+    mark_dirty_from(used_size_ - 1U);
     return *ptr;
   }
 
@@ -74,17 +76,44 @@ struct basic_mmap_vec {
 
   void reserve(size_type const size) { mmap_.resize(size * sizeof(T)); }
 
+  // Appends are tracked automatically, elements written through
+  // operator[] / data() have to be marked to be picked up by sync_dirty().
+  void mark_dirty(access_type const from, size_type const n = 1U) {
+    mmap_.mark_dirty(byte_offset(from),
+                     static_cast<std::size_t>(n) * sizeof(T));
+  }
+
+  void sync(access_type const from, size_type const n,
+            bool const async = false) {
+    mmap_.sync(byte_offset(from), static_cast<std::size_t>(n) * sizeof(T),
+               async);
+  }
+
+  std::size_t sync_dirty(bool const async = false) {
+    return mmap_.sync_dirty(async);
+  }
+
+  void sync(bool const async = false) { mmap_.sync(async); }
+
   void resize(size_type const size) {
     mmap_.resize(size * sizeof(T));
     for (auto i = used_size_; i < size; ++i) {
       new (data() + i) T{};
     }
+    auto const old_size = used_size_;
     used_size_ = size;
+    if (size > old_size) {
+      mark_dirty_from(old_size);
+    }
   }
 
   void resize_uninitialized(size_type const size) {
     mmap_.resize(size * sizeof(T));
+    auto const old_size = used_size_;
     used_size_ = size;
+    if (size > old_size) {
+      mark_dirty_from(old_size);
+    }
   }
 
   template <typename It>
@@ -107,6 +136,7 @@ struct basic_mmap_vec {
     }
 
     used_size_ = static_cast<size_type>(range_size);
+    mmap_.mark_dirty(0U, static_cast<std::size_t>(used_size_) * sizeof(T));
   }
 
   template <typename Arg>
@@ -118,6 +148,7 @@ struct basic_mmap_vec {
     new (data() + used_size_) T{std::forward<Arg&&>(el)};
     ++used_size_;
 
+    mark_dirty_from(old_offset);
     return std::rotate(begin() + old_offset, begin() + old_size, end());
   }
 
@@ -132,6 +163,7 @@ struct basic_mmap_vec {
       ++used_size_;
     }
 
+    mark_dirty_from(old_offset);
     return std::rotate(begin() + old_offset, begin() + old_size, end());
   }
 
@@ -166,6 +198,7 @@ struct basic_mmap_vec {
 
     used_size_ += new_count;
 
+    mark_dirty_from(pos_idx);
     return pos;
   }
 
@@ -175,6 +208,18 @@ struct basic_mmap_vec {
                   typename std::iterator_traits<It>::iterator_category());
   }
 
+  static std::size_t byte_offset(access_type const i) {
+    return static_cast<std::size_t>(to_idx(i)) * sizeof(T);
+  }
+
+  // Appends are marked here and not by mmap::resize(): after reserve(),
+  // the mapping's size already covers them.
+  void mark_dirty_from(std::ptrdiff_t const offset) {
+    auto const from = static_cast<std::size_t>(offset) * sizeof(T);
+    mmap_.mark_dirty(from, static_cast<std::size_t>(used_size_) * sizeof(T) -
+                               from);
+  }
+
   cista::mmap mmap_;
   size_type used_size_{0U};
 };
@@ -7,6 +7,7 @@
 #include <string>
 #include <string_view>
 
+#include "cista/arena.h"
 #include "cista/containers/ptr.h"
 #include "cista/exception.h"
 #include "cista/type_traits.h"
@@ -107,12 +108,12 @@ struct generic_string {
         s_.s_[i] = 0;
       }
     } else {
-      h_.ptr_ = static_cast<CharT*>(std::malloc(len * sizeof(CharT)));
-      if (h_.ptr_ == nullptr) {
-        throw_exception(std::bad_alloc{});
-      }
+      auto const mem = ::cista::allocate(
+          len * sizeof(CharT), alignof(CharT),
+          [&]() { return std::malloc(len * sizeof(CharT)); });
+      h_.ptr_ = static_cast<CharT*>(mem.ptr_);
       h_.size_ = len;
-      h_.self_allocated_ = true;
+      h_.self_allocated_ = mem.owned_;
       std::memcpy(data(), str, len * sizeof(CharT));
     }
   }
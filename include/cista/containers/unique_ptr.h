@@ -5,6 +5,7 @@
 
 #include <utility>
 
+#include "cista/arena.h"
 #include "cista/containers/ptr.h"
 
 namespace cista {
@@ -87,6 +88,9 @@ using unique_ptr = basic_unique_ptr<T, ptr<T>>;
 
 template <typename T, typename... Args>
 unique_ptr<T> make_unique(Args&&... args) {
+  if (auto const a = active_arena(); a != nullptr) {
+    return unique_ptr<T>{a->create<T>(std::forward<Args>(args)...), false};
+  }
   return unique_ptr<T>{new T{std::forward<Args>(args)...}, true};
 }
 
@@ -99,6 +103,9 @@ using unique_ptr = basic_unique_ptr<T, ptr<T>>;
 
 template <typename T, typename... Args>
 unique_ptr<T> make_unique(Args&&... args) {
+  if (auto const a = active_arena(); a != nullptr) {
+    return unique_ptr<T>{a->create<T>(std::forward<Args>(args)...), false};
+  }
   return unique_ptr<T>{new T{std::forward<Args>(args)...}, true};
 }
 
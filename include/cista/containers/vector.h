@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "cista/allocator.h"
+#include "cista/arena.h"
 #include "cista/containers/ptr.h"
 #include "cista/exception.h"
 #include "cista/is_iterable.h"
@@ -358,10 +359,10 @@ struct basic_vector {
 
     auto next_size = next_power_of_two(new_size);
     auto num_bytes = static_cast<std::size_t>(next_size) * sizeof(T);
-    auto mem_buf = static_cast<T*>(std::malloc(num_bytes));  // NOLINT
-    if (mem_buf == nullptr) {
-      throw_exception(std::bad_alloc());
-    }
+    auto const mem = ::cista::allocate(num_bytes, alignof(T), [&]() {
+      return ::cista::malloc_with_hints(num_bytes);
+    });
+    auto mem_buf = static_cast<T*>(mem.ptr_);
 
     if (size() != 0) {
       try {
@@ -384,7 +385,7 @@ struct basic_vector {
       std::free(free_me);  // NOLINT
     }
 
-    self_allocated_ = true;
+    self_allocated_ = mem.owned_;
     allocated_size_ = next_size;
   }
 
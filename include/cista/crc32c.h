@@ -0,0 +1,219 @@
+#pragma once
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <nmmintrin.h>
+#define CISTA_CRC32C_X86
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <nmmintrin.h>
+#define CISTA_CRC32C_X86
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CISTA_CRC32C_ARM
+#endif
+
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <string_view>
+
+#include "cista/endian/conversion.h"
+
+namespace cista {
+
+// CRC32C (Castagnoli): SSE4.2 / ARMv8 CRC instructions if the CPU supports
+// them, slicing-by-8 tables otherwise. All paths compute the same value.
+namespace crc32c_detail {
+
+constexpr auto const POLYNOMIAL = std::uint32_t{0x82F63B78U};  // reflected
+
+using tables_t = std::array<std::array<std::uint32_t, 256U>, 8U>;
+
+inline tables_t const& tables() {
+  static auto const t = []() {
+    auto x = tables_t{};
+    for (auto i = 0U; i != 256U; ++i) {
+      auto crc = i;
+      for (auto bit = 0U; bit != 8U; ++bit) {
+        crc = (crc >> 1U) ^ ((crc & 1U) != 0U ? POLYNOMIAL : 0U);
+      }
+      x[0U][i] = crc;
+    }
+    for (auto i = 0U; i != 256U; ++i) {
+      for (auto j = 1U; j != 8U; ++j) {
+        x[j][i] = (x[j - 1U][i] >> 8U) ^ x[0U][x[j - 1U][i] & 0xFFU];
+      }
+    }
+    return x;
+  }();
+  return t;
+}
+
+inline std::uint32_t portable(std::uint32_t crc, std::uint8_t const* data,
+                              std::size_t size) noexcept {
+  auto const& t = tables();
+  for (; size >= 8U; size -= 8U, data += 8U) {
+    auto lo = std::uint32_t{0U}, hi = std::uint32_t{0U};
+    std::memcpy(&lo, data, sizeof(lo));
+    std::memcpy(&hi, data + 4U, sizeof(hi));
+#if defined(CISTA_BIG_ENDIAN)
+    lo = endian_swap(lo);
+    hi = endian_swap(hi);
+#endif
+    lo ^= crc;
+    crc = t[7U][lo & 0xFFU] ^ t[6U][(lo >> 8U) & 0xFFU] ^
+          t[5U][(lo >> 16U) & 0xFFU] ^ t[4U][lo >> 24U] ^
+          t[3U][hi & 0xFFU] ^ t[2U][(hi >> 8U) & 0xFFU] ^
+          t[1U][(hi >> 16U) & 0xFFU] ^ t[0U][hi >> 24U];
+  }
+  for (; size != 0U; --size, ++data) {
+    crc = (crc >> 8U) ^ t[0U][(crc ^ *data) & 0xFFU];
+  }
+  return crc;
+}
+
+// Multiplication of a and b modulo the polynomial (reflected bit order).
+constexpr std::uint32_t multiply(std::uint32_t a, std::uint32_t b) noexcept {
+  auto m = std::uint32_t{1U} << 31U;
+  auto p = std::uint32_t{0U};
+  for (;;) {
+    if ((a & m) != 0U) {
+      p ^= b;
+      if ((a & (m - 1U)) == 0U) {
+        break;
+      }
+    }
+    m >>= 1U;
+    b = (b & 1U) != 0U ? (b >> 1U) ^ POLYNOMIAL : b >> 1U;
+  }
+  return p;
+}
+
+// x^(8 * n_bytes) modulo the polynomial: multiplying a CRC register with it
+// appends n_bytes zero bytes.
+constexpr std::uint32_t zeros_operator(std::size_t n_bytes) noexcept {
+  auto x2n = std::uint32_t{1U} << 30U;  // x^1
+  for (auto i = 0U; i != 3U; ++i) {  // x^8
+    x2n = multiply(x2n, x2n);
+  }
+  auto p = std::uint32_t{1U} << 31U;  // x^0
+  for (; n_bytes != 0U; n_bytes >>= 1U) {
+    if ((n_bytes & 1U) != 0U) {
+      p = multiply(x2n, p);
+    }
+    x2n = multiply(x2n, x2n);
+  }
+  return p;
+}
+
+// The hardware CRC instruction has a latency of 3 cycles but a throughput of
+// 1 per cycle: three independent streams of STREAM_SIZE bytes are computed
+// at once and combined.
+constexpr auto const STREAM_SIZE = std::size_t{4096U};
+
+#if defined(CISTA_CRC32C_X86)
+
+#if defined(_MSC_VER)
+#define CISTA_CRC32C_TARGET
+#else
+#define CISTA_CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+
+CISTA_CRC32C_TARGET inline std::uint32_t hardware(std::uint32_t crc,
+                                                  std::uint8_t const* data,
+                                                  std::size_t size) noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+  constexpr auto const shift = zeros_operator(STREAM_SIZE);
+  for (; size >= 3U * STREAM_SIZE;
+       size -= 3U * STREAM_SIZE, data += 3U * STREAM_SIZE) {
+    auto a = static_cast<std::uint64_t>(crc);
+    auto b = std::uint64_t{0U}, c = std::uint64_t{0U};
+    for (auto i = std::size_t{0U}; i != STREAM_SIZE; i += 8U) {
+      auto x = std::uint64_t{0U}, y = std::uint64_t{0U}, z = std::uint64_t{0U};
+      std::memcpy(&x, data + i, sizeof(x));
+      std::memcpy(&y, data + STREAM_SIZE + i, sizeof(y));
+      std::memcpy(&z, data + 2U * STREAM_SIZE + i, sizeof(z));
+      a = _mm_crc32_u64(a, x);
+      b = _mm_crc32_u64(b, y);
+      c = _mm_crc32_u64(c, z);
+    }
+    crc = multiply(shift, multiply(shift, static_cast<std::uint32_t>(a)) ^
+                              static_cast<std::uint32_t>(b)) ^
+          static_cast<std::uint32_t>(c);
+  }
+
+  auto crc64 = static_cast<std::uint64_t>(crc);
+  for (; size >= 8U; size -= 8U, data += 8U) {
+    auto x = std::uint64_t{0U};
+    std::memcpy(&x, data, sizeof(x));
+    crc64 = _mm_crc32_u64(crc64, x);
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+#endif
+  for (; size >= 4U; size -= 4U, data += 4U) {
+    auto x = std::uint32_t{0U};
+    std::memcpy(&x, data, sizeof(x));
+    crc = _mm_crc32_u32(crc, x);
+  }
+  for (; size != 0U; --size, ++data) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
+  return crc;
+}
+
+inline bool has_hardware() noexcept {
+  static auto const supported = []() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    unsigned eax = 0U, ebx = 0U, ecx = 0U, edx = 0U;
+    return __get_cpuid(1U, &eax, &ebx, &ecx, &edx) != 0 &&
+           (ecx & bit_SSE4_2) != 0U;
+#endif
+  }();
+  return supported;
+}
+
+#elif defined(CISTA_CRC32C_ARM)
+
+inline std::uint32_t hardware(std::uint32_t crc, std::uint8_t const* data,
+                              std::size_t size) noexcept {
+  for (; size >= 8U; size -= 8U, data += 8U) {
+    auto x = std::uint64_t{0U};
+    std::memcpy(&x, data, sizeof(x));
+    crc = __crc32cd(crc, x);
+  }
+  for (; size != 0U; --size, ++data) {
+    crc = __crc32cb(crc, *data);
+  }
+  return crc;
+}
+
+constexpr bool has_hardware() noexcept { return true; }
+
+#else
+
+inline std::uint32_t hardware(std::uint32_t crc, std::uint8_t const* data,
+                              std::size_t size) noexcept {
+  return portable(crc, data, size);
+}
+
+constexpr bool has_hardware() noexcept { return false; }
+
+#endif
+
+}  // namespace crc32c_detail
+
+inline std::uint32_t crc32c(std::string_view s,
+                            std::uint32_t const crc = 0U) noexcept {
+  auto const data = reinterpret_cast<std::uint8_t const*>(s.data());
+  return ~(crc32c_detail::has_hardware()
+               ? crc32c_detail::hardware(~crc, data, s.size())
+               : crc32c_detail::portable(~crc, data, s.size()));
+}
+
+}  // namespace cista
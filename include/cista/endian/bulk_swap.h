@@ -0,0 +1,236 @@
+#pragma once
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define CISTA_BULK_SWAP_X86
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CISTA_BULK_SWAP_X86
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <type_traits>
+
+#include "cista/endian/conversion.h"
+
+namespace cista {
+
+// Byte order conversion of contiguous runs of same-width integers:
+// byte shuffles (SSSE3 / AVX2, selected at runtime) with a scalar fallback.
+// Source and destination may be the same (in place), but must not overlap
+// otherwise.
+namespace bulk_swap_detail {
+
+template <std::size_t Width>
+void portable(std::uint8_t* dst, std::uint8_t const* src,
+              std::size_t n) noexcept {
+  using int_t = std::conditional_t<
+      Width == 2U, std::uint16_t,
+      std::conditional_t<Width == 4U, std::uint32_t, std::uint64_t>>;
+  for (auto i = std::size_t{0U}; i != n; ++i) {
+    auto x = int_t{0U};
+    std::memcpy(&x, src + i * Width, Width);
+    x = endian_swap(x);
+    std::memcpy(dst + i * Width, &x, Width);
+  }
+}
+
+// Shuffle control reversing the bytes of each Width byte element.
+template <std::size_t Width>
+constexpr std::array<std::uint8_t, 32U> shuffle_mask() noexcept {
+  auto m = std::array<std::uint8_t, 32U>{};
+  for (auto i = std::size_t{0U}; i != m.size(); ++i) {
+    auto const lane_pos = i % 16U;
+    m[i] = static_cast<std::uint8_t>((lane_pos / Width) * Width + Width - 1U -
+                                     lane_pos % Width);
+  }
+  return m;
+}
+
+template <std::size_t Width>
+constexpr auto const mask = shuffle_mask<Width>();
+
+#if defined(CISTA_BULK_SWAP_X86)
+
+#if defined(_MSC_VER)
+#define CISTA_SSSE3_TARGET
+#define CISTA_AVX2_TARGET
+#else
+#define CISTA_SSSE3_TARGET __attribute__((target("ssse3")))
+#define CISTA_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+template <std::size_t Width>
+CISTA_SSSE3_TARGET void ssse3(std::uint8_t* dst, std::uint8_t const* src,
+                              std::size_t n) noexcept {
+  constexpr auto const per_vector = 16U / Width;
+  auto const m =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(mask<Width>.data()));
+  auto i = std::size_t{0U};
+  for (; i + 4U * per_vector <= n; i += 4U * per_vector) {
+    auto const s = reinterpret_cast<__m128i const*>(src + i * Width);
+    auto const d = reinterpret_cast<__m128i*>(dst + i * Width);
+    auto const a = _mm_loadu_si128(s);
+    auto const b = _mm_loadu_si128(s + 1);
+    auto const c = _mm_loadu_si128(s + 2);
+    auto const e = _mm_loadu_si128(s + 3);
+    _mm_storeu_si128(d, _mm_shuffle_epi8(a, m));
+    _mm_storeu_si128(d + 1, _mm_shuffle_epi8(b, m));
+    _mm_storeu_si128(d + 2, _mm_shuffle_epi8(c, m));
+    _mm_storeu_si128(d + 3, _mm_shuffle_epi8(e, m));
+  }
+  for (; i + per_vector <= n; i += per_vector) {
+    auto const x =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * Width));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * Width),
+                     _mm_shuffle_epi8(x, m));
+  }
+  portable<Width>(dst + i * Width, src + i * Width, n - i);
+}
+
+template <std::size_t Width>
+CISTA_AVX2_TARGET void avx2(std::uint8_t* dst, std::uint8_t const* src,
+                            std::size_t n) noexcept {
+  constexpr auto const per_vector = 32U / Width;
+  auto const m =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(mask<Width>.data()));
+  auto i = std::size_t{0U};
+  for (; i + 4U * per_vector <= n; i += 4U * per_vector) {
+    auto const s = reinterpret_cast<__m256i const*>(src + i * Width);
+    auto const d = reinterpret_cast<__m256i*>(dst + i * Width);
+    auto const a = _mm256_loadu_si256(s);
+    auto const b = _mm256_loadu_si256(s + 1);
+    auto const c = _mm256_loadu_si256(s + 2);
+    auto const e = _mm256_loadu_si256(s + 3);
+    _mm256_storeu_si256(d, _mm256_shuffle_epi8(a, m));
+    _mm256_storeu_si256(d + 1, _mm256_shuffle_epi8(b, m));
+    _mm256_storeu_si256(d + 2, _mm256_shuffle_epi8(c, m));
+    _mm256_storeu_si256(d + 3, _mm256_shuffle_epi8(e, m));
+  }
+  for (; i + per_vector <= n; i += per_vector) {
+    auto const x =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i * Width));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * Width),
+                        _mm256_shuffle_epi8(x, m));
+  }
+  ssse3<Width>(dst + i * Width, src + i * Width, n - i);
+}
+
+enum class isa { PORTABLE, SSSE3, AVX2 };
+
+inline isa available_isa() noexcept {
+  static auto const supported = []() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    auto const max_leaf = info[0];
+    __cpuid(info, 1);
+    auto const ssse3 = (info[2] & (1 << 9)) != 0;
+    auto const os_ymm = (info[2] & (1 << 27)) != 0 &&  // OSXSAVE
+                        (_xgetbv(0) & 0x6U) == 0x6U;
+    auto avx2 = false;
+    if (max_leaf >= 7 && os_ymm) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    auto const ssse3 = __builtin_cpu_supports("ssse3") != 0;
+    auto const avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+    return avx2 ? isa::AVX2 : ssse3 ? isa::SSSE3 : isa::PORTABLE;
+  }();
+  return supported;
+}
+
+template <std::size_t Width>
+void swap(std::uint8_t* dst, std::uint8_t const* src,
+          std::size_t const n) noexcept {
+  auto const available = available_isa();
+  if (available == isa::AVX2) {
+    avx2<Width>(dst, src, n);
+  } else if (available == isa::SSSE3) {
+    ssse3<Width>(dst, src, n);
+  } else {
+    portable<Width>(dst, src, n);
+  }
+}
+
+#else
+
+template <std::size_t Width>
+void swap(std::uint8_t* dst, std::uint8_t const* src,
+          std::size_t const n) noexcept {
+  portable<Width>(dst, src, n);
+}
+
+#endif
+
+}  // namespace bulk_swap_detail
+
+// Swaps the byte order of n elements of width bytes (1, 2, 4 or 8).
+inline void endian_swap_n(void* dst, void const* src, std::size_t const n,
+                          std::size_t const width) noexcept {
+  auto const d = static_cast<std::uint8_t*>(dst);
+  auto const s = static_cast<std::uint8_t const*>(src);
+  switch (width) {
+    case 2U: bulk_swap_detail::swap<2U>(d, s, n); break;
+    case 4U: bulk_swap_detail::swap<4U>(d, s, n); break;
+    case 8U: bulk_swap_detail::swap<8U>(d, s, n); break;
+    default:
+      if (d != s) {
+        std::memmove(d, s, n * width);
+      }
+  }
+}
+
+template <typename T>
+void endian_swap_n(T* dst, T const* src, std::size_t const n) noexcept {
+  static_assert(std::is_integral_v<T>);
+  endian_swap_n(static_cast<void*>(dst), static_cast<void const*>(src), n,
+                sizeof(T));
+}
+
+template <typename T>
+void endian_swap_n(T* data, std::size_t const n) noexcept {
+  endian_swap_n(data, data, n);
+}
+
+// Writes the bytes [from, from + n) of the byte swapped representation of
+// the elements at src to dst. from and n do not have to be element aligned.
+inline void copy_endian_swapped(std::uint8_t* dst, std::uint8_t const* src,
+                                std::size_t const from, std::size_t const n,
+                                std::size_t const width) noexcept {
+  auto const swap_partial = [&](std::size_t const el, std::size_t const first,
+                                std::size_t const last, std::uint8_t* out) {
+    std::uint8_t tmp[8U];
+    endian_swap_n(tmp, src + el * width, 1U, width);
+    std::memcpy(out, tmp + first, last - first);
+  };
+
+  auto pos = from;
+  auto const to = from + n;
+  if (pos % width != 0U) {
+    auto const last = std::min(to, (pos / width + 1U) * width);
+    swap_partial(pos / width, pos % width, last - (pos / width) * width, dst);
+    dst += last - pos;
+    pos = last;
+  }
+  auto const full = (to - pos) / width;
+  endian_swap_n(dst, src + pos, full, width);
+  dst += full * width;
+  pos += full * width;
+  if (pos != to) {
+    swap_partial(pos / width, 0U, to - pos, dst);
+  }
+}
+
+}  // namespace cista
+
+#undef CISTA_SSSE3_TARGET
+#undef CISTA_AVX2_TARGET
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include "cista/containers/array.h"
+#include "cista/containers/offset_ptr.h"
+#include "cista/containers/string.h"
+#include "cista/containers/unique_ptr.h"
+#include "cista/containers/vector.h"
+#include "cista/endian/conversion.h"
+#include "cista/mode.h"
+#include "cista/reflection/to_tuple.h"
+#include "cista/serialization.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Read-only access to a serialized image that converts values to the host
+// byte order on read: an image in a foreign byte order can be used directly
+// from a read-only mapping, without converting (and dirtying) it in place.
+//
+// Supported: integers (converted), other scalars (as serialized), structs
+// (get(&T::member), get<I>()), offset_ptr, unique_ptr, vector, array and
+// string of the offset containers. The data is not validated: only use
+// images that are trusted or were checked before (mode::UNCHECKED rules).
+template <typename T, mode Mode = mode::NONE>
+struct endian_view {
+  using value_type = T;
+
+  // Scalars: the value in host byte order.
+  T get() const noexcept {
+    static_assert(std::is_scalar_v<T>, "use get(&T::member) or get<I>()");
+    auto v = T{};
+    std::memcpy(&v, el_, sizeof(T));
+    if constexpr (std::numeric_limits<T>::is_integer) {
+      return convert_endian<Mode>(v);
+    } else {
+      return v;
+    }
+  }
+
+  operator T() const noexcept { return get(); }
+
+  // Structs: view of a member.
+  template <typename Member, typename Class>
+  endian_view<Member, Mode> get(Member Class::*const member) const noexcept {
+    static_assert(std::is_base_of_v<Class, T>);
+    return {&(el_->*member)};
+  }
+
+  template <std::size_t I>
+  auto get() const noexcept {
+    auto const& member = std::get<I>(to_tuple(*el_));
+    return endian_view<decay_t<decltype(member)>, Mode>{&member};
+  }
+
+  T const* el_;
+};
+
+template <mode Mode, typename T>
+T const* resolve(offset_ptr<T> const& p) noexcept {
+  auto const offset = convert_endian<Mode>(p.offset_);
+  return offset == NULLPTR_OFFSET
+             ? nullptr
+             : reinterpret_cast<T const*>(
+                   reinterpret_cast<std::uint8_t const*>(&p) + offset);
+}
+
+template <typename T, mode Mode>
+struct endian_view<offset_ptr<T>, Mode> {
+  using value_type = T;
+
+  T const* raw() const noexcept { return resolve<Mode>(*el_); }
+  explicit operator bool() const noexcept { return raw() != nullptr; }
+  endian_view<T, Mode> operator*() const noexcept { return {raw()}; }
+
+  offset_ptr<T> const* el_;
+};
+
+template <typename T, mode Mode>
+struct endian_view<basic_unique_ptr<T, offset_ptr<T>>, Mode> {
+  using value_type = T;
+
+  T const* raw() const noexcept { return resolve<Mode>(el_->el_); }
+  explicit operator bool() const noexcept { return raw() != nullptr; }
+  endian_view<T, Mode> operator*() const noexcept { return {raw()}; }
+
+  basic_unique_ptr<T, offset_ptr<T>> const* el_;
+};
+
+// Random access to a contiguous range of serialized elements.
+template <typename T, mode Mode>
+struct endian_range_view {
+  struct iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = endian_view<T, Mode>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type*;
+    using reference = value_type;
+
+    value_type operator*() const noexcept { return {el_}; }
+    iterator& operator++() noexcept {
+      ++el_;
+      return *this;
+    }
+    iterator operator++(int) noexcept {
+      auto const tmp = *this;
+      ++el_;
+      return tmp;
+    }
+    friend bool operator==(iterator const a, iterator const b) noexcept {
+      return a.el_ == b.el_;
+    }
+    friend bool operator!=(iterator const a, iterator const b) noexcept {
+      return a.el_ != b.el_;
+    }
+
+    T const* el_;
+  };
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0U; }
+
+  endian_view<T, Mode> operator[](std::size_t const i) const noexcept {
+    return {data_ + i};
+  }
+
+  endian_view<T, Mode> at(std::size_t const i) const {
+    verify(i < size_, "endian_view: out of bounds");
+    return (*this)[i];
+  }
+
+  iterator begin() const noexcept { return {data_}; }
+  iterator end() const noexcept { return {data_ + size_}; }
+  friend iterator begin(endian_range_view const& v) noexcept {
+    return v.begin();
+  }
+  friend iterator end(endian_range_view const& v) noexcept { return v.end(); }
+
+  T const* data_;
+  std::size_t size_;
+};
+
+template <typename T, bool Indexed, typename TemplateSizeType, mode Mode>
+struct endian_view<basic_vector<T, offset::ptr, Indexed, TemplateSizeType>,
+                   Mode> : public endian_range_view<T, Mode> {
+  using value_type = T;
+  using vector_t = basic_vector<T, offset::ptr, Indexed, TemplateSizeType>;
+
+  endian_view(vector_t const* el) noexcept
+      : endian_range_view<T, Mode>{
+            resolve<Mode>(el->el_),
+            static_cast<std::size_t>(convert_endian<Mode>(el->used_size_))} {}
+};
+
+template <typename T, std::size_t Size, mode Mode>
+struct endian_view<array<T, Size>, Mode> : public endian_range_view<T, Mode> {
+  using value_type = T;
+
+  endian_view(array<T, Size> const* el) noexcept
+      : endian_range_view<T, Mode>{el->data(), Size} {}
+};
+
+template <typename Ptr, mode Mode>
+struct endian_view<generic_string<Ptr>, Mode> {
+  using string_t = generic_string<Ptr>;
+  using CharT = typename string_t::CharT;
+  static_assert(!std::is_pointer_v<Ptr>, "offset strings only");
+
+  endian_view(string_t const* el) noexcept {
+    if (*reinterpret_cast<std::uint8_t const*>(&el->s_.is_short_) != 0U) {
+      data_ = el->s_.s_;
+      auto const end = std::char_traits<CharT>::find(
+          data_, string_t::short_length_limit, CharT{0});
+      size_ = end == nullptr ? string_t::short_length_limit
+                             : static_cast<std::size_t>(end - data_);
+    } else {
+      data_ = resolve<Mode>(el->h_.ptr_);
+      size_ = convert_endian<Mode>(el->h_.size_);
+    }
+  }
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0U; }
+
+  CharT operator[](std::size_t const i) const noexcept {
+    return endian_view<CharT, Mode>{data_ + i};
+  }
+
+  // Single byte characters need no conversion: no copy.
+  std::basic_string_view<CharT> view() const noexcept {
+    static_assert(sizeof(CharT) == 1U, "use str()");
+    return {data_, size_};
+  }
+
+  std::basic_string<CharT> str() const {
+    auto s = std::basic_string<CharT>(data_, size_);
+    if constexpr (sizeof(CharT) != 1U && endian_conversion_necessary<Mode>()) {
+      endian_swap_n(s.data(), s.size());
+    }
+    return s;
+  }
+
+  CharT const* data_;
+  std::size_t size_;
+};
+
+template <typename Ptr, mode Mode>
+struct endian_view<basic_string<Ptr>, Mode>
+    : public endian_view<generic_string<Ptr>, Mode> {
+  endian_view(basic_string<Ptr> const* el) noexcept
+      : endian_view<generic_string<Ptr>, Mode>{el} {}
+};
+
+template <typename Ptr, mode Mode>
+struct endian_view<basic_string_view<Ptr>, Mode>
+    : public endian_view<generic_string<Ptr>, Mode> {
+  endian_view(basic_string_view<Ptr> const* el) noexcept
+      : endian_view<generic_string<Ptr>, Mode>{el} {}
+};
+
+// Checks the header (version, integrity) like deserialize() and returns a
+// view of the root element. The image is neither modified nor walked.
+template <typename T, mode const Mode = mode::NONE>
+endian_view<T, Mode> view(std::uint8_t const* from, std::uint8_t const* to) {
+  static_assert(is_mode_disabled(Mode, mode::CAST));
+  check<T, Mode>(from, to);
+  return endian_view<T, Mode>{
+      reinterpret_cast<T const*>(from + data_start(Mode))};
+}
+
+template <typename T, mode const Mode = mode::NONE, typename Container>
+endian_view<T, Mode> view(Container const& c) {
+  auto const from = reinterpret_cast<std::uint8_t const*>(&c[0]);
+  return view<T, Mode>(from, from + c.size());
+}
+
+}  // namespace cista
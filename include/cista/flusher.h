@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cista {
+
+// Background thread for deferred work such as syncing and closing memory
+// mappings (see mmap_options::flusher_). Jobs run in submission order.
+// The destructor waits until all submitted jobs are done.
+// A failing job does not stop the following ones: the first exception is
+// rethrown by wait() or - if wait() did not report it and no other
+// exception is in flight - by the destructor.
+struct flusher {
+  flusher() : thread_{[this]() { run(); }} {}
+
+  ~flusher() noexcept(false) {
+    {
+      auto const lock = std::lock_guard{mutex_};
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    if (error_ && std::uncaught_exceptions() == 0) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  flusher(flusher const&) = delete;
+  flusher& operator=(flusher const&) = delete;
+  flusher(flusher&&) = delete;
+  flusher& operator=(flusher&&) = delete;
+
+  void defer(std::function<void()> job) {
+    {
+      auto const lock = std::lock_guard{mutex_};
+      jobs_.emplace_back(std::move(job));
+    }
+    cv_.notify_all();
+  }
+
+  // Blocks until all jobs submitted so far are done.
+  void wait() {
+    auto lock = std::unique_lock{mutex_};
+    cv_.wait(lock, [&]() { return jobs_.empty() && !busy_; });
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+private:
+  void run() {
+    auto lock = std::unique_lock{mutex_};
+    while (true) {
+      cv_.wait(lock, [&]() { return stop_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        return;
+      }
+      auto jobs = std::move(jobs_);
+      jobs_.clear();
+      busy_ = true;
+      lock.unlock();
+      auto error = std::exception_ptr{};
+      for (auto& job : jobs) {
+        try {
+          job();
+        } catch (...) {
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+        job = nullptr;
+      }
+      lock.lock();
+      if (error && !error_) {
+        error_ = error;
+      }
+      busy_ = false;
+      cv_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::function<void()>> jobs_;
+  std::exception_ptr error_;
+  bool busy_{false};
+  bool stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace cista
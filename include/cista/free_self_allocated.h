@@ -10,6 +10,9 @@ struct free_self_allocated_context {
 
   template <typename T>
   void add_checked(T&&) {}
+
+  template <typename T>
+  void convert_endian_range(T*, std::size_t) const {}
 };
 
 template <typename T>
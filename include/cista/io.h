@@ -2,6 +2,7 @@
 
 #include <filesystem>
 
+#include "cista/load.h"
 #include "cista/memory_holder.h"
 #include "cista/mode.h"
 
@@ -30,17 +31,19 @@ void write(std::filesystem::path const& p, wrapped<T> const& w) {
 }
 
 template <typename T, mode Mode = kDefaultMode>
-cista::wrapped<T> read(std::filesystem::path const& p) {
-  auto b = cista::file{p.generic_string().c_str(), "r"}.content();
+cista::wrapped<T> read(std::filesystem::path const& p,
+                       load_options const& opt = {}) {
+  auto b = load_file(p.generic_string().c_str(), opt);
   auto const ptr = cista::deserialize<T, Mode>(b);
   auto mem = cista::memory_holder{std::move(b)};
   return cista::wrapped{std::move(mem), ptr};
 }
 
 template <typename T, mode Mode = kDefaultMode>
-cista::wrapped<T> read_mmap(std::filesystem::path const& p) {
-  auto mmap =
-      cista::mmap{p.generic_string().c_str(), cista::mmap::protection::READ};
+cista::wrapped<T> read_mmap(std::filesystem::path const& p,
+                            mmap_options const& opt = {}) {
+  auto mmap = cista::mmap{p.generic_string().c_str(),
+                          cista::mmap::protection::READ, opt};
   auto const ptr = cista::deserialize<T, Mode>(mmap);
   auto mem = cista::memory_holder{buf{std::move(mmap)}};
   return cista::wrapped{std::move(mem), ptr};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <type_traits>
+
+#include "cista/containers.h"
+#include "cista/decay.h"
+#include "cista/indexed.h"
+#include "cista/reflection/to_tuple.h"
+#include "cista/strong.h"
+
+namespace cista {
+
+// A type is offset only if its values contain no raw pointers: neither
+// plain T* members nor containers instantiated with raw pointers (the
+// cista::raw containers). Offset only data is position independent.
+// Aggregates and container elements are inspected recursively, pointer
+// targets are not (they are objects of their own). Types that cannot be
+// inspected (e.g. non-aggregate classes) are assumed to be offset only.
+template <typename T, typename... Seen>
+struct is_offset_only;
+
+namespace detail {
+
+template <typename Tuple, typename... Seen>
+struct all_offset_only;
+
+template <typename... T, typename... Seen>
+struct all_offset_only<std::tuple<T...>, Seen...>
+    : std::bool_constant<(is_offset_only<decay_t<T>, Seen...>::value &&
+                          ...)> {};
+
+template <typename T, typename... Seen>
+constexpr bool reflect_offset_only() noexcept {
+  if constexpr ((std::is_same_v<T, Seen> || ...)) {
+    return true;  // Recursive type: checked further up.
+  } else if constexpr (std::is_pointer_v<T>) {
+    return false;
+  } else if constexpr (std::is_scalar_v<T> || std::is_union_v<T>) {
+    return true;
+  } else if constexpr (std::is_array_v<T>) {
+    return is_offset_only<std::remove_all_extents_t<T>, Seen...>::value;
+  } else if constexpr (to_tuple_works_v<T>) {
+    return all_offset_only<decltype(to_tuple(std::declval<T&>())), T,
+                           Seen...>::value;
+  } else {
+    return true;
+  }
+}
+
+}  // namespace detail
+
+template <typename T, typename... Seen>
+struct is_offset_only
+    : std::bool_constant<detail::reflect_offset_only<T, Seen...>()> {};
+
+template <typename T, typename... Seen>
+struct is_offset_only<offset_ptr<T>, Seen...> : std::true_type {};
+
+template <typename T, template <typename> typename Ptr, bool Indexed,
+          typename SizeType, typename Allocator, typename... Seen>
+struct is_offset_only<basic_vector<T, Ptr, Indexed, SizeType, Allocator>,
+                      Seen...>
+    : std::bool_constant<
+          !std::is_pointer_v<Ptr<T>> &&
+          is_offset_only<decay_t<T>,
+                         basic_vector<T, Ptr, Indexed, SizeType, Allocator>,
+                         Seen...>::value> {};
+
+template <typename T, typename Ptr, typename... Seen>
+struct is_offset_only<basic_unique_ptr<T, Ptr>, Seen...>
+    : std::bool_constant<
+          !std::is_pointer_v<Ptr> &&
+          is_offset_only<decay_t<T>, basic_unique_ptr<T, Ptr>,
+                         Seen...>::value> {};
+
+template <typename T, template <typename> typename Ptr, typename GetKey,
+          typename GetValue, typename Hash, typename Eq, typename... Seen>
+struct is_offset_only<hash_storage<T, Ptr, GetKey, GetValue, Hash, Eq>,
+                      Seen...>
+    : std::bool_constant<
+          !std::is_pointer_v<Ptr<T>> &&
+          is_offset_only<decay_t<T>,
+                         hash_storage<T, Ptr, GetKey, GetValue, Hash, Eq>,
+                         Seen...>::value> {};
+
+template <typename Ptr, typename... Seen>
+struct is_offset_only<generic_string<Ptr>, Seen...>
+    : std::bool_constant<!std::is_pointer_v<Ptr>> {};
+
+template <typename Ptr, typename... Seen>
+struct is_offset_only<basic_string<Ptr>, Seen...>
+    : is_offset_only<generic_string<Ptr>> {};
+
+template <typename Ptr, typename... Seen>
+struct is_offset_only<basic_string_view<Ptr>, Seen...>
+    : is_offset_only<generic_string<Ptr>> {};
+
+template <typename T, std::size_t Size, typename... Seen>
+struct is_offset_only<std::array<T, Size>, Seen...>
+    : is_offset_only<decay_t<T>, Seen...> {};
+
+template <typename A, typename B, typename... Seen>
+struct is_offset_only<pair<A, B>, Seen...>
+    : std::bool_constant<is_offset_only<decay_t<A>, Seen...>::value &&
+                         is_offset_only<decay_t<B>, Seen...>::value> {};
+
+template <typename... T, typename... Seen>
+struct is_offset_only<tuple<T...>, Seen...>
+    : std::bool_constant<(is_offset_only<decay_t<T>, Seen...>::value && ...)> {
+};
+
+template <typename... T, typename... Seen>
+struct is_offset_only<variant<T...>, Seen...>
+    : std::bool_constant<(is_offset_only<decay_t<T>, Seen...>::value && ...)> {
+};
+
+template <typename T, typename... Seen>
+struct is_offset_only<optional<T>, Seen...>
+    : is_offset_only<decay_t<T>, Seen...> {};
+
+template <typename T, typename... Seen>
+struct is_offset_only<indexed<T>, Seen...> : is_offset_only<T, Seen...> {};
+
+template <typename T, typename Tag, typename... Seen>
+struct is_offset_only<strong<T, Tag>, Seen...>
+    : is_offset_only<decay_t<T>, Seen...> {};
+
+template <typename T>
+constexpr bool is_offset_only_v = is_offset_only<decay_t<T>>::value;
+
+}  // namespace cista
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "cista/containers/bitset.h"
+#include "cista/containers/offset_ptr.h"
+#include "cista/containers/pair.h"
+#include "cista/containers/tuple.h"
+#include "cista/decay.h"
+#include "cista/indexed.h"
+#include "cista/offset_t.h"
+#include "cista/reflection/to_tuple.h"
+#include "cista/strong.h"
+
+namespace cista {
+
+// A type is pointer free if its serialized form is a plain copy of its bytes:
+// it contains neither pointers that need to be resolved nor containers with
+// out-of-line memory. Aggregates are inspected field by field (reflection).
+// Everything else - including aggregates with a custom serialize() overload -
+// is not pointer free unless is_pointer_free is specialized for it.
+template <typename T>
+struct is_pointer_free;
+
+namespace detail {
+
+namespace probe {
+
+struct ctx {};
+struct generic {};
+
+template <typename T>
+generic serialize(ctx&, T const*, offset_t);
+
+template <typename T, typename = void>
+struct has_custom_serialize : std::true_type {};
+
+template <typename T>
+struct has_custom_serialize<
+    T, std::enable_if_t<std::is_same_v<
+           decltype(serialize(std::declval<ctx&>(), std::declval<T const*>(),
+                              offset_t{})),
+           generic>>> : std::false_type {};
+
+}  // namespace probe
+
+template <typename Tuple>
+struct all_pointer_free;
+
+template <typename... T>
+struct all_pointer_free<std::tuple<T...>>
+    : std::bool_constant<(is_pointer_free<decay_t<T>>::value && ...)> {};
+
+template <typename T>
+constexpr bool reflect_pointer_free() noexcept {
+  if constexpr (is_pointer_v<T> || is_indexed_v<T>) {
+    return false;
+  } else if constexpr (std::is_scalar_v<T> || std::is_union_v<T>) {
+    return true;
+  } else if constexpr (std::is_array_v<T>) {
+    return is_pointer_free<std::remove_all_extents_t<T>>::value;
+  } else if constexpr (probe::has_custom_serialize<T>::value) {
+    return false;
+  } else if constexpr (to_tuple_works_v<T>) {
+    return all_pointer_free<decltype(to_tuple(std::declval<T&>()))>::value;
+  } else {
+    return false;
+  }
+}
+
+}  // namespace detail
+
+template <typename T>
+struct is_pointer_free
+    : std::bool_constant<detail::reflect_pointer_free<T>()> {};
+
+template <typename T, std::size_t Size>
+struct is_pointer_free<std::array<T, Size>> : is_pointer_free<decay_t<T>> {};
+
+template <typename A, typename B>
+struct is_pointer_free<std::pair<A, B>>
+    : std::bool_constant<is_pointer_free<decay_t<A>>::value &&
+                         is_pointer_free<decay_t<B>>::value> {};
+
+template <typename A, typename B>
+struct is_pointer_free<pair<A, B>>
+    : std::bool_constant<is_pointer_free<decay_t<A>>::value &&
+                         is_pointer_free<decay_t<B>>::value> {};
+
+template <typename... T>
+struct is_pointer_free<tuple<T...>>
+    : std::bool_constant<(is_pointer_free<decay_t<T>>::value && ...)> {};
+
+template <typename T, typename Tag>
+struct is_pointer_free<strong<T, Tag>> : is_pointer_free<decay_t<T>> {};
+
+template <std::size_t Size>
+struct is_pointer_free<bitset<Size>> : std::true_type {};
+
+template <typename Rep, typename Period>
+struct is_pointer_free<std::chrono::duration<Rep, Period>> : std::true_type {
+};
+
+template <typename Clock, typename Dur>
+struct is_pointer_free<std::chrono::time_point<Clock, Dur>> : std::true_type {
+};
+
+template <typename T>
+constexpr bool is_pointer_free_v = is_pointer_free<decay_t<T>>::value;
+
+}  // namespace cista
@@ -0,0 +1,411 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "cista/containers/array.h"
+#include "cista/containers/offset_ptr.h"
+#include "cista/containers/string.h"
+#include "cista/containers/unique_ptr.h"
+#include "cista/containers/vector.h"
+#include "cista/is_pointer_free.h"
+#include "cista/mode.h"
+#include "cista/reflection/to_tuple.h"
+#include "cista/serialization.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Checked bits of one type for lazy access: one bit per aligned slot of the
+// image, split into pages that are allocated when a slot in them is checked
+// first. Opening a large image only allocates the page table.
+struct lazy_visited_bits {
+  static constexpr auto const PAGE_WORDS = std::size_t{512U};
+
+  using word_t = std::atomic<std::uint64_t>;
+
+  explicit lazy_visited_bits(std::size_t const n_slots)
+      : n_pages_{n_slots / 64U / PAGE_WORDS + 1U},
+        pages_{new std::atomic<word_t*>[n_pages_]()} {}
+
+  lazy_visited_bits(lazy_visited_bits const&) = delete;
+  lazy_visited_bits(lazy_visited_bits&&) = delete;
+  lazy_visited_bits& operator=(lazy_visited_bits const&) = delete;
+  lazy_visited_bits& operator=(lazy_visited_bits&&) = delete;
+
+  ~lazy_visited_bits() {
+    for (auto i = std::size_t{0U}; i != n_pages_; ++i) {
+      delete[] pages_[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  // Thread safe: concurrent first touches of a page keep one allocation.
+  word_t& word(std::size_t const slot) {
+    auto const w = slot / 64U;
+    auto& page = pages_[w / PAGE_WORDS];
+    auto p = page.load(std::memory_order_acquire);
+    if (p == nullptr) {
+      auto const fresh = new word_t[PAGE_WORDS]();
+      if (page.compare_exchange_strong(p, fresh, std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        p = fresh;
+      } else {
+        delete[] fresh;
+      }
+    }
+    return p[w % PAGE_WORDS];
+  }
+
+  std::size_t n_pages_;
+  std::unique_ptr<std::atomic<word_t*>[]> pages_;
+};
+
+// Lazily validated access to an image (offset containers, host byte order).
+// Opening checks the header and the root object only. Every other object is
+// checked when an accessor reaches it for the first time: its scalars, its
+// pointers and the ranges of its containers - but not the elements of these
+// containers, those are checked when they are accessed. Objects that passed
+// the check are remembered, so each one is checked once.
+//
+// Pointer free types are fully covered by the range check of the containing
+// object: accessors return them as plain references. Everything else is
+// wrapped in a lazy_view. deep() checks a whole subtree (like deserialize)
+// and returns a plain reference, e.g. for containers without lazy accessors.
+template <mode Mode>
+struct lazy_state {
+  static constexpr auto const MODE = Mode | mode::_CONST | mode::_LAZY;
+  static constexpr auto const CACHED_TYPES = std::size_t{64U};
+
+  lazy_state(std::uint8_t const* from, std::uint8_t const* to)
+      : ctx_{from, to} {}
+
+  template <typename T>
+  void validate(T const* el) const {
+    if constexpr (is_pointer_free_v<T>) {
+      CISTA_UNUSED_PARAM(el)
+    } else {
+      check_once<shallow_tag<T>>(
+          el, [&]() { deserialize(ctx_, const_cast<T*>(el)); });
+    }
+  }
+
+  template <typename T>
+  void validate_deep(T const* el) const {
+    check_once<deep_tag<T>>(el, [&]() {
+      auto const from = reinterpret_cast<std::uint8_t const*>(ctx_.from_);
+      auto const to = reinterpret_cast<std::uint8_t const*>(ctx_.to_);
+      deserialization_context<Mode | mode::_CONST> c{from, to};
+      deserialize(c, const_cast<T*>(el));
+      if constexpr (is_mode_enabled(Mode, mode::DEEP_CHECK)) {
+        deep_check_context<Mode | mode::_CONST | mode::_PHASE_II> c1{from, to};
+        deserialize(c1, const_cast<T*>(el));
+      }
+    });
+  }
+
+  template <typename T>
+  struct shallow_tag {};
+
+  template <typename T>
+  struct deep_tag {};
+
+  // Marks el as checked only after fn succeeded: a failed check is repeated
+  // (and fails again) on the next access.
+  template <typename Tag, typename T, typename Fn>
+  void check_once(T const* el, Fn&& fn) const {
+    auto const pos = reinterpret_cast<intptr_t>(el);
+    if (pos < ctx_.from_ || pos >= ctx_.to_) {
+      fn();
+      return;
+    }
+
+    auto const slot = static_cast<std::size_t>(pos - ctx_.from_) / alignof(T);
+    auto& word = bitmap<Tag>(alignof(T))->word(slot);
+    auto const bit = std::uint64_t{1U} << (slot % 64U);
+    if ((word.load(std::memory_order_acquire) & bit) == 0U) {
+      fn();
+      word.fetch_or(bit, std::memory_order_release);
+    }
+  }
+
+  template <typename Tag>
+  lazy_visited_bits* bitmap(std::size_t const alignment) const {
+    auto const type_idx = deep_check_type_index<Tag>();
+    if (type_idx >= CACHED_TYPES) {
+      return get_bitmap(type_idx, alignment);
+    }
+    auto& cached = bitmaps_[type_idx];
+    auto b = cached.load(std::memory_order_acquire);
+    if (b == nullptr) {
+      b = get_bitmap(type_idx, alignment);
+      cached.store(b, std::memory_order_release);
+    }
+    return b;
+  }
+
+  lazy_visited_bits* get_bitmap(std::size_t const type_idx,
+                                std::size_t const alignment) const {
+    auto const lock = std::lock_guard{mutex_};
+    if (type_idx >= visited_.size()) {
+      visited_.resize(type_idx + 1U);
+    }
+    auto& b = visited_[type_idx];
+    if (b == nullptr) {
+      b = std::make_unique<lazy_visited_bits>(
+          static_cast<std::size_t>(ctx_.to_ - ctx_.from_) / alignment);
+    }
+    return b.get();
+  }
+
+  deserialization_context<MODE> ctx_;
+  std::mutex mutable mutex_;
+  std::vector<std::unique_ptr<lazy_visited_bits>> mutable visited_;
+  std::array<std::atomic<lazy_visited_bits*>, CACHED_TYPES> mutable
+      bitmaps_{};
+};
+
+template <typename T, mode Mode>
+struct lazy_view;
+
+// Pointer free: plain reference, otherwise a lazy_view.
+template <typename T, mode Mode>
+using lazy_t =
+    std::conditional_t<is_pointer_free_v<T>, T const&, lazy_view<T, Mode>>;
+
+template <typename T, mode Mode>
+lazy_t<T, Mode> make_lazy(T const* el, lazy_state<Mode> const* state) {
+  if constexpr (is_pointer_free_v<T>) {
+    CISTA_UNUSED_PARAM(state)
+    return *el;
+  } else {
+    return lazy_view<T, Mode>{el, state};
+  }
+}
+
+// Objects reached through a pointer or a container: checked on first access.
+template <typename T, mode Mode>
+lazy_t<T, Mode> access(T const* el, lazy_state<Mode> const* state) {
+  state->validate(el);
+  return make_lazy(el, state);
+}
+
+template <typename T, mode Mode>
+struct lazy_view_base {
+  using value_type = T;
+
+  lazy_view_base(T const* el, lazy_state<Mode> const* state) noexcept
+      : el_{el}, state_{state} {}
+
+  // Checks the whole subtree once.
+  T const& deep() const {
+    state_->validate_deep(el_);
+    return *el_;
+  }
+
+  T const* el_;
+  lazy_state<Mode> const* state_;
+};
+
+// Structs: members are part of the checked object.
+template <typename T, mode Mode>
+struct lazy_view : public lazy_view_base<T, Mode> {
+  using lazy_view_base<T, Mode>::lazy_view_base;
+
+  template <typename Member, typename Class>
+  lazy_t<Member, Mode> get(Member Class::*const member) const {
+    static_assert(std::is_base_of_v<Class, T>);
+    return make_lazy(&(this->el_->*member), this->state_);
+  }
+
+  template <std::size_t I>
+  auto get() const {
+    auto const& member = std::get<I>(to_tuple(*this->el_));
+    return make_lazy(&member, this->state_);
+  }
+};
+
+template <typename T, mode Mode>
+struct lazy_view<offset_ptr<T>, Mode>
+    : public lazy_view_base<offset_ptr<T>, Mode> {
+  using lazy_view_base<offset_ptr<T>, Mode>::lazy_view_base;
+
+  explicit operator bool() const noexcept { return *this->el_ != nullptr; }
+  lazy_t<T, Mode> operator*() const {
+    verify(*this->el_ != nullptr, "lazy_view: nullptr");
+    return access(static_cast<T const*>(this->el_->get()), this->state_);
+  }
+};
+
+template <typename T, mode Mode>
+struct lazy_view<basic_unique_ptr<T, offset_ptr<T>>, Mode>
+    : public lazy_view_base<basic_unique_ptr<T, offset_ptr<T>>, Mode> {
+  using lazy_view_base<basic_unique_ptr<T, offset_ptr<T>>, Mode>::
+      lazy_view_base;
+
+  explicit operator bool() const noexcept {
+    return this->el_->get() != nullptr;
+  }
+  lazy_t<T, Mode> operator*() const {
+    verify(this->el_->get() != nullptr, "lazy_view: nullptr");
+    return access(static_cast<T const*>(this->el_->get()), this->state_);
+  }
+};
+
+// Range of elements that lie in checked memory: each element is checked on
+// first access (array elements are inline and checked with the array).
+template <typename T, mode Mode, bool Inline>
+struct lazy_range {
+  struct iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T const*;
+    using reference = lazy_t<T, Mode>;
+
+    reference operator*() const { return lazy_range::get(el_, state_); }
+    iterator& operator++() noexcept {
+      ++el_;
+      return *this;
+    }
+    iterator operator++(int) noexcept {
+      auto const tmp = *this;
+      ++el_;
+      return tmp;
+    }
+    friend bool operator==(iterator const a, iterator const b) noexcept {
+      return a.el_ == b.el_;
+    }
+    friend bool operator!=(iterator const a, iterator const b) noexcept {
+      return a.el_ != b.el_;
+    }
+
+    T const* el_;
+    lazy_state<Mode> const* state_;
+  };
+
+  static lazy_t<T, Mode> get(T const* el, lazy_state<Mode> const* state) {
+    if constexpr (Inline) {
+      return make_lazy(el, state);
+    } else {
+      return access(el, state);
+    }
+  }
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0U; }
+
+  // Bounds are checked: the image is not trusted.
+  lazy_t<T, Mode> operator[](std::size_t const i) const {
+    verify(i < size_, "lazy_view: out of bounds");
+    return get(data_ + i, state_);
+  }
+  lazy_t<T, Mode> at(std::size_t const i) const { return (*this)[i]; }
+
+  iterator begin() const noexcept { return {data_, state_}; }
+  iterator end() const noexcept { return {data_ + size_, state_}; }
+  friend iterator begin(lazy_range const& r) noexcept { return r.begin(); }
+  friend iterator end(lazy_range const& r) noexcept { return r.end(); }
+
+  T const* data_;
+  std::size_t size_;
+  lazy_state<Mode> const* state_;
+};
+
+template <typename T, bool Indexed, typename TemplateSizeType, mode Mode>
+struct lazy_view<basic_vector<T, offset::ptr, Indexed, TemplateSizeType>, Mode>
+    : public lazy_view_base<
+          basic_vector<T, offset::ptr, Indexed, TemplateSizeType>, Mode>,
+      public lazy_range<T, Mode, false> {
+  using vector_t = basic_vector<T, offset::ptr, Indexed, TemplateSizeType>;
+  using lazy_range<T, Mode, false>::begin;
+  using lazy_range<T, Mode, false>::end;
+
+  lazy_view(vector_t const* el, lazy_state<Mode> const* state) noexcept
+      : lazy_view_base<vector_t, Mode>{el, state},
+        lazy_range<T, Mode, false>{el->data(), el->size(), state} {}
+};
+
+template <typename T, std::size_t Size, mode Mode>
+struct lazy_view<array<T, Size>, Mode>
+    : public lazy_view_base<array<T, Size>, Mode>,
+      public lazy_range<T, Mode, true> {
+  using lazy_range<T, Mode, true>::begin;
+  using lazy_range<T, Mode, true>::end;
+
+  lazy_view(array<T, Size> const* el, lazy_state<Mode> const* state) noexcept
+      : lazy_view_base<array<T, Size>, Mode>{el, state},
+        lazy_range<T, Mode, true>{el->data(), Size, state} {}
+};
+
+// Strings: the character range was checked with the string.
+template <typename String, mode Mode>
+struct lazy_string_view : public lazy_view_base<String, Mode> {
+  using lazy_view_base<String, Mode>::lazy_view_base;
+  using CharT = typename String::CharT;
+
+  std::size_t size() const noexcept { return this->el_->size(); }
+  bool empty() const noexcept { return size() == 0U; }
+  std::basic_string_view<CharT> view() const noexcept {
+    return {this->el_->data(), this->el_->size()};
+  }
+  CharT operator[](std::size_t const i) const {
+    verify(i < size(), "lazy_view: out of bounds");
+    return this->el_->data()[i];
+  }
+};
+
+template <typename Ptr, mode Mode>
+struct lazy_view<basic_string<Ptr>, Mode>
+    : public lazy_string_view<basic_string<Ptr>, Mode> {
+  using lazy_string_view<basic_string<Ptr>, Mode>::lazy_string_view;
+};
+
+template <typename Ptr, mode Mode>
+struct lazy_view<basic_string_view<Ptr>, Mode>
+    : public lazy_string_view<basic_string_view<Ptr>, Mode> {
+  using lazy_string_view<basic_string_view<Ptr>, Mode>::lazy_string_view;
+};
+
+// Owns the validation state; accessors (and values returned by them) must
+// not outlive it.
+template <typename T, mode Mode>
+struct lazy_image {
+  lazy_t<T, Mode> root() const { return make_lazy(root_, state_.get()); }
+  lazy_t<T, Mode> operator*() const { return root(); }
+
+  std::unique_ptr<lazy_state<Mode>> state_;
+  T const* root_;
+};
+
+// Checks the header (version, integrity) and the root object. The image is
+// neither modified nor walked.
+template <typename T, mode const Mode = mode::NONE>
+lazy_image<T, Mode> lazy_deserialize(std::uint8_t const* from,
+                                     std::uint8_t const* to) {
+  static_assert(is_mode_disabled(Mode, mode::CAST));
+  static_assert(!endian_conversion_necessary<Mode>(),
+                "foreign byte order: use endian_view");
+  check<T, Mode>(from, to);
+  auto img = lazy_image<T, Mode>{
+      std::make_unique<lazy_state<Mode>>(from, to - trailer_size(Mode)),
+      reinterpret_cast<T const*>(from + data_start(Mode))};
+  img.state_->ctx_.check_ptr(img.root_);
+  img.state_->validate(img.root_);
+  return img;
+}
+
+template <typename T, mode const Mode = mode::NONE, typename Container>
+lazy_image<T, Mode> lazy_deserialize(Container const& c) {
+  auto const from = reinterpret_cast<std::uint8_t const*>(&c[0]);
+  return lazy_deserialize<T, Mode>(from, from + c.size());
+}
+
+}  // namespace cista
@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+#include "cista/aligned_alloc.h"
+#include "cista/buffer.h"
+#include "cista/parallel_for.h"
+#include "cista/targets/file.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Options for load_file():
+//   - chunk_size_: bytes per positioned read (rounded to DIRECT_ALIGNMENT)
+//   - n_threads_: threads issuing reads in parallel
+//   - huge_pages_: 2 MB aligned buffer, advised for transparent huge pages
+//   - direct_: bypass the page cache (O_DIRECT, macOS: F_NOCACHE) for one
+//     shot loads; falls back to buffered reads if the file system does not
+//     support it
+// huge_pages_ and direct_ are ignored on Windows.
+struct load_options {
+  static constexpr auto const DIRECT_ALIGNMENT = std::size_t{4096U};
+
+  std::size_t chunk_size_{16U * 1024U * 1024U};
+  unsigned n_threads_{std::max(1U, std::thread::hardware_concurrency())};
+  bool huge_pages_{false};
+  bool direct_{false};
+};
+
+namespace detail {
+
+inline file open_for_load(char const* path, bool const direct) {
+#if defined(__linux__) && defined(O_DIRECT)
+  if (direct) {
+    if (auto const fd = ::open(path, O_RDONLY | O_DIRECT); fd != -1) {
+      auto const f = ::fdopen(fd, "r");
+      verify(f != nullptr, "fdopen failed");
+      return file{f};
+    }
+  }
+#endif
+  auto f = file{path, "r"};
+#if defined(__APPLE__) && defined(F_NOCACHE)
+  if (direct) {
+    ::fcntl(f.fd(), F_NOCACHE, 1);
+  }
+#endif
+  return f;
+}
+
+}  // namespace detail
+
+// Reads a whole file with parallel positioned reads (pread / overlapped
+// ReadFile) of chunk_size_ bytes.
+inline buffer load_file(char const* path, load_options const& opt = {}) {
+  auto const f = detail::open_for_load(path, opt.direct_);
+  auto const size = f.size();
+  if (size == 0U) {
+    return buffer{};
+  }
+
+  auto b = buffer{};  // Releases buf_ with std::free.
+  b.buf_ =
+      malloc_with_hints(size, load_options::DIRECT_ALIGNMENT, opt.huge_pages_);
+  b.size_ = size;
+  verify(b.buf_ != nullptr, "load: allocation failed");
+
+  // Chunks are aligned, only the last read ends after the file: the
+  // buffer is allocated as a multiple of DIRECT_ALIGNMENT.
+  auto const chunk_size =
+      to_next_multiple(std::max(opt.chunk_size_, std::size_t{1U}),
+                       load_options::DIRECT_ALIGNMENT);
+#ifdef _WIN32
+  auto const read_size = [](std::size_t const n) { return n; };
+#else
+  auto const read_size = [](std::size_t const n) {
+    return to_next_multiple(n, load_options::DIRECT_ALIGNMENT);
+  };
+#endif
+  auto const n_chunks = (size + chunk_size - 1U) / chunk_size;
+  parallel_for(n_chunks, opt.n_threads_, [&](std::size_t const i) {
+    auto const from = i * chunk_size;
+    f.read_at(from, b.data() + from,
+              read_size(std::min(chunk_size, size - from)));
+  });
+
+  return b;
+}
+
+}  // namespace cista
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+
+// Dependency free LZ77 block codec (byte oriented sequences, LZ4 style).
+//
+// A compressed block is a list of sequences:
+//
+//   token        high nibble: literal length, low nibble: match length - 4
+//                (15 = the length continues in the following bytes)
+//   [length]     literal length - 15 as 255, 255, ..., x (x < 255)
+//   literals
+//   offset       2 bytes little endian, 1 <= offset <= 65535
+//   [length]     match length - 19, same encoding
+//
+// The last sequence ends after its literals (no offset, no match).
+// Compression is greedy with a single hash table probe: fast, moderate
+// ratio. Decompression checks all bounds and never reads or writes outside
+// of the given buffers, for any input.
+namespace cista::lz {
+
+constexpr auto const MIN_MATCH = std::size_t{4U};
+constexpr auto const MAX_OFFSET = std::size_t{65535U};
+constexpr auto const HASH_BITS = 14U;
+constexpr auto const DECOMPRESS_ERROR = ~std::size_t{0U};
+
+// Maximum compressed size of n bytes (incompressible input).
+constexpr std::size_t compress_bound(std::size_t const n) noexcept {
+  return n + n / 255U + 16U;
+}
+
+// Maximum decompressed size of n compressed bytes (a match grows by at most
+// 255 bytes per length byte).
+constexpr std::size_t decompress_bound(std::size_t const n) noexcept {
+  return 255U * n;
+}
+
+namespace detail {
+
+inline std::uint32_t read32(std::uint8_t const* p) noexcept {
+  auto v = std::uint32_t{};
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline std::uint32_t hash4(std::uint32_t const v) noexcept {
+  return (v * 2654435761U) >> (32U - HASH_BITS);
+}
+
+inline bool write_length(std::uint8_t*& out, std::uint8_t const* end,
+                         std::size_t len) noexcept {
+  for (; len >= 255U; len -= 255U) {
+    if (out == end) {
+      return false;
+    }
+    *out++ = 255U;
+  }
+  if (out == end) {
+    return false;
+  }
+  *out++ = static_cast<std::uint8_t>(len);
+  return true;
+}
+
+inline bool read_length(std::uint8_t const*& in, std::uint8_t const* end,
+                        std::size_t& len) noexcept {
+  auto b = std::uint8_t{};
+  do {
+    if (in == end) {
+      return false;
+    }
+    b = *in++;
+    len += b;
+  } while (b == 255U);
+  return true;
+}
+
+// match_len == 0: last sequence (literals only).
+inline bool write_sequence(std::uint8_t*& out, std::uint8_t const* end,
+                           std::uint8_t const* literals, std::size_t lit_len,
+                           std::size_t const offset,
+                           std::size_t const match_len) noexcept {
+  auto const lit_code = lit_len < 15U ? lit_len : 15U;
+  auto const match_code =
+      match_len == 0U
+          ? 0U
+          : (match_len - MIN_MATCH < 15U ? match_len - MIN_MATCH : 15U);
+  if (out == end) {
+    return false;
+  }
+  *out++ = static_cast<std::uint8_t>((lit_code << 4U) | match_code);
+  if (lit_code == 15U && !write_length(out, end, lit_len - 15U)) {
+    return false;
+  }
+  if (static_cast<std::size_t>(end - out) < lit_len) {
+    return false;
+  }
+  if (lit_len != 0U) {
+    std::memcpy(out, literals, lit_len);
+    out += lit_len;
+  }
+
+  if (match_len == 0U) {
+    return true;
+  }
+  if (end - out < 2) {
+    return false;
+  }
+  *out++ = static_cast<std::uint8_t>(offset & 0xFFU);
+  *out++ = static_cast<std::uint8_t>(offset >> 8U);
+  return match_code != 15U ||
+         write_length(out, end, match_len - MIN_MATCH - 15U);
+}
+
+}  // namespace detail
+
+// Compresses n bytes (n < 4 GiB) into dst. Returns the compressed size or
+// 0 if it does not fit into capacity (compress_bound(n) always fits).
+inline std::size_t compress(std::uint8_t const* src, std::size_t const n,
+                            std::uint8_t* dst,
+                            std::size_t const capacity) noexcept {
+  std::uint32_t table[1U << HASH_BITS] = {};  // position + 1, 0 = empty
+  auto out = dst;
+  auto const out_end = dst + capacity;
+
+  auto anchor = std::size_t{0U};
+  if (n >= MIN_MATCH) {
+    auto const last = n - MIN_MATCH;
+    auto misses = std::size_t{0U};
+    for (auto i = std::size_t{0U}; i <= last;) {
+      auto const v = detail::read32(src + i);
+      auto& slot = table[detail::hash4(v)];
+      auto const candidate = static_cast<std::size_t>(slot);
+      slot = static_cast<std::uint32_t>(i + 1U);
+
+      if (candidate == 0U || i - (candidate - 1U) > MAX_OFFSET ||
+          detail::read32(src + candidate - 1U) != v) {
+        i += 1U + (misses++ >> 5U);  // Skip faster over incompressible data.
+        continue;
+      }
+
+      auto const match = candidate - 1U;
+      auto len = MIN_MATCH;
+      while (i + len != n && src[match + len] == src[i + len]) {
+        ++len;
+      }
+      if (!detail::write_sequence(out, out_end, src + anchor, i - anchor,
+                                  i - match, len)) {
+        return 0U;
+      }
+      i += len;
+      anchor = i;
+      misses = 0U;
+      if (i - 2U <= last) {
+        table[detail::hash4(detail::read32(src + i - 2U))] =
+            static_cast<std::uint32_t>(i - 1U);
+      }
+    }
+  }
+
+  if (!detail::write_sequence(out, out_end, src + anchor, n - anchor, 0U,
+                              0U)) {
+    return 0U;
+  }
+  return static_cast<std::size_t>(out - dst);
+}
+
+// Decompresses n bytes into dst. Returns the decompressed size or
+// DECOMPRESS_ERROR for malformed input or if the output exceeds capacity.
+inline std::size_t decompress(std::uint8_t const* src, std::size_t const n,
+                              std::uint8_t* dst,
+                              std::size_t const capacity) noexcept {
+  auto in = src;
+  auto const in_end = src + n;
+  auto out = dst;
+  auto const out_end = dst + capacity;
+
+  while (in != in_end) {
+    auto const token = *in++;
+
+    auto lit_len = static_cast<std::size_t>(token >> 4U);
+    if (lit_len == 15U && !detail::read_length(in, in_end, lit_len)) {
+      return DECOMPRESS_ERROR;
+    }
+    if (lit_len > static_cast<std::size_t>(in_end - in) ||
+        lit_len > static_cast<std::size_t>(out_end - out)) {
+      return DECOMPRESS_ERROR;
+    }
+    if (lit_len != 0U) {
+      std::memcpy(out, in, lit_len);
+      in += lit_len;
+      out += lit_len;
+    }
+
+    if (in == in_end) {
+      break;
+    }
+
+    if (in_end - in < 2) {
+      return DECOMPRESS_ERROR;
+    }
+    auto const offset = static_cast<std::size_t>(in[0]) |
+                        (static_cast<std::size_t>(in[1]) << 8U);
+    in += 2;
+    auto match_len = static_cast<std::size_t>(token & 15U) + MIN_MATCH;
+    if ((token & 15U) == 15U && !detail::read_length(in, in_end, match_len)) {
+      return DECOMPRESS_ERROR;
+    }
+    if (offset == 0U || offset > static_cast<std::size_t>(out - dst) ||
+        match_len > static_cast<std::size_t>(out_end - out)) {
+      return DECOMPRESS_ERROR;
+    }
+
+    auto const match = out - offset;
+    if (offset >= match_len) {
+      std::memcpy(out, match, match_len);
+    } else {
+      for (auto i = std::size_t{0U}; i != match_len; ++i) {
+        out[i] = match[i];  // Overlapping: repeats the last offset bytes.
+      }
+    }
+    out += match_len;
+  }
+
+  return static_cast<std::size_t>(out - dst);
+}
+
+}  // namespace cista::lz
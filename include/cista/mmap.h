@@ -16,9 +16,17 @@
 #endif
 
 #include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "cista/aligned_alloc.h"
+#include "cista/flusher.h"
 #include "cista/next_power_of_2.h"
+#include "cista/paging.h"
 #include "cista/targets/file.h"
 
 #ifndef _WIN32
@@ -27,6 +35,71 @@
 
 namespace cista {
 
+// TRANSPARENT: advice::HUGEPAGE for the whole mapping.
+// EXPLICIT: MAP_HUGETLB (Windows: MEM_LARGE_PAGES) for ANONYMOUS mappings,
+// falls back to TRANSPARENT if no huge pages are available. Files on a
+// hugetlbfs mount (TMPFILE directory) are backed by huge pages anyway.
+enum class huge_pages { NONE, TRANSPARENT, EXPLICIT };
+
+// Mapped size when the mapping has to grow (resize() or reserve()):
+//   - POWER_OF_TWO: next power of two
+//   - FIXED_CHUNK: next multiple of chunk_size_
+//   - GEOMETRIC: at least factor_ times the current size
+//   - EXACT: exactly the requested size, for callers that reserve() a size
+//     estimate up front (as serialize() does)
+// The file is truncated to the used size when the mapping is destroyed.
+struct growth_policy {
+  enum class strategy { POWER_OF_TWO, FIXED_CHUNK, GEOMETRIC, EXACT };
+
+  static growth_policy power_of_two() { return {}; }
+  static growth_policy fixed_chunk(std::size_t const chunk_size) {
+    verify(chunk_size != 0U, "growth_policy: chunk size 0");
+    return {strategy::FIXED_CHUNK, chunk_size, 0.0};
+  }
+  static growth_policy geometric(double const factor) {
+    verify(factor > 1.0, "growth_policy: factor <= 1");
+    return {strategy::GEOMETRIC, 0U, factor};
+  }
+  static growth_policy exact() { return {strategy::EXACT, 0U, 0.0}; }
+
+  std::size_t grow(std::size_t const current,
+                   std::size_t const required) const {
+    if (strategy_ == strategy::FIXED_CHUNK) {
+      return to_next_multiple(required, chunk_size_);
+    } else if (strategy_ == strategy::GEOMETRIC) {
+      return std::max(required, static_cast<std::size_t>(
+                                    static_cast<double>(current) * factor_));
+    } else if (strategy_ == strategy::EXACT) {
+      return required;
+    } else {
+      return next_power_of_two(required);
+    }
+  }
+
+  strategy strategy_{strategy::POWER_OF_TWO};
+  std::size_t chunk_size_{0U};
+  double factor_{0.0};
+};
+
+// What the destructor syncs: the whole mapping (FULL), only the ranges
+// marked as dirty (DIRTY) or nothing (NONE, the OS writes back eventually).
+enum class close_sync { FULL, DIRTY, NONE };
+
+// Paging options, applied whenever the file is (re-)mapped.
+// close_sync_ / async_ / flusher_: sync on destruction, MS_ASYNC instead
+// of MS_SYNC, sync + unmap on the flusher thread instead of the caller.
+struct mmap_options {
+  growth_policy growth_{};
+  close_sync close_sync_{close_sync::FULL};
+  bool async_{false};
+  flusher* flusher_{nullptr};
+  advice advice_{advice::NORMAL};
+  huge_pages huge_pages_{huge_pages::NONE};
+  bool populate_{false};  // MAP_POPULATE, elsewhere advice::WILLNEED
+  bool lock_{false};  // lock all pages in memory
+  unsigned prefault_threads_{0U};  // > 0: prefault with this many threads
+};
+
 struct mmap {
   static constexpr auto const OFFSET = 0ULL;
   static constexpr auto const ENTIRE_FILE =
@@ -35,12 +108,13 @@ struct mmap {
     READ,
     WRITE,
     MODIFY,
-    TMPFILE  // requires directory path
+    TMPFILE,  // requires directory path
+    ANONYMOUS  // no file, path is ignored
   };
 
   static constexpr bool is_writable(protection const p) noexcept {
     return p == protection::WRITE || p == protection::MODIFY ||
-           p == protection::TMPFILE;
+           p == protection::TMPFILE || p == protection::ANONYMOUS;
   }
 
   static char const* fopen_mode(protection const p) noexcept {
@@ -48,30 +122,67 @@ struct mmap {
       case protection::MODIFY: return "r+";
       case protection::READ: return "r";
       case protection::WRITE:
-      case protection::TMPFILE: return "w+";
+      case protection::TMPFILE:
+      case protection::ANONYMOUS: return "w+";
     }
     return "w+";
   }
 
+  static file open(char const* path, protection const p) {
+    return p == protection::TMPFILE     ? open_tmpfile(path)
+           : p == protection::ANONYMOUS ? file{}
+                                        : file{path, fopen_mode(p)};
+  }
+
   mmap() = default;
 
   // note: protection::TMPFILE requires directory as path!
-  explicit mmap(char const* path, protection const prot = protection::WRITE)
-      : f_{prot == protection::TMPFILE ? open_tmpfile(path)
-                                       : file{path, fopen_mode(prot)}},
+  explicit mmap(char const* path, protection const prot = protection::WRITE,
+                mmap_options const& opt = {})
+      : f_{open(path, prot)},
         prot_{prot},
-        size_{f_.size()},
-        used_size_{f_.size()},
+        opt_{opt},
+        size_{prot == protection::ANONYMOUS ? 0U : f_.size()},
+        used_size_{size_},
         addr_{size_ == 0U ? nullptr : map()} {}
 
   ~mmap() {
-    if (addr_ != nullptr) {
-      sync();
-      size_ = used_size_;
-      unmap();
-      if (size_ != f_.size() && prot_ != protection::TMPFILE) {
-        resize_file();
+    if (addr_ != nullptr && opt_.flusher_ != nullptr) {
+      auto const f = opt_.flusher_;
+      auto m = std::make_shared<mmap>(std::move(*this));
+      m->opt_.flusher_ = nullptr;
+      // Errors are reported by the flusher: close() explicitly instead of
+      // running the (noexcept) destructor on a mapping that fails to sync.
+      f->defer([m = std::move(m)]() { m->close(); });
+      return;
+    }
+    close();
+  }
+
+  // Syncs as configured (close_sync_), unmaps and truncates the file to the
+  // used size. The mapping is released even if syncing fails.
+  void close() {
+    if (addr_ == nullptr) {
+      return;
+    }
+    auto error = std::exception_ptr{};
+    try {
+      if (opt_.close_sync_ == close_sync::FULL) {
+        sync(opt_.async_);
+      } else if (opt_.close_sync_ == close_sync::DIRTY) {
+        sync_dirty(opt_.async_);
       }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    unmap();
+    size_ = used_size_;
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    if (prot_ != protection::TMPFILE && prot_ != protection::ANONYMOUS &&
+        size_ != f_.size()) {
+      resize_file();
     }
   }
 
@@ -81,9 +192,11 @@ struct mmap {
   mmap(mmap&& o)
       : f_{std::move(o.f_)},
         prot_{o.prot_},
+        opt_{o.opt_},
         size_{o.size_},
         used_size_{o.used_size_},
-        addr_{o.addr_} {
+        addr_{o.addr_},
+        dirty_{std::move(o.dirty_)} {
 #ifdef _WIN32
     file_mapping_ = o.file_mapping_;
 #endif
@@ -93,9 +206,11 @@ struct mmap {
   mmap& operator=(mmap&& o) {
     f_ = std::move(o.f_);
     prot_ = o.prot_;
+    opt_ = o.opt_;
     size_ = o.size_;
     used_size_ = o.used_size_;
     addr_ = o.addr_;
+    dirty_ = std::move(o.dirty_);
 #ifdef _WIN32
     file_mapping_ = o.file_mapping_;
 #endif
@@ -135,22 +250,82 @@ struct mmap {
 #endif
   }
 
-  void sync() {
-    if ((prot_ == protection::WRITE || prot_ == protection::MODIFY) &&
-        addr_ != nullptr) {
+  // Writes changes back to the file. async: MS_ASYNC (only schedules the
+  // write back, returns immediately) instead of MS_SYNC.
+  void sync(bool const async = false) {
+    sync(0U, size_, async);
+    dirty_.clear();
+  }
+
+  void sync(std::size_t const offset, std::size_t const size,
+            bool const async = false) {
+    if ((prot_ != protection::WRITE && prot_ != protection::MODIFY) ||
+        addr_ == nullptr) {
+      return;
+    }
+    verify(offset <= size_ && size <= size_ - offset,
+           "mmap: sync out of bounds");
+    auto const r = page_range{data() + offset, size};
+    if (r.size_ == 0U) {
+      return;
+    }
 #ifdef _WIN32
-      verify(::FlushViewOfFile(addr_, size_) != 0, "flush error");
+    verify(::FlushViewOfFile(r.addr_, r.size_) != 0, "flush error");
+    if (!async) {
       verify(::FlushFileBuffers(f_.f_) != 0, "flush error");
+    }
 #else
-      verify(::msync(addr_, size_, MS_SYNC) == 0, "sync error");
+    verify(::msync(r.addr_, r.size_, async ? MS_ASYNC : MS_SYNC) == 0,
+           "sync error");
 #endif
+  }
+
+  // Dirty range tracking. Growing the mapping (resize) marks the new bytes
+  // as dirty. Writes through data() / operator[] to other ranges have to be
+  // marked explicitly for sync_dirty() / close_sync::DIRTY to pick them up.
+  void mark_dirty(std::size_t const offset, std::size_t const size) {
+    if (size == 0U) {
+      return;
+    }
+    auto const to = offset + size;
+    if (!dirty_.empty() && offset <= dirty_.back().second &&
+        to >= dirty_.back().first) {
+      dirty_.back().first = std::min(dirty_.back().first, offset);
+      dirty_.back().second = std::max(dirty_.back().second, to);
+      return;
+    }
+    dirty_.emplace_back(offset, to);
+    if (dirty_.size() > MAX_DIRTY_RANGES) {
+      merge_dirty();
+    }
+  }
+
+  // Syncs and clears the dirty ranges. Returns the number of bytes synced.
+  std::size_t sync_dirty(bool const async = false) {
+    merge_dirty();
+    auto n = std::size_t{0U};
+    for (auto const& [from, to] : dirty_) {
+      if (from < size_) {
+        sync(from, std::min(to, size_) - from, async);
+        n += std::min(to, size_) - from;
+      }
     }
+    dirty_.clear();
+    return n;
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> const& dirty_ranges() {
+    merge_dirty();
+    return dirty_;
   }
 
   void resize(std::size_t const new_size) {
     verify(is_writable(prot_), "read-only not resizable");
     if (size_ < new_size) {
-      resize_map(next_power_of_two(new_size));
+      resize_map(opt_.growth_.grow(size_, new_size));
+    }
+    if (new_size > used_size_) {
+      mark_dirty(used_size_, new_size - used_size_);
     }
     used_size_ = new_size;
   }
@@ -158,11 +333,33 @@ struct mmap {
   void reserve(std::size_t const new_size) {
     verify(is_writable(prot_), "read-only not resizable");
     if (size_ < new_size) {
-      resize_map(next_power_of_two(new_size));
+      resize_map(opt_.growth_.grow(size_, new_size));
     }
   }
 
   std::size_t size() const noexcept { return used_size_; }
+  std::size_t capacity() const noexcept { return size_; }
+
+  // Paging control for [offset, offset + size) of the mapping.
+  void advise(std::size_t const offset, std::size_t const size,
+              advice const a) const {
+    cista::advise(range_begin(offset, size), size, a);
+  }
+
+  std::size_t prefault(
+      std::size_t const offset = 0U, std::size_t const size = ENTIRE_FILE,
+      unsigned const n_threads = std::thread::hardware_concurrency()) const {
+    auto const n = std::min(size, used_size_ - std::min(offset, used_size_));
+    return cista::prefault(range_begin(offset, n), n, n_threads);
+  }
+
+  void lock(std::size_t const offset, std::size_t const size) const {
+    cista::lock_pages(range_begin(offset, size), size);
+  }
+
+  void unlock(std::size_t const offset, std::size_t const size) const {
+    cista::unlock_pages(range_begin(offset, size), size);
+  }
 
   std::string_view view() const noexcept {
     return {static_cast<char const*>(addr_), size()};
@@ -183,7 +380,78 @@ struct mmap {
   }
 
 private:
+  static constexpr auto const MAX_DIRTY_RANGES = std::size_t{1024U};
+
+  // Sorts and merges overlapping or adjacent ranges. Too many ranges are
+  // coarsened by merging neighbours with the smallest gaps first.
+  void merge_dirty() {
+    std::sort(dirty_.begin(), dirty_.end());
+    auto out = std::size_t{0U};
+    for (auto i = std::size_t{0U}; i != dirty_.size(); ++i) {
+      if (out != 0U && dirty_[i].first <= dirty_[out - 1U].second) {
+        dirty_[out - 1U].second =
+            std::max(dirty_[out - 1U].second, dirty_[i].second);
+      } else {
+        dirty_[out++] = dirty_[i];
+      }
+    }
+    dirty_.resize(out);
+
+    while (dirty_.size() > MAX_DIRTY_RANGES / 2U) {
+      auto gaps = std::vector<std::size_t>{};
+      for (auto i = std::size_t{1U}; i < dirty_.size(); ++i) {
+        gaps.emplace_back(dirty_[i].first - dirty_[i - 1U].second);
+      }
+      auto const median =
+          gaps.begin() + static_cast<std::ptrdiff_t>(gaps.size() / 2U);
+      std::nth_element(gaps.begin(), median, gaps.end());
+      auto const max_gap = *median;
+      out = 1U;
+      for (auto i = std::size_t{1U}; i != dirty_.size(); ++i) {
+        if (dirty_[i].first - dirty_[out - 1U].second <= max_gap) {
+          dirty_[out - 1U].second = dirty_[i].second;
+        } else {
+          dirty_[out++] = dirty_[i];
+        }
+      }
+      dirty_.resize(out);
+    }
+  }
+
+  std::uint8_t const* range_begin(std::size_t const offset,
+                                  std::size_t const size) const {
+    verify(offset <= used_size_ && size <= used_size_ - offset,
+           "mmap: range out of bounds");
+    return data() + offset;
+  }
+
+  // Applies the options to a newly mapped range.
+  // populated: mapped with MAP_POPULATE, thp: transparent huge pages allowed
+  void apply_options(void* addr, std::size_t const size, bool const populated,
+                     bool const thp = true) {
+    if (opt_.advice_ != advice::NORMAL) {
+      cista::advise(addr, size, opt_.advice_);
+    }
+    if (thp && opt_.huge_pages_ != huge_pages::NONE) {
+      cista::advise(addr, size, advice::HUGEPAGE);
+    }
+    if (opt_.populate_ && !populated) {
+      cista::advise(addr, size, advice::WILLNEED);
+    }
+    if (opt_.prefault_threads_ != 0U) {
+      cista::prefault(addr, size, opt_.prefault_threads_);
+    }
+    if (opt_.lock_) {
+      cista::lock_pages(addr, size);
+    }
+  }
+
   void unmap() {
+    if (prot_ == protection::ANONYMOUS) {
+      release_anonymous(addr_, size_);
+      addr_ = nullptr;
+      return;
+    }
 #ifdef _WIN32
     if (addr_ != nullptr) {
       verify(::UnmapViewOfFile(addr_), "unmap error");
@@ -200,7 +468,62 @@ private:
 #endif
   }
 
+  static void release_anonymous(void* addr, std::size_t const size) {
+    if (addr == nullptr) {
+      return;
+    }
+#ifdef _WIN32
+    CISTA_UNUSED_PARAM(size)
+    verify(::VirtualFree(addr, 0U, MEM_RELEASE) != 0, "unmap error");
+#else
+    ::munmap(addr, size);
+#endif
+  }
+
+  void* map_anonymous() {
+    auto const explicit_huge = opt_.huge_pages_ == huge_pages::EXPLICIT;
+#ifdef _WIN32
+    auto const large_page = ::GetLargePageMinimum();
+    if (explicit_huge && large_page != 0U) {
+      auto const addr = ::VirtualAlloc(
+          nullptr, to_next_multiple(size_, large_page),
+          MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+      if (addr != nullptr) {  // Requires SeLockMemoryPrivilege.
+        size_ = to_next_multiple(size_, large_page);
+        apply_options(addr, size_, false);
+        return addr;
+      }
+    }
+    auto const addr = ::VirtualAlloc(nullptr, size_, MEM_RESERVE | MEM_COMMIT,
+                                     PAGE_READWRITE);
+    verify(addr != nullptr, "map error");
+#else
+    auto const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+    if (explicit_huge) {
+      auto const huge_size = to_next_multiple(size_, HUGE_PAGE_SIZE);
+      auto const addr = ::mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+                               flags | MAP_HUGETLB, -1, OFFSET);
+      if (addr != MAP_FAILED) {  // Requires reserved huge pages.
+        size_ = huge_size;
+        apply_options(addr, size_, false, false);
+        return addr;
+      }
+    }
+#endif
+    auto const addr =
+        ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, flags, -1, OFFSET);
+    verify(addr != MAP_FAILED, "map error");
+#endif
+    apply_options(addr, size_, false);
+    return addr;
+  }
+
   void* map() {
+    if (prot_ == protection::ANONYMOUS) {
+      return map_anonymous();
+    }
+
 #ifdef _WIN32
     auto const size_low = static_cast<DWORD>(size_);
 #ifdef _WIN64
@@ -218,14 +541,22 @@ private:
         fm, prot_ == protection::READ ? FILE_MAP_READ : FILE_MAP_WRITE, OFFSET,
         OFFSET, size_);
     verify(addr != nullptr, "map error");
+    apply_options(addr, size_, false);
 
     return addr;
 #else
+    auto flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (opt_.populate_) {
+      flags |= MAP_POPULATE;
+    }
+#endif
     auto const addr =
         ::mmap(nullptr, size_,
                prot_ == protection::READ ? PROT_READ : PROT_READ | PROT_WRITE,
-               MAP_SHARED, f_.fd(), OFFSET);
+               flags, f_.fd(), OFFSET);
     verify(addr != MAP_FAILED, "map error");
+    apply_options(addr, size_, flags != MAP_SHARED);
     return addr;
 #endif
   }
@@ -250,11 +581,59 @@ private:
 #endif
   }
 
+  // Grows the mapping in place (or moves it) without unmapping.
+  // The file stays sparse: new pages are allocated when they are written.
+  bool remap(std::size_t const new_size) {
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+    if (addr_ == nullptr) {
+      return false;
+    }
+    auto const old_size = size_;
+    if (prot_ != protection::ANONYMOUS) {
+      size_ = new_size;
+      resize_file();
+      size_ = old_size;
+    }
+    auto const addr = ::mremap(addr_, old_size, new_size, MREMAP_MAYMOVE);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    addr_ = addr;
+    size_ = new_size;
+    apply_options(static_cast<std::uint8_t*>(addr_) + old_size,
+                  new_size - old_size, false);
+    return true;
+#else
+    CISTA_UNUSED_PARAM(new_size)
+    return false;
+#endif
+  }
+
   void resize_map(std::size_t const new_size) {
     if (prot_ == protection::READ) {
       return;
     }
 
+    if (prot_ == protection::ANONYMOUS) {
+      if (remap(new_size)) {
+        return;
+      }
+
+      auto const old_addr = addr_;
+      auto const old_size = size_;
+      size_ = new_size;
+      addr_ = map();
+      if (old_addr != nullptr) {
+        std::memcpy(addr_, old_addr, std::min(used_size_, old_size));
+        release_anonymous(old_addr, old_size);
+      }
+      return;
+    }
+
+    if (remap(new_size)) {
+      return;
+    }
+
     unmap();
     size_ = new_size;
     resize_file();
@@ -263,9 +642,11 @@ private:
 
   file f_;
   protection prot_;
+  mmap_options opt_;
   std::size_t size_;
   std::size_t used_size_;
   void* addr_;
+  std::vector<std::pair<std::size_t, std::size_t>> dirty_;
 #ifdef _WIN32
   HANDLE file_mapping_;
 #endif
@@ -15,6 +15,12 @@ enum class mode {
   WITH_STATIC_VERSION = 1U << 6U,
   SKIP_INTEGRITY = 1U << 7U,
   SKIP_VERSION = 1U << 8U,
+  WITH_TRAILER_INTEGRITY = 1U << 9U,
+  WITH_RELOCATIONS = 1U << 10U,
+  WITH_CHUNKED_INTEGRITY = 1U << 11U,
+  DEDUP = 1U << 12U,
+  ARENA = 1U << 13U,
+  _LAZY = 1U << 28U,
   _CONST = 1U << 29U,
   _PHASE_II = 1U << 30U
 };
@@ -0,0 +1,190 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "cista/parallel_for.h"
+#include "cista/unused_param.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Paging control for memory mapped data. All functions take arbitrary
+// (not page aligned) ranges and apply to every page the range touches
+// (except advise() with DONTNEED).
+// Containers (anything with data() and size()) can be passed directly,
+// e.g. prefault(db->entries_) to fault in only the vector's elements.
+
+// HUGEPAGE: transparent huge pages (Linux), a hint that is ignored where
+// unsupported (the other advice fails with an exception).
+enum class advice {
+  NORMAL,
+  SEQUENTIAL,
+  RANDOM,
+  WILLNEED,
+  DONTNEED,
+  HUGEPAGE
+};
+
+inline std::size_t page_size() {
+#ifdef _WIN32
+  static auto const size = []() {
+    auto info = SYSTEM_INFO{};
+    ::GetSystemInfo(&info);
+    return static_cast<std::size_t>(info.dwPageSize);
+  }();
+#else
+  static auto const size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+  return size;
+}
+
+struct page_range {
+  page_range(void const* p, std::size_t const size) {
+    auto const page = page_size();
+    auto const from = reinterpret_cast<std::uintptr_t>(p) / page * page;
+    auto const to =
+        (reinterpret_cast<std::uintptr_t>(p) + size + page - 1U) / page * page;
+    addr_ = reinterpret_cast<void*>(from);
+    size_ = size == 0U ? 0U : static_cast<std::size_t>(to - from);
+  }
+
+  // Only the pages completely inside [p, p + size).
+  static page_range inner(void const* p, std::size_t const size) {
+    auto const page = page_size();
+    auto const from =
+        (reinterpret_cast<std::uintptr_t>(p) + page - 1U) / page * page;
+    auto const to = (reinterpret_cast<std::uintptr_t>(p) + size) / page * page;
+    auto r = page_range{reinterpret_cast<void const*>(from), 0U};
+    r.size_ = to > from ? static_cast<std::size_t>(to - from) : 0U;
+    return r;
+  }
+
+  void* addr_;
+  std::size_t size_;
+};
+
+// DONTNEED drops page contents: it applies only to the pages that lie
+// completely inside the range so neighbouring data is not discarded.
+inline void advise(void const* p, std::size_t const size, advice const a) {
+  auto const r = a == advice::DONTNEED ? page_range::inner(p, size)
+                                       : page_range{p, size};
+  if (r.size_ == 0U) {
+    return;
+  }
+#ifdef _WIN32
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+  if (a == advice::WILLNEED) {
+    auto entry = WIN32_MEMORY_RANGE_ENTRY{r.addr_, r.size_};
+    ::PrefetchVirtualMemory(::GetCurrentProcess(), 1U, &entry, 0U);
+  }
+#else
+  CISTA_UNUSED_PARAM(a)
+#endif
+#else
+  if (a == advice::HUGEPAGE) {
+#ifdef MADV_HUGEPAGE
+    ::madvise(r.addr_, r.size_, MADV_HUGEPAGE);
+#endif
+    return;
+  }
+  auto const flag = a == advice::SEQUENTIAL ? MADV_SEQUENTIAL
+                    : a == advice::RANDOM   ? MADV_RANDOM
+                    : a == advice::WILLNEED ? MADV_WILLNEED
+                    : a == advice::DONTNEED ? MADV_DONTNEED
+                                            : MADV_NORMAL;
+  verify(::madvise(r.addr_, r.size_, flag) == 0, "madvise failed");
+#endif
+}
+
+// Locking counts against the RLIMIT_MEMLOCK (Windows: working set) limit.
+inline void lock_pages(void const* p, std::size_t const size) {
+  auto const r = page_range{p, size};
+  if (r.size_ == 0U) {
+    return;
+  }
+#ifdef _WIN32
+  verify(::VirtualLock(r.addr_, r.size_) != 0, "VirtualLock failed");
+#else
+  verify(::mlock(r.addr_, r.size_) == 0, "mlock failed");
+#endif
+}
+
+inline void unlock_pages(void const* p, std::size_t const size) {
+  auto const r = page_range{p, size};
+  if (r.size_ == 0U) {
+    return;
+  }
+#ifdef _WIN32
+  verify(::VirtualUnlock(r.addr_, r.size_) != 0, "VirtualUnlock failed");
+#else
+  verify(::munlock(r.addr_, r.size_) == 0, "munlock failed");
+#endif
+}
+
+// Touches one byte per page with n_threads threads so the page faults
+// (reading from disk for file mappings) are handled in parallel.
+// Returns the number of pages touched.
+inline std::size_t prefault(
+    void const* p, std::size_t const size,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  auto const r = page_range{p, size};
+  auto const page = page_size();
+  auto const n_pages = r.size_ / page;
+  auto const base = static_cast<std::uint8_t const*>(r.addr_);
+  auto const touch = [&](std::size_t const from, std::size_t const to) {
+    for (auto i = from; i != to; ++i) {
+      static_cast<void>(
+          *static_cast<std::uint8_t const volatile*>(base + i * page));
+    }
+  };
+
+  auto const n_workers = std::max(
+      std::size_t{1U}, std::min(static_cast<std::size_t>(n_threads), n_pages));
+  auto const per_worker = (n_pages + n_workers - 1U) / n_workers;
+  run_workers(n_workers, [&](std::size_t const worker) {
+    auto const from = std::min(n_pages, worker * per_worker);
+    touch(from, std::min(n_pages, from + per_worker));
+  });
+  return n_pages;
+}
+
+template <typename Container>
+auto advise(Container const& c, advice const a) -> decltype(c.data(), void()) {
+  advise(c.data(), c.size() * sizeof(*c.data()), a);
+}
+
+template <typename Container>
+auto lock_pages(Container const& c) -> decltype(c.data(), void()) {
+  lock_pages(c.data(), c.size() * sizeof(*c.data()));
+}
+
+template <typename Container>
+auto unlock_pages(Container const& c) -> decltype(c.data(), void()) {
+  unlock_pages(c.data(), c.size() * sizeof(*c.data()));
+}
+
+template <typename Container>
+auto prefault(Container const& c,
+              unsigned const n_threads = std::thread::hardware_concurrency())
+    -> decltype(c.data(), std::size_t{}) {
+  return prefault(c.data(), c.size() * sizeof(*c.data()), n_threads);
+}
+
+}  // namespace cista
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cista {
+
+// Runs fn(worker) for worker in [0, n_workers): worker 0 on the calling
+// thread, the others on new threads. All started threads are joined before
+// it returns - also if starting a thread or fn(0) throws. fn must not throw
+// on the other threads (see parallel_for).
+template <typename Fn>
+void run_workers(std::size_t const n_workers, Fn&& fn) {
+  struct joiner {
+    joiner() = default;
+    joiner(joiner const&) = delete;
+    joiner& operator=(joiner const&) = delete;
+    ~joiner() {
+      for (auto& t : threads_) {
+        t.join();
+      }
+    }
+    std::vector<std::thread> threads_;
+  } j;
+  for (auto i = std::size_t{1U}; i < n_workers; ++i) {
+    j.threads_.emplace_back([&fn, i]() { fn(i); });
+  }
+  if (n_workers != 0U) {
+    fn(std::size_t{0U});
+  }
+}
+
+// Calls fn(i) for i in [0, n) on up to n_threads threads (including the
+// calling thread), distributing the items dynamically. After the first
+// exception no further items are started, it is rethrown when all threads
+// are done.
+template <typename Fn>
+void parallel_for(std::size_t const n, unsigned const n_threads, Fn&& fn) {
+  auto next = std::atomic_size_t{0U};
+  auto error = std::exception_ptr{};
+  auto error_mutex = std::mutex{};
+  run_workers(std::min(static_cast<std::size_t>(std::max(n_threads, 1U)), n),
+              [&](std::size_t) {
+                try {
+                  for (auto i = next++; i < n; i = next++) {
+                    fn(i);
+                  }
+                } catch (...) {
+                  auto const lock = std::lock_guard{error_mutex};
+                  if (!error) {
+                    error = std::current_exception();
+                  }
+                  next = n;
+                }
+              });
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace cista
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "cista/endian/conversion.h"
+#include "cista/mode.h"
+#include "cista/offset_t.h"
+#include "cista/parallel_for.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Relocation table (mode::WITH_RELOCATIONS): positions of all raw pointer
+// slots in the image. Positions are sorted and delta encoded (LEB128) in
+// segments of RELOCATION_SEGMENT_SIZE entries. Each segment stores its first
+// position absolute, so segments can be applied independently.
+//
+// Layout (integers in image endianness, the table is 8 byte aligned):
+//   n_slots, n_segments                      (std::uint64_t)
+//   n_segments x (first_pos, data_offset)   (std::uint64_t)
+//   LEB128 deltas of all segments
+// The last 8 bytes of the image (before a trailer checksum) store the
+// position of the table.
+constexpr auto const RELOCATION_SEGMENT_SIZE = std::size_t{4096U};
+
+template <mode const Mode>
+void encode_relocations(std::vector<offset_t>& positions,
+                        std::vector<std::uint8_t>& out) {
+  std::sort(begin(positions), end(positions));
+  positions.erase(std::unique(begin(positions), end(positions)),
+                  end(positions));
+
+  auto const n_slots = positions.size();
+  auto const n_segments =
+      (n_slots + RELOCATION_SEGMENT_SIZE - 1U) / RELOCATION_SEGMENT_SIZE;
+
+  auto deltas = std::vector<std::uint8_t>{};
+  auto segments = std::vector<std::uint64_t>{};
+  segments.reserve(2U * n_segments);
+  for (auto i = std::size_t{0U}; i != n_slots; ++i) {
+    auto const pos = static_cast<std::uint64_t>(positions[i]);
+    if (i % RELOCATION_SEGMENT_SIZE == 0U) {
+      segments.emplace_back(pos);
+      segments.emplace_back(deltas.size());
+      continue;
+    }
+    for (auto delta = pos - static_cast<std::uint64_t>(positions[i - 1U]);;) {
+      auto const byte = static_cast<std::uint8_t>(delta & 0x7FU);
+      delta >>= 7U;
+      if (delta == 0U) {
+        deltas.emplace_back(byte);
+        break;
+      }
+      deltas.emplace_back(static_cast<std::uint8_t>(byte | 0x80U));
+    }
+  }
+
+  auto const append = [&](std::uint64_t const x) {
+    auto const v = convert_endian<Mode>(x);
+    auto const ptr = reinterpret_cast<std::uint8_t const*>(&v);
+    out.insert(end(out), ptr, ptr + sizeof(v));
+  };
+  out.clear();
+  append(n_slots);
+  append(n_segments);
+  for (auto const s : segments) {
+    append(s);
+  }
+  out.insert(end(out), begin(deltas), end(deltas));
+}
+
+template <mode const Mode>
+struct relocation_table {
+  relocation_table(std::uint8_t const* from, std::uint8_t const* to)
+      : from_{from} {
+    verify(to - from >= 2 * static_cast<std::ptrdiff_t>(sizeof(std::uint64_t)),
+           "relocation table: too small");
+    n_slots_ = read(0U);
+    n_segments_ = read(1U);
+    verify(n_segments_ == (n_slots_ + RELOCATION_SEGMENT_SIZE - 1U) /
+                              RELOCATION_SEGMENT_SIZE,
+           "relocation table: invalid segment count");
+    // Header (n_slots, n_segments) and one (first_pos, data_offset) pair
+    // per segment.
+    verify(n_segments_ <= static_cast<std::size_t>(to - from) /
+                                  (2U * sizeof(std::uint64_t)) -
+                              1U,
+           "relocation table: segments out of bounds");
+    deltas_ = from + (2U + 2U * n_segments_) * sizeof(std::uint64_t);
+    deltas_end_ = to;
+  }
+
+  std::size_t n_slots() const noexcept { return n_slots_; }
+  std::size_t n_segments() const noexcept { return n_segments_; }
+
+  // Calls fn(offset_t pos) for every slot position of the segment.
+  template <typename Fn>
+  void for_each_slot(std::size_t const segment, Fn&& fn) const {
+    auto pos = read(2U + 2U * segment);
+    auto data = deltas_ + read(3U + 2U * segment);
+    auto const data_end = segment + 1U == n_segments_
+                              ? deltas_end_
+                              : deltas_ + read(5U + 2U * segment);
+    verify(deltas_ <= data && data <= data_end && data_end <= deltas_end_,
+           "relocation table: invalid segment");
+
+    auto const n = std::min(RELOCATION_SEGMENT_SIZE,
+                            n_slots_ - segment * RELOCATION_SEGMENT_SIZE);
+    verify(static_cast<std::size_t>(data_end - data) >= n - 1U,
+           "relocation table: segment too short");
+    fn(static_cast<offset_t>(pos));
+    for (auto i = std::size_t{1U}; i < n; ++i) {
+      auto const first = *data++;
+      auto delta = static_cast<std::uint64_t>(first);
+      if (first >= 0x80U) {
+        delta &= 0x7FU;
+        for (auto shift = 7U;; shift += 7U) {
+          verify(data < data_end && shift < 64U,
+                 "relocation table: invalid delta");
+          auto const byte = *data++;
+          delta |= static_cast<std::uint64_t>(byte & 0x7FU) << shift;
+          if (byte < 0x80U) {
+            break;
+          }
+        }
+      }
+      pos += delta;
+      fn(static_cast<offset_t>(pos));
+    }
+  }
+
+  std::uint64_t read(std::size_t const idx) const noexcept {
+    auto x = std::uint64_t{0U};
+    std::memcpy(&x, from_ + idx * sizeof(x), sizeof(x));
+    return convert_endian<Mode>(x);
+  }
+
+  std::uint8_t const* from_;
+  std::uint8_t const* deltas_{nullptr};
+  std::uint8_t const* deltas_end_{nullptr};
+  std::size_t n_slots_{0U}, n_segments_{0U};
+};
+
+// Turns the stored offsets of all slots in segments [first, last) into
+// pointers. No bounds checks: only used for unchecked deserialization.
+template <mode const Mode>
+void apply_relocations(std::uint8_t* base, relocation_table<Mode> const& t,
+                       std::size_t const first, std::size_t const last) {
+  for (auto s = first; s != last; ++s) {
+    t.for_each_slot(s, [&](offset_t const pos) {
+      auto const slot = base + pos;
+      auto offset = offset_t{0};
+      std::memcpy(&offset, slot, sizeof(offset));
+      offset = convert_endian<Mode>(offset);
+      auto const ptr = offset == NULLPTR_OFFSET ? nullptr : slot + offset;
+      std::memcpy(slot, &ptr, sizeof(ptr));
+    });
+  }
+}
+
+// Applies contiguous ranges of segments on n_threads threads.
+template <mode const Mode>
+void apply_relocations(std::uint8_t* base, relocation_table<Mode> const& t,
+                       unsigned const n_threads) {
+  auto const n_segments = t.n_segments();
+  auto const n_workers = std::max(
+      std::size_t{1U},
+      std::min(static_cast<std::size_t>(n_threads), n_segments));
+  auto const per_worker = (n_segments + n_workers - 1U) / n_workers;
+  if (n_workers == 1U) {
+    apply_relocations(base, t, 0U, n_segments);
+    return;
+  }
+
+  auto errors = std::vector<std::exception_ptr>(n_workers);
+  auto const work = [&](std::size_t const worker) {
+    try {
+      auto const first = worker * per_worker;
+      apply_relocations(base, t, first,
+                        std::min(n_segments, first + per_worker));
+    } catch (...) {
+      errors[worker] = std::current_exception();
+    }
+  };
+
+  run_workers((n_segments + per_worker - 1U) / per_worker, work);
+  for (auto const& e : errors) {
+    if (e != nullptr) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+}  // namespace cista
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cista/chunked_hash.h"
+#include "cista/endian/conversion.h"
+#include "cista/mmap.h"
+#include "cista/mode.h"
+#include "cista/parallel_for.h"
+#include "cista/serialization.h"
+#include "cista/targets/buf.h"
+#include "cista/targets/file.h"
+#include "cista/type_hash/type_hash.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// File with several independent images ("sections"), each with its own root
+// type, mode and alignment. Layout (integers little endian):
+//
+//   sections_header
+//   section_entry[n_sections]   directory: name, type hash, mode,
+//                               integrity hash, position
+//   images                      each at a multiple of its alignment
+//
+// Readers map and check only the sections they load.
+constexpr auto const SECTIONS_MAGIC = std::uint64_t{0x4345534154534943ULL};
+constexpr auto const SECTIONS_VERSION = std::uint64_t{1U};
+
+struct sections_header {
+  std::uint64_t magic_, version_, n_sections_;
+};
+
+struct section_entry {
+  static constexpr auto const NAME_SIZE = std::size_t{48U};
+
+  std::string_view name() const noexcept {
+    auto const end = std::find(name_, name_ + NAME_SIZE, '\0');
+    return {name_, static_cast<std::size_t>(end - name_)};
+  }
+
+  char name_[NAME_SIZE];
+  std::uint64_t type_hash_, mode_, integrity_algo_, integrity_, offset_, size_,
+      alignment_;
+};
+
+// Mode bits that affect the image layout: checking flags may differ between
+// writer and reader.
+constexpr std::uint64_t section_mode(mode const m) noexcept {
+  return static_cast<std::uint64_t>(m) &
+         ~static_cast<std::uint64_t>(mode::UNCHECKED | mode::DEEP_CHECK);
+}
+
+template <typename T>
+void convert_section_endian(T& x) noexcept {
+  x = convert_endian<mode::NONE>(x);
+}
+
+inline void convert_section_endian(sections_header& h) noexcept {
+  convert_section_endian(h.magic_);
+  convert_section_endian(h.version_);
+  convert_section_endian(h.n_sections_);
+}
+
+inline void convert_section_endian(section_entry& e) noexcept {
+  convert_section_endian(e.type_hash_);
+  convert_section_endian(e.mode_);
+  convert_section_endian(e.integrity_algo_);
+  convert_section_endian(e.integrity_);
+  convert_section_endian(e.offset_);
+  convert_section_endian(e.size_);
+  convert_section_endian(e.alignment_);
+}
+
+// Serialized section, not yet written. Sections of different datasets can
+// be created concurrently.
+struct section {
+  std::string name_;
+  std::uint64_t type_hash_, mode_;
+  integrity_hash integrity_algo_;
+  hash_t integrity_;
+  std::size_t alignment_;
+  byte_buf data_;
+};
+
+template <mode const Mode = mode::NONE, typename T>
+section make_section(std::string_view name, T const& value,
+                     std::size_t const alignment = 64U) {
+  verify(name.size() < section_entry::NAME_SIZE, "sections: name too long");
+  verify(alignment != 0U && (alignment & (alignment - 1U)) == 0U,
+         "sections: alignment has to be a power of two");
+  auto data = serialize<Mode>(value);
+  auto const integrity = chunk_list_hash(
+      std::string_view{reinterpret_cast<char const*>(data.data()),
+                       data.size()},
+      DEFAULT_INTEGRITY_HASH);
+  return section{std::string{name},      type_hash<T>(), section_mode(Mode),
+                 DEFAULT_INTEGRITY_HASH, integrity,      alignment,
+                 std::move(data)};
+}
+
+// Writes the directory and copies the sections with n_threads threads.
+inline void write_sections(
+    std::filesystem::path const& p, std::vector<section> const& sections,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  auto header = sections_header{SECTIONS_MAGIC, SECTIONS_VERSION,
+                                sections.size()};
+  auto directory = std::vector<section_entry>(sections.size());
+  auto pos = sizeof(sections_header) + sections.size() * sizeof(section_entry);
+  for (auto i = std::size_t{0U}; i != sections.size(); ++i) {
+    auto const& s = sections[i];
+    verify(std::none_of(begin(sections), begin(sections) + i,
+                        [&](section const& o) { return o.name_ == s.name_; }),
+           "sections: duplicate name");
+
+    auto& e = directory[i];
+    std::memset(e.name_, 0, sizeof(e.name_));
+    std::memcpy(e.name_, s.name_.data(), s.name_.size());
+    pos = to_next_multiple(pos, s.alignment_);
+    e.type_hash_ = s.type_hash_;
+    e.mode_ = s.mode_;
+    e.integrity_algo_ = static_cast<std::uint64_t>(s.integrity_algo_);
+    e.integrity_ = s.integrity_;
+    e.offset_ = pos;
+    e.size_ = s.data_.size();
+    e.alignment_ = s.alignment_;
+    pos += s.data_.size();
+  }
+
+  auto m = mmap{p.generic_string().c_str(), mmap::protection::WRITE};
+  m.resize(pos);
+
+  convert_section_endian(header);
+  std::memcpy(m.data(), &header, sizeof(header));
+  for (auto i = std::size_t{0U}; i != directory.size(); ++i) {
+    auto e = directory[i];
+    convert_section_endian(e);
+    std::memcpy(m.data() + sizeof(header) + i * sizeof(section_entry), &e,
+                sizeof(e));
+  }
+
+  parallel_for(sections.size(), n_threads, [&](std::size_t const i) {
+    std::memcpy(m.data() + directory[i].offset_, sections[i].data_.data(),
+                sections[i].data_.size());
+  });
+}
+
+// Private (copy on write) mapping of [offset, offset + size) of a file:
+// in place deserialization does not modify the file.
+struct mapped_range {
+  mapped_range(file const& f, std::size_t const offset,
+               std::size_t const size) {
+    verify(size != 0U, "mapped_range: empty");
+#ifdef _WIN32
+    auto info = SYSTEM_INFO{};
+    ::GetSystemInfo(&info);
+    auto const granularity =
+        static_cast<std::size_t>(info.dwAllocationGranularity);
+#else
+    auto const granularity = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+    auto const map_offset = offset - offset % granularity;
+    map_size_ = offset - map_offset + size;
+
+#ifdef _WIN32
+    auto const fm =
+        ::CreateFileMapping(f.f_, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    verify(fm != NULL, "file mapping error");
+    addr_ = ::MapViewOfFile(
+        fm, FILE_MAP_COPY,
+        static_cast<DWORD>(static_cast<std::uint64_t>(map_offset) >> 32U),
+        static_cast<DWORD>(map_offset & 0xFFFFFFFFU), map_size_);
+    ::CloseHandle(fm);
+    verify(addr_ != nullptr, "map error");
+#else
+    addr_ = ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                   f.fd(), static_cast<off_t>(map_offset));
+    verify(addr_ != MAP_FAILED, "map error");
+#endif
+    data_ = static_cast<std::uint8_t*>(addr_) + (offset - map_offset);
+    size_ = size;
+  }
+
+  mapped_range(mapped_range const&) = delete;
+  mapped_range& operator=(mapped_range const&) = delete;
+
+  mapped_range(mapped_range&& o) noexcept
+      : addr_{o.addr_}, map_size_{o.map_size_}, data_{o.data_}, size_{o.size_} {
+    o.addr_ = nullptr;
+  }
+
+  mapped_range& operator=(mapped_range&& o) noexcept {
+    unmap();
+    addr_ = o.addr_;
+    map_size_ = o.map_size_;
+    data_ = o.data_;
+    size_ = o.size_;
+    o.addr_ = nullptr;
+    return *this;
+  }
+
+  ~mapped_range() { unmap(); }
+
+  void unmap() noexcept {
+    if (addr_ != nullptr) {
+#ifdef _WIN32
+      ::UnmapViewOfFile(addr_);
+#else
+      ::munmap(addr_, map_size_);
+#endif
+      addr_ = nullptr;
+    }
+  }
+
+  std::uint8_t* data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+
+  void* addr_{nullptr};
+  std::size_t map_size_{0U};
+  std::uint8_t* data_{nullptr};
+  std::size_t size_{0U};
+};
+
+template <typename T>
+struct loaded_section {
+  T* get() const noexcept { return el_; }
+  T* operator->() const noexcept { return el_; }
+  T& operator*() const noexcept { return *el_; }
+
+  mapped_range mem_;
+  T* el_;
+};
+
+struct sections_file {
+  explicit sections_file(std::filesystem::path const& p)
+      : f_{p.generic_string().c_str(), "r"} {
+    auto const file_size = f_.size();
+    verify(file_size >= sizeof(sections_header), "sections: invalid file");
+
+    auto header = sections_header{};
+    {
+      auto const m = mapped_range{f_, 0U, sizeof(header)};
+      std::memcpy(&header, m.data(), sizeof(header));
+    }
+    convert_section_endian(header);
+    verify(header.magic_ == SECTIONS_MAGIC, "sections: invalid magic");
+    verify(header.version_ == SECTIONS_VERSION, "sections: unknown version");
+    verify(header.n_sections_ <=
+               (file_size - sizeof(header)) / sizeof(section_entry),
+           "sections: directory out of bounds");
+
+    directory_.resize(header.n_sections_);
+    if (!directory_.empty()) {
+      auto const m = mapped_range{f_, sizeof(header),
+                                  directory_.size() * sizeof(section_entry)};
+      std::memcpy(directory_.data(), m.data(), m.size());
+    }
+    for (auto& e : directory_) {
+      convert_section_endian(e);
+      verify(e.offset_ <= file_size && e.size_ <= file_size - e.offset_,
+             "sections: section out of bounds");
+    }
+  }
+
+  section_entry const* find(std::string_view name) const noexcept {
+    auto const it =
+        std::find_if(begin(directory_), end(directory_),
+                     [&](section_entry const& e) { return e.name() == name; });
+    return it == end(directory_) ? nullptr : &*it;
+  }
+
+  bool contains(std::string_view name) const noexcept {
+    return find(name) != nullptr;
+  }
+
+  // Maps the section, checks type, mode and integrity hash and deserializes.
+  template <typename T, mode const Mode = mode::NONE>
+  loaded_section<T> load(std::string_view name) const {
+    auto const e = find(name);
+    verify(e != nullptr, "sections: not found");
+    verify(e->type_hash_ == type_hash<T>(), "sections: type mismatch");
+    verify(e->mode_ == section_mode(Mode), "sections: mode mismatch");
+
+    auto mem = mapped_range{f_, static_cast<std::size_t>(e->offset_),
+                            static_cast<std::size_t>(e->size_)};
+    verify(chunk_list_hash(
+               std::string_view{reinterpret_cast<char const*>(mem.data()),
+                                mem.size()},
+               static_cast<integrity_hash>(e->integrity_algo_)) ==
+               e->integrity_,
+           "sections: integrity check failed");
+    auto const el = deserialize<T, Mode>(mem.data(), mem.data() + mem.size());
+    return loaded_section<T>{std::move(mem), el};
+  }
+
+  file f_;
+  std::vector<section_entry> directory_;
+};
+
+}  // namespace cista
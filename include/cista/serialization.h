@@ -1,27 +1,40 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <limits>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <set>
+#include <thread>
 #include <vector>
 
 #include "cista/aligned_alloc.h"
+#include "cista/arena.h"
 #include "cista/cista_member_offset.h"
 #include "cista/containers.h"
 #include "cista/decay.h"
+#include "cista/endian/bulk_swap.h"
 #include "cista/endian/conversion.h"
 #include "cista/free_self_allocated.h"
 #include "cista/hash.h"
+#include "cista/is_offset_only.h"
+#include "cista/is_pointer_free.h"
 #include "cista/mode.h"
 #include "cista/offset_t.h"
+#include "cista/parallel_for.h"
 #include "cista/reflection/for_each_field.h"
+#include "cista/relocations.h"
 #include "cista/serialized_size.h"
 #include "cista/strong.h"
 #include "cista/targets/buf.h"
 #include "cista/targets/file.h"
+#include "cista/targets/recorder.h"
+#include "cista/targets/size_counter.h"
 #include "cista/type_hash/static_type_hash.h"
 #include "cista/type_hash/type_hash.h"
 #include "cista/unused_param.h"
@@ -29,6 +42,19 @@
 
 namespace cista {
 
+// Pointer free types that do not require endian conversion are copied as one
+// block of bytes - no per element fixups on serialization or deserialization.
+template <mode Mode, typename T>
+constexpr bool is_bulk_copyable_v =
+    is_pointer_free_v<T> && !endian_conversion_necessary<Mode>();
+
+// Contiguous integers that require endian conversion are converted as one
+// run (endian_swap_n) instead of one at a time.
+template <mode Mode, typename T>
+constexpr bool is_bulk_convertible_v = std::numeric_limits<T>::is_integer &&
+                                       sizeof(T) > 1U &&
+                                       endian_conversion_necessary<Mode>();
+
 // =============================================================================
 // SERIALIZE
 // -----------------------------------------------------------------------------
@@ -37,6 +63,14 @@ struct pending_offset {
   offset_t pos_;
 };
 
+// mode::DEDUP: payload already written (origin data is alive while
+// serializing, so it is compared instead of the written bytes).
+struct dedup_entry {
+  void const* data_;
+  std::size_t size_;
+  offset_t pos_;
+};
+
 struct vector_range {
   bool contains(void const* begin, void const* ptr) const noexcept {
     auto const ptr_int = reinterpret_cast<uintptr_t>(ptr);
@@ -55,10 +89,41 @@ struct vector_range {
   std::size_t size_;
 };
 
+template <typename Target, typename = void>
+struct has_hash_range : std::false_type {};
+
+template <typename Target>
+struct has_hash_range<
+    Target, std::void_t<decltype(std::declval<Target const&>().hash_range(
+                integrity_hash{}, std::size_t{0U}, std::size_t{0U}))>>
+    : std::true_type {};
+
+template <typename Target, typename = void>
+struct has_write_swapped : std::false_type {};
+
+template <typename Target>
+struct has_write_swapped<
+    Target, std::void_t<decltype(std::declval<Target&>().write_swapped(
+                std::declval<void const*>(), std::size_t{0U}, std::size_t{0U},
+                std::size_t{0U}))>> : std::true_type {};
+
 template <typename Target, mode Mode>
 struct serialization_context {
   static constexpr auto const MODE = Mode;
 
+  // Size computation only: pointers are not resolved and no
+  // bookkeeping for pointer targets is done.
+  static constexpr auto const DRY_RUN = std::is_same_v<Target, size_counter>;
+
+  static constexpr auto const CONVERT_BUF_SIZE = std::size_t{16U * 1024U};
+
+  // Chunk hashes are computed while writing (see start_incremental_checksum).
+  static constexpr auto const INCREMENTAL_CHECKSUM =
+      has_hash_range<Target>::value &&
+      is_mode_enabled(MODE, mode::WITH_CHUNKED_INTEGRITY);
+
+  struct no_incremental_checksum {};
+
   explicit serialization_context(Target& t) : t_{t} {}
 
   static bool compare(std::pair<void const*, vector_range> const& a,
@@ -66,14 +131,121 @@ struct serialization_context {
     return a.first < b.first;
   }
 
+  static constexpr auto const by_begin = [](auto const& a, auto const& b) {
+    return compare(a, b);
+  };
+
   offset_t write(void const* ptr, std::size_t const size,
                  std::size_t const alignment = 0) {
-    return t_.write(ptr, size, alignment);
+    auto const start = t_.write(ptr, size, alignment);
+    if constexpr (INCREMENTAL_CHECKSUM) {
+      if (incremental_checksum_.has_value()) {
+        incremental_checksum_->append(static_cast<std::size_t>(start), ptr,
+                                      size);
+      }
+    }
+    return start;
   }
 
   template <typename T>
   void write(offset_t const pos, T const& val) {
     t_.write(static_cast<std::size_t>(pos), val);
+    if constexpr (INCREMENTAL_CHECKSUM) {
+      if (incremental_checksum_.has_value()) {
+        incremental_checksum_->patch(static_cast<std::size_t>(pos), &val,
+                                     serialized_size<T>());
+      }
+    }
+  }
+
+  // Writes n integers in the serialized byte order. Recording targets swap
+  // while replaying the image (in parallel for serialize_parallel), others
+  // get the data converted block by block. Nothing is written for n = 0.
+  template <typename T>
+  offset_t write_converted(T const* data, std::size_t const n,
+                           std::size_t const alignment) {
+    constexpr auto const block_size = CONVERT_BUF_SIZE / sizeof(T);
+    if (n == 0U) {
+      return NULLPTR_OFFSET;
+    } else if constexpr (DRY_RUN) {
+      return write(data, n * sizeof(T), alignment);
+    } else if constexpr (has_write_swapped<Target>::value) {
+      return t_.write_swapped(data, n * sizeof(T), alignment, sizeof(T));
+    } else {
+      convert_buf_.resize(CONVERT_BUF_SIZE);
+      auto start = offset_t{0};
+      for (auto i = std::size_t{0U}; i < n; i += block_size) {
+        auto const count = std::min(block_size, n - i);
+        endian_swap_n(convert_buf_.data(), data + i, count, sizeof(T));
+        auto const pos = write(convert_buf_.data(), count * sizeof(T),
+                               i == 0U ? alignment : 0U);
+        if (i == 0U) {
+          start = pos;
+        }
+      }
+      return start;
+    }
+  }
+
+  // Overwrites n integers at pos (already written) in the serialized byte
+  // order, eight bytes per patch.
+  template <typename T>
+  void write_converted(offset_t pos, T const* data, std::size_t const n) {
+    constexpr auto const block_size = sizeof(std::uint64_t) / sizeof(T);
+    auto i = std::size_t{0U};
+    for (; i + block_size <= n; i += block_size) {
+      auto block = std::uint64_t{0U};
+      endian_swap_n(&block, data + i, block_size, sizeof(T));
+      write(pos, block);
+      pos += static_cast<offset_t>(sizeof(block));
+    }
+    for (; i != n; ++i) {
+      write(pos, convert_endian<MODE>(data[i]));
+      pos += static_cast<offset_t>(sizeof(T));
+    }
+  }
+
+  // mode::DEDUP: writes a payload (string / pointer free vector data) only
+  // once. Later payloads with the same bytes share the first copy if its
+  // position satisfies their alignment. Otherwise, write_fn writes it.
+  template <typename Fn>
+  offset_t write_payload(void const* data, std::size_t const size,
+                         std::size_t const alignment, Fn&& write_fn) {
+    if constexpr (is_mode_enabled(MODE, mode::DEDUP)) {
+      auto const h = hash_combine(
+          hash(std::string_view{static_cast<char const*>(data), size}), size);
+      if (auto const it = dedup_.find(h); it != end(dedup_)) {
+        auto const& e = it->second;
+        if (e.size_ == size &&
+            (alignment == 0U ||
+             e.pos_ % static_cast<offset_t>(alignment) == 0) &&
+            std::memcmp(e.data_, data, size) == 0) {
+          return e.pos_;
+        }
+      }
+      auto const pos = write_fn();
+      dedup_.emplace(h, dedup_entry{data, size, pos});
+      return pos;
+    } else {
+      CISTA_UNUSED_PARAM(data)
+      CISTA_UNUSED_PARAM(size)
+      CISTA_UNUSED_PARAM(alignment)
+      return write_fn();
+    }
+  }
+
+  // Hashes everything written from now on while writing it. Only for targets
+  // that would have to read their contents again (file): buffers in memory
+  // are hashed in parallel afterwards. The target hashes the chunks patched
+  // after they were hashed (hash_range).
+  void start_incremental_checksum(offset_t const from,
+                                  integrity_hash const algo) {
+    if constexpr (INCREMENTAL_CHECKSUM) {
+      incremental_checksum_.emplace(static_cast<std::size_t>(from), algo);
+    } else {
+      CISTA_UNUSED_PARAM(from)
+      CISTA_UNUSED_PARAM(algo)
+    }
   }
 
   template <typename T>
@@ -85,52 +257,204 @@ struct serialization_context {
   template <typename Ptr>
   bool resolve_pointer(Ptr ptr, offset_t const pos,
                        bool const add_pending = true) {
-    if (std::is_same_v<decay_t<remove_pointer_t<Ptr>>, void> && add_pending) {
-      write(pos, convert_endian<MODE>(NULLPTR_OFFSET));
+    if constexpr (DRY_RUN) {
+      CISTA_UNUSED_PARAM(ptr)
+      CISTA_UNUSED_PARAM(pos)
+      CISTA_UNUSED_PARAM(add_pending)
       return true;
+    } else {
+      if (std::is_same_v<decay_t<remove_pointer_t<Ptr>>, void> &&
+          add_pending) {
+        write(pos, convert_endian<MODE>(NULLPTR_OFFSET));
+        return true;
+      }
+      if (ptr == nullptr) {
+        write(pos, convert_endian<MODE>(NULLPTR_OFFSET));
+        return true;
+      }
+      if (auto const offset = resolve_offset(ptr_cast(ptr));
+          offset.has_value()) {
+        write(pos, convert_endian<MODE>(*offset - pos));
+        return true;
+      }
+      if (auto const offset = resolve_vector_range_ptr(ptr);
+          offset.has_value()) {
+        write(pos, convert_endian<MODE>(*offset - pos));
+        return true;
+      }
+      if (add_pending) {
+        write(pos, convert_endian<MODE>(NULLPTR_OFFSET));
+        pending_.emplace_back(pending_offset{ptr_cast(ptr), pos});
+        return true;
+      }
+      return false;
     }
-    if (ptr == nullptr) {
-      write(pos, convert_endian<MODE>(NULLPTR_OFFSET));
-      return true;
+  }
+
+  // Records the position of a raw pointer slot for the relocation table.
+  template <typename Ptr>
+  void add_relocation(offset_t const pos) {
+    if constexpr (is_mode_enabled(MODE, mode::WITH_RELOCATIONS) &&
+                  std::is_pointer_v<Ptr>) {
+      relocations_.emplace_back(pos);
+    } else {
+      CISTA_UNUSED_PARAM(pos)
     }
-    if (auto const it = offsets_.find(ptr_cast(ptr)); it != end(offsets_)) {
-      write(pos, convert_endian<MODE>(it->second - pos));
-      return true;
+  }
+
+  void add_offset(void const* ptr, offset_t const pos) {
+    if constexpr (DRY_RUN) {
+      CISTA_UNUSED_PARAM(ptr)
+      CISTA_UNUSED_PARAM(pos)
+    } else {
+      offsets_.emplace(ptr, pos);
     }
-    if (auto const offset = resolve_vector_range_ptr(ptr); offset.has_value()) {
-      write(pos, convert_endian<MODE>(*offset - pos));
-      return true;
+  }
+
+  std::optional<offset_t> resolve_offset(void const* ptr) const {
+    if (offsets_.empty()) {
+      return std::nullopt;
     }
-    if (add_pending) {
-      write(pos, convert_endian<MODE>(NULLPTR_OFFSET));
-      pending_.emplace_back(pending_offset{ptr_cast(ptr), pos});
-      return true;
+    auto const it = offsets_.find(ptr);
+    return it == end(offsets_) ? std::nullopt : std::make_optional(it->second);
+  }
+
+  // Vector ranges are kept in a flat array: a sorted prefix (binary search)
+  // followed by a short unsorted tail of recently added ranges. The tail is
+  // merged into the prefix once it grows beyond a fraction of the prefix, so
+  // each range is moved O(log n) times in total. Pointers into ranges that
+  // are still in a long tail are resolved in batch by resolve_pending().
+  void add_vector_range(void const* begin, vector_range const range) {
+    if constexpr (DRY_RUN) {
+      CISTA_UNUSED_PARAM(begin)
+      CISTA_UNUSED_PARAM(range)
+    } else {
+      constexpr auto const min_merge_size = std::size_t{16U};
+
+      auto const in_order = sorted_ranges_ == vector_ranges_.size() &&
+                            (vector_ranges_.empty() ||
+                             vector_ranges_.back().first < begin);
+      vector_ranges_.emplace_back(begin, range);
+      if (in_order) {
+        ++sorted_ranges_;
+        return;
+      }
+
+      auto const tail_size = vector_ranges_.size() - sorted_ranges_;
+      if (tail_size > std::max(min_merge_size, sorted_ranges_ / 8U)) {
+        sort_vector_ranges();
+      }
     }
-    return false;
+  }
+
+  void sort_vector_ranges() {
+    auto const mid = std::next(begin(vector_ranges_),
+                               static_cast<std::ptrdiff_t>(sorted_ranges_));
+    std::sort(mid, end(vector_ranges_), by_begin);
+    std::inplace_merge(begin(vector_ranges_), mid, end(vector_ranges_),
+                       by_begin);
+    sorted_ranges_ = vector_ranges_.size();
   }
 
   template <typename Ptr>
   std::optional<offset_t> resolve_vector_range_ptr(Ptr ptr) {
-    if (vector_ranges_.empty()) {
-      return std::nullopt;
+    constexpr auto const max_linear_search = std::size_t{16U};
+
+    auto const sorted_end = std::next(
+        begin(vector_ranges_), static_cast<std::ptrdiff_t>(sorted_ranges_));
+    auto const vec_it = std::upper_bound(
+        begin(vector_ranges_), sorted_end,
+        std::pair{static_cast<void const*>(ptr), vector_range{}}, by_begin);
+    if (vec_it != begin(vector_ranges_)) {
+      auto const pred = std::prev(vec_it);
+      if (pred->second.contains(pred->first, ptr)) {
+        return pred->second.offset_of(pred->first, ptr);
+      }
     }
-    auto const vec_it = vector_ranges_.upper_bound(ptr);
-    if (vec_it == begin(vector_ranges_)) {
-      return std::nullopt;
+
+    if (vector_ranges_.size() - sorted_ranges_ <= max_linear_search) {
+      for (auto it = sorted_end; it != end(vector_ranges_); ++it) {
+        if (it->second.contains(it->first, ptr)) {
+          return it->second.offset_of(it->first, ptr);
+        }
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  // Resolves all pending pointers in one batch: pending pointers and vector
+  // ranges are both sorted by address and matched in a single sweep.
+  void resolve_pending() {
+    sort_vector_ranges();
+    std::sort(begin(pending_), end(pending_),
+              [](pending_offset const& a, pending_offset const& b) {
+                return a.origin_ptr_ < b.origin_ptr_;
+              });
+
+    auto range_it = begin(vector_ranges_);
+    for (auto const& p : pending_) {
+      if (auto const offset = resolve_offset(p.origin_ptr_);
+          offset.has_value()) {
+        write(p.pos_, convert_endian<MODE>(*offset - p.pos_));
+        continue;
+      }
+
+      while (range_it != end(vector_ranges_) &&
+             std::next(range_it) != end(vector_ranges_) &&
+             !(p.origin_ptr_ < std::next(range_it)->first)) {
+        ++range_it;
+      }
+      if (range_it != end(vector_ranges_) &&
+          range_it->second.contains(range_it->first, p.origin_ptr_)) {
+        write(p.pos_,
+              convert_endian<MODE>(
+                  range_it->second.offset_of(range_it->first, p.origin_ptr_) -
+                  p.pos_));
+        continue;
+      }
+
+      printf("warning: dangling pointer at %" PRI_O " (origin=%p)\n", p.pos_,
+             p.origin_ptr_);
     }
-    auto const pred = std::prev(vec_it);
-    return pred->second.contains(pred->first, ptr)
-               ? std::make_optional(pred->second.offset_of(pred->first, ptr))
-               : std::nullopt;
+    pending_.clear();
   }
 
   std::uint64_t checksum(offset_t const from) const noexcept {
     return t_.checksum(from);
   }
 
+  std::uint64_t chunked_checksum(offset_t const from) const noexcept {
+    return t_.chunked_checksum(from);
+  }
+
+  std::uint64_t chunk_list_checksum(offset_t const from,
+                                    integrity_hash const algo) {
+    if constexpr (INCREMENTAL_CHECKSUM) {
+      if (incremental_checksum_.has_value()) {
+        auto const csum = incremental_checksum_->finish(
+            [&](std::size_t const pos, std::size_t const size) {
+              return t_.hash_range(algo, pos, size);
+            });
+        incremental_checksum_.reset();
+        return csum;
+      }
+    }
+    return t_.chunk_list_checksum(from, algo);
+  }
+
   cista::raw::hash_map<void const*, offset_t> offsets_;
-  std::map<void const*, vector_range> vector_ranges_;
+  std::vector<std::pair<void const*, vector_range>> vector_ranges_;
+  std::size_t sorted_ranges_{0U};
   std::vector<pending_offset> pending_;
+  std::vector<offset_t> relocations_;
+  std::vector<std::uint8_t> relocation_table_;
+  std::conditional_t<INCREMENTAL_CHECKSUM,
+                     std::optional<incremental_chunk_list_hash>,
+                     no_incremental_checksum>
+      incremental_checksum_;
+  std::vector<std::uint8_t> convert_buf_;
+  cista::raw::hash_map<hash_t, dedup_entry> dedup_;
   Target& t_;
 };
 
@@ -140,10 +464,15 @@ void serialize(Ctx& c, T const* origin, offset_t const pos) {
   if constexpr (std::is_union_v<Type>) {
     static_assert(std::is_standard_layout_v<Type> &&
                   std::is_trivially_copyable_v<Type>);
+  } else if constexpr (is_bulk_copyable_v<Ctx::MODE, Type>) {
+    CISTA_UNUSED_PARAM(c)
+    CISTA_UNUSED_PARAM(origin)
+    CISTA_UNUSED_PARAM(pos)
   } else if constexpr (is_pointer_v<Type>) {
+    c.template add_relocation<Type>(pos);
     c.resolve_pointer(*origin, pos);
   } else if constexpr (is_indexed_v<Type>) {
-    c.offsets_.emplace(origin, pos);
+    c.add_offset(origin, pos);
     serialize(c, static_cast<typename Type::value_type const*>(origin), pos);
   } else if constexpr (!std::is_scalar_v<Type>) {
     static_assert(to_tuple_works_v<Type>, "Please implement custom serializer");
@@ -153,7 +482,8 @@ void serialize(Ctx& c, T const* origin, offset_t const pos) {
                                 reinterpret_cast<intptr_t>(origin));
       serialize(c, member, pos + member_offset);
     });
-  } else if constexpr (std::numeric_limits<Type>::is_integer) {
+  } else if constexpr (std::numeric_limits<Type>::is_integer &&
+                       endian_conversion_necessary<Ctx::MODE>()) {
     c.write(pos, convert_endian<Ctx::MODE>(*origin));
   } else {
     CISTA_UNUSED_PARAM(origin)
@@ -169,11 +499,24 @@ void serialize(Ctx& c,
   using Type = basic_vector<T, Ptr, Indexed, TemplateSizeType>;
 
   auto const size = serialized_size<T>() * origin->used_size_;
-  auto const start = origin->empty()
-                         ? NULLPTR_OFFSET
-                         : c.write(static_cast<T const*>(origin->el_), size,
-                                   std::alignment_of_v<T>);
+  auto start = NULLPTR_OFFSET;
+  if (!origin->empty()) {
+    auto const data = static_cast<T const*>(origin->el_);
+    if constexpr (is_bulk_convertible_v<Ctx::MODE, T>) {
+      start =
+          c.write_converted(data, origin->used_size_, std::alignment_of_v<T>);
+    } else if constexpr (!Indexed && is_pointer_free_v<T>) {
+      // Not indexed: nothing can point into the payload, it can be shared.
+      start = c.write_payload(data, size, std::alignment_of_v<T>, [&]() {
+        return c.write(data, size, std::alignment_of_v<T>);
+      });
+    } else {
+      start = c.write(data, size, std::alignment_of_v<T>);
+    }
+  }
 
+  c.template add_relocation<decltype(Type::el_)>(
+      pos + cista_member_offset(Type, el_));
   c.write(pos + cista_member_offset(Type, el_),
           convert_endian<Ctx::MODE>(
               start == NULLPTR_OFFSET
@@ -187,15 +530,18 @@ void serialize(Ctx& c,
 
   if constexpr (Indexed) {
     if (origin->el_ != nullptr) {
-      c.vector_ranges_.emplace(origin->el_, vector_range{start, size});
+      c.add_vector_range(origin->el_, vector_range{start, size});
     }
   }
 
-  if (origin->el_ != nullptr) {
-    auto i = 0U;
-    for (auto it = start; it != start + static_cast<offset_t>(size);
-         it += serialized_size<T>()) {
-      serialize(c, static_cast<T const*>(origin->el_ + i++), it);
+  if constexpr (!is_bulk_copyable_v<Ctx::MODE, T> &&
+                !is_bulk_convertible_v<Ctx::MODE, T>) {
+    if (origin->el_ != nullptr) {
+      auto i = 0U;
+      for (auto it = start; it != start + static_cast<offset_t>(size);
+           it += serialized_size<T>()) {
+        serialize(c, static_cast<T const*>(origin->el_ + i++), it);
+      }
     }
   }
 }
@@ -203,33 +549,30 @@ void serialize(Ctx& c,
 template <typename Ctx, typename Ptr>
 void serialize(Ctx& c, generic_string<Ptr> const* origin, offset_t const pos) {
   using Type = generic_string<Ptr>;
-  auto str_convert_endian = [](Ctx& ctx, offset_t const start,
-                               typename Type::CharT const* str,
-                               offset_t const size) -> void {
-    if constexpr (sizeof(typename Type::CharT) > 1) {
-      for (offset_t i = 0; i < size; ++i) {
-        ctx.write(
-            start + i * static_cast<offset_t>(sizeof(typename Type::CharT)),
-            convert_endian<Ctx::MODE>(str[i]));
-      }
-    }
-  };
+  using CharT = typename Type::CharT;
+  constexpr auto const convert = is_bulk_convertible_v<Ctx::MODE, CharT>;
 
   if (origin->is_short()) {
-    str_convert_endian(c, pos + cista_member_offset(Type, s_.s_), origin->s_.s_,
-                       static_cast<offset_t>(Type::short_length_limit));
+    if constexpr (convert) {
+      c.write_converted(pos + cista_member_offset(Type, s_.s_), origin->s_.s_,
+                        Type::short_length_limit);
+    }
     return;
   }
 
-  auto const start =
-      (origin->h_.ptr_ == nullptr)
-          ? NULLPTR_OFFSET
-          : c.write(origin->data(),
-                    origin->size() * sizeof(typename Type::CharT));
-  if (start != NULLPTR_OFFSET) {
-    str_convert_endian(c, start, origin->data(),
-                       static_cast<offset_t>(origin->size()));
+  auto start = NULLPTR_OFFSET;
+  if (origin->h_.ptr_ != nullptr) {
+    if constexpr (convert) {
+      start = c.write_converted(origin->data(), origin->size(), 0U);
+    } else {
+      auto const size = origin->size() * sizeof(CharT);
+      start = c.write_payload(origin->data(), size, 0U, [&]() {
+        return c.write(origin->data(), size);
+      });
+    }
   }
+  c.template add_relocation<decltype(Type::h_.ptr_)>(
+      pos + cista_member_offset(Type, h_.ptr_));
   c.write(pos + cista_member_offset(Type, h_.ptr_),
           convert_endian<Ctx::MODE>(
               start == NULLPTR_OFFSET
@@ -264,17 +607,12 @@ void serialize(Ctx& c, generic_cstring<Ptr> const* origin, offset_t const pos) {
     return;
   }
 
-  const auto* data = origin->data();
-  auto size = origin->size();
-  std::string buf;
-  if (!origin->is_owning()) {
-    buf = origin->str();
-    data = buf.data();
-    size = buf.size();
-  }
-  auto capacity = size + 1;
-
-  auto const start = c.write(data, capacity);
+  // Non-owning strings are not necessarily null-terminated:
+  // write the terminator separately (directly follows, no alignment).
+  auto const start = c.write(origin->data(), origin->size());
+  c.write("", 1U);
+  c.template add_relocation<decltype(Type::h_.ptr_)>(
+      pos + cista_member_offset(Type, h_.ptr_));
   c.write(pos + cista_member_offset(Type, h_.ptr_),
           convert_endian<Ctx::MODE>(start - cista_member_offset(Type, h_.ptr_) -
                                     pos));
@@ -311,6 +649,8 @@ void serialize(Ctx& c, basic_unique_ptr<T, Ptr> const* origin,
           ? NULLPTR_OFFSET
           : c.write(origin->el_, serialized_size<T>(), std::alignment_of_v<T>);
 
+  c.template add_relocation<decltype(Type::el_)>(
+      pos + cista_member_offset(Type, el_));
   c.write(pos + cista_member_offset(Type, el_),
           convert_endian<Ctx::MODE>(
               start == NULLPTR_OFFSET
@@ -319,7 +659,7 @@ void serialize(Ctx& c, basic_unique_ptr<T, Ptr> const* origin,
   c.write(pos + cista_member_offset(Type, self_allocated_), false);
 
   if (origin->el_ != nullptr) {
-    c.offsets_[origin->el_] = start;
+    c.add_offset(origin->el_, start);
     serialize(c, ptr_cast(origin->el_), start);
   }
 }
@@ -347,6 +687,10 @@ void serialize(Ctx& c,
           : start +
                 static_cast<offset_t>(origin->capacity_ * serialized_size<T>());
 
+  c.template add_relocation<decltype(Type::entries_)>(
+      pos + cista_member_offset(Type, entries_));
+  c.template add_relocation<decltype(Type::ctrl_)>(
+      pos + cista_member_offset(Type, ctrl_));
   c.write(pos + cista_member_offset(Type, entries_),
           convert_endian<Ctx::MODE>(
               start == NULLPTR_OFFSET
@@ -367,14 +711,16 @@ void serialize(Ctx& c,
   c.write(pos + cista_member_offset(Type, growth_left_),
           convert_endian<Ctx::MODE>(origin->growth_left_));
 
-  if (origin->entries_ != nullptr) {
-    auto i = 0u;
-    for (auto it = start;
-         it != start + static_cast<offset_t>(origin->capacity_ *
-                                             serialized_size<T>());
-         it += serialized_size<T>(), ++i) {
-      if (Type::is_full(origin->ctrl_[i])) {
-        serialize(c, static_cast<T*>(origin->entries_ + i), it);
+  if constexpr (!is_bulk_copyable_v<Ctx::MODE, T>) {
+    if (origin->entries_ != nullptr) {
+      auto i = 0u;
+      for (auto it = start;
+           it != start + static_cast<offset_t>(origin->capacity_ *
+                                               serialized_size<T>());
+           it += serialized_size<T>(), ++i) {
+        if (Type::is_full(origin->ctrl_[i])) {
+          serialize(c, static_cast<T*>(origin->entries_ + i), it);
+        }
       }
     }
   }
@@ -401,11 +747,19 @@ void serialize(Ctx& c, bitset<Size> const* origin, offset_t const pos) {
 
 template <typename Ctx, typename T, std::size_t Size>
 void serialize(Ctx& c, array<T, Size> const* origin, offset_t const pos) {
-  auto const size =
-      static_cast<offset_t>(serialized_size<T>() * origin->size());
-  auto i = 0U;
-  for (auto it = pos; it != pos + size; it += serialized_size<T>()) {
-    serialize(c, &(*origin)[i++], it);
+  if constexpr (is_bulk_copyable_v<Ctx::MODE, T>) {
+    CISTA_UNUSED_PARAM(c)
+    CISTA_UNUSED_PARAM(origin)
+    CISTA_UNUSED_PARAM(pos)
+  } else if constexpr (is_bulk_convertible_v<Ctx::MODE, T>) {
+    c.write_converted(pos, origin->data(), Size);
+  } else {
+    auto const size =
+        static_cast<offset_t>(serialized_size<T>() * origin->size());
+    auto i = 0U;
+    for (auto it = pos; it != pos + size; it += serialized_size<T>()) {
+      serialize(c, &(*origin)[i++], it);
+    }
   }
 }
 
@@ -470,18 +824,42 @@ constexpr offset_t integrity_start(mode const m) noexcept {
   return start;
 }
 
+constexpr offset_t trailer_size(mode const m) noexcept {
+  return is_mode_enabled(m, mode::WITH_TRAILER_INTEGRITY)
+             ? static_cast<offset_t>(sizeof(std::uint64_t))
+             : offset_t{0};
+}
+
 constexpr offset_t data_start(mode const m) noexcept {
   auto start = integrity_start(m);
   if (is_mode_enabled(m, mode::WITH_INTEGRITY) ||
       is_mode_enabled(m, mode::SKIP_INTEGRITY)) {
     start += sizeof(std::uint64_t);
+  } else if (is_mode_enabled(m, mode::WITH_CHUNKED_INTEGRITY)) {
+    start += 2U * sizeof(std::uint64_t);  // integrity_hash, checksum
   }
   return start;
 }
 
-template <mode const Mode = mode::NONE, typename Target, typename T>
-void serialize(Target& t, T& value) {
-  serialization_context<Target, Mode> c{t};
+// Writes the header (version, integrity placeholder) for a root of type T.
+// Returns the position of the integrity checksum.
+template <mode const Mode, typename T, typename Ctx>
+offset_t serialize_header(Ctx& c) {
+  static_assert(!is_mode_enabled(Mode, mode::WITH_TRAILER_INTEGRITY) ||
+                    !(is_mode_enabled(Mode, mode::WITH_INTEGRITY) ||
+                      is_mode_enabled(Mode, mode::SKIP_INTEGRITY)),
+                "WITH_TRAILER_INTEGRITY cannot be combined with a header "
+                "integrity mode");
+  static_assert(!is_mode_enabled(Mode, mode::DEDUP) ||
+                    !endian_conversion_necessary<Mode>(),
+                "DEDUP: shared payloads would be converted more than once by "
+                "deserialize");
+  static_assert(!is_mode_enabled(Mode, mode::WITH_CHUNKED_INTEGRITY) ||
+                    !(is_mode_enabled(Mode, mode::WITH_INTEGRITY) ||
+                      is_mode_enabled(Mode, mode::SKIP_INTEGRITY) ||
+                      is_mode_enabled(Mode, mode::WITH_TRAILER_INTEGRITY)),
+                "WITH_CHUNKED_INTEGRITY cannot be combined with another "
+                "integrity mode");
 
   if constexpr (is_mode_enabled(Mode, mode::WITH_VERSION) ||
                 is_mode_enabled(Mode, mode::WITH_STATIC_VERSION)) {
@@ -500,28 +878,178 @@ void serialize(Target& t, T& value) {
   }
 
   auto integrity_offset = offset_t{0};
+  if constexpr (is_mode_enabled(Mode, mode::WITH_CHUNKED_INTEGRITY)) {
+    auto const algo = convert_endian<Mode>(
+        static_cast<std::uint64_t>(DEFAULT_INTEGRITY_HASH));
+    c.write(&algo, sizeof(algo));
+  }
   if constexpr (is_mode_enabled(Mode, mode::WITH_INTEGRITY) ||
-                is_mode_enabled(Mode, mode::SKIP_INTEGRITY)) {
+                is_mode_enabled(Mode, mode::SKIP_INTEGRITY) ||
+                is_mode_enabled(Mode, mode::WITH_CHUNKED_INTEGRITY)) {
     auto const h = hash_t{};
     integrity_offset = c.write(&h, sizeof(h));
   }
+  if constexpr (is_mode_enabled(Mode, mode::WITH_CHUNKED_INTEGRITY)) {
+    c.start_incremental_checksum(
+        integrity_offset + static_cast<offset_t>(sizeof(hash_t)),
+        DEFAULT_INTEGRITY_HASH);
+  }
+
+  return integrity_offset;
+}
+
+// Writes the header, the value itself and the relocation table. Returns the
+// position of the integrity checksum.
+template <mode const Mode, typename Ctx, typename T>
+offset_t serialize_root(Ctx& c, T& value) {
+  auto const integrity_offset = serialize_header<Mode, T>(c);
 
   serialize(c, &value,
             c.write(&value, serialized_size<T>(),
                     std::alignment_of_v<decay_t<decltype(value)>>));
 
-  for (auto& p : c.pending_) {
-    if (!c.resolve_pointer(p.origin_ptr_, p.pos_, false)) {
-      printf("warning: dangling pointer at %" PRI_O " (origin=%p)\n", p.pos_,
-             p.origin_ptr_);
-    }
+  if constexpr (is_mode_enabled(Mode, mode::WITH_RELOCATIONS)) {
+    encode_relocations<Mode>(c.relocations_, c.relocation_table_);
+    auto const table_start = convert_endian<Mode>(
+        c.write(c.relocation_table_.data(), c.relocation_table_.size(),
+                sizeof(std::uint64_t)));
+    c.write(&table_start, sizeof(table_start));
   }
 
+  return integrity_offset;
+}
+
+// Dry run of serialize<Mode>(): computes the exact size of the image with
+// the same layout and alignment rules without writing any data.
+template <mode const Mode = mode::NONE, typename T>
+std::size_t serialized_total_size(T const& value) {
+  auto t = size_counter{};
+  serialization_context<size_counter, Mode> c{t};
+  serialize_root<Mode>(c, value);
+  return t.size() + trailer_size(Mode);
+}
+
+template <typename Target, typename = void>
+struct has_reserve : std::false_type {};
+
+template <typename Target>
+struct has_reserve<Target, std::void_t<decltype(std::declval<Target&>().reserve(
+                               std::size_t{0U}))>> : std::true_type {};
+
+// Targets that buffer writes (file) are flushed after serialization: write
+// errors are reported by serialize(), not by the destructor of the target.
+template <typename Target, typename = void>
+struct has_flush : std::false_type {};
+
+template <typename Target>
+struct has_flush<Target,
+                 std::void_t<decltype(std::declval<Target&>().flush())>>
+    : std::true_type {};
+
+// Patches the header checksum / appends the trailer checksum.
+template <mode const Mode, typename Ctx>
+void write_checksums(Ctx& c, offset_t const integrity_offset) {
   if constexpr (is_mode_enabled(Mode, mode::WITH_INTEGRITY) ||
                 is_mode_enabled(Mode, mode::SKIP_INTEGRITY)) {
     auto const csum =
         c.checksum(integrity_offset + static_cast<offset_t>(sizeof(hash_t)));
     c.write(integrity_offset, convert_endian<Mode>(csum));
+  } else if constexpr (is_mode_enabled(Mode, mode::WITH_CHUNKED_INTEGRITY)) {
+    auto const csum = c.chunk_list_checksum(
+        integrity_offset + static_cast<offset_t>(sizeof(hash_t)),
+        DEFAULT_INTEGRITY_HASH);
+    c.write(integrity_offset, convert_endian<Mode>(csum));
+  } else {
+    CISTA_UNUSED_PARAM(integrity_offset)
+  }
+
+  if constexpr (is_mode_enabled(Mode, mode::WITH_TRAILER_INTEGRITY)) {
+    auto const csum =
+        convert_endian<Mode>(c.chunked_checksum(data_start(Mode)));
+    c.write(&csum, sizeof(csum));
+  } else {
+    CISTA_UNUSED_PARAM(c)
+  }
+}
+
+template <mode const Mode = mode::NONE, typename Target, typename T>
+void serialize(Target& t, T& value) {
+  if constexpr (has_reserve<Target>::value) {
+    t.reserve(t.size() + serialized_total_size<Mode>(value));
+  }
+
+  serialization_context<Target, Mode> c{t};
+
+  auto const integrity_offset = serialize_root<Mode>(c, value);
+
+  c.resolve_pending();
+
+  write_checksums<Mode>(c, integrity_offset);
+
+  if constexpr (has_flush<Target>::value) {
+    t.flush();
+  }
+}
+
+// Serializes without seeking: the layout is recorded first, then the image
+// is passed to sink(std::uint8_t const* data, std::size_t size) strictly in
+// order. The value has to stay unchanged until the function returns.
+// An integrity checksum can only be written as trailer
+// (mode::WITH_TRAILER_INTEGRITY), not in the header.
+template <mode const Mode = mode::NONE, typename Sink, typename T>
+void serialize_stream(Sink&& sink, T& value) {
+  static_assert(!is_mode_enabled(Mode, mode::WITH_INTEGRITY) &&
+                    !is_mode_enabled(Mode, mode::WITH_CHUNKED_INTEGRITY),
+                "streaming: use WITH_TRAILER_INTEGRITY");
+
+  auto r = recorder{};
+  serialization_context<recorder, Mode> c{r};
+  serialize_root<Mode>(c, value);
+  c.resolve_pending();
+  r.sort_patches();
+
+  // Image bytes after the header are passed on (and hashed) in chunks of
+  // HASH_CHUNK_SIZE, exactly like chunked_hash() over the whole data.
+  auto const hash_start = static_cast<std::size_t>(data_start(Mode));
+  auto out = std::vector<std::uint8_t>{};
+  out.reserve(HASH_CHUNK_SIZE);
+  auto h = BASE_HASH;
+  auto pos = std::size_t{0U};
+  auto next_flush = hash_start;
+  auto const flush = [&]() {
+    if (!out.empty()) {
+      if constexpr (is_mode_enabled(Mode, mode::WITH_TRAILER_INTEGRITY)) {
+        if (pos > hash_start) {
+          h = hash(std::string_view{reinterpret_cast<char const*>(out.data()),
+                                    out.size()},
+                   h);
+        }
+      }
+      sink(static_cast<std::uint8_t const*>(out.data()), out.size());
+      out.clear();
+    }
+    next_flush = pos + HASH_CHUNK_SIZE;
+  };
+
+  r.emit([&](std::uint8_t const* data, std::size_t size) {
+    while (size != 0U) {
+      if (pos == next_flush) {
+        flush();
+      }
+      auto const n = std::min(size, next_flush - pos);
+      out.insert(end(out), data, data + n);
+      data += n;
+      size -= n;
+      pos += n;
+    }
+  });
+  flush();
+
+  if constexpr (is_mode_enabled(Mode, mode::WITH_TRAILER_INTEGRITY)) {
+    auto const csum = convert_endian<Mode>(h);
+    sink(reinterpret_cast<std::uint8_t const*>(&csum), sizeof(csum));
+  } else {
+    CISTA_UNUSED_PARAM(h)
   }
 }
 
@@ -532,6 +1060,90 @@ byte_buf serialize(T& el) {
   return std::move(b.buf_);
 }
 
+// Writes data built in an arena (see arena.h) with a single copy: offset
+// containers in the arena are position independent, the arena contents
+// (root first) are the image data as they are. Vectors keep their grown
+// capacity, so the image has to be read with mode::ARENA as well.
+template <mode const Mode = mode::ARENA, typename Target, typename T>
+void serialize_arena(Target& t, arena const& a, T const& root) {
+  static_assert(is_mode_enabled(Mode, mode::ARENA),
+                "arena: mode::ARENA required");
+  static_assert(!endian_conversion_necessary<Mode>(),
+                "arena: host byte order only");
+  static_assert(is_mode_disabled(Mode, mode::WITH_RELOCATIONS) &&
+                    is_offset_only_v<T>,
+                "arena: offset containers only");
+  verify(reinterpret_cast<std::uint8_t const*>(&root) == a.data(),
+         "arena: root has to be the first object");
+  verify(data_start(Mode) % static_cast<offset_t>(a.max_alignment()) == 0,
+         "arena: header breaks alignment");
+
+  if constexpr (has_reserve<Target>::value) {
+    t.reserve(t.size() + static_cast<std::size_t>(data_start(Mode)) +
+              a.size() + static_cast<std::size_t>(trailer_size(Mode)));
+  }
+
+  serialization_context<Target, Mode> c{t};
+  auto const integrity_offset = serialize_header<Mode, T>(c);
+  verify(c.write(a.data(), a.size()) == data_start(Mode),
+         "arena: target not empty");
+  write_checksums<Mode>(c, integrity_offset);
+
+  if constexpr (has_flush<Target>::value) {
+    t.flush();
+  }
+}
+
+template <mode const Mode = mode::ARENA, typename T>
+byte_buf serialize_arena(arena const& a, T const& root) {
+  auto b = buf{};
+  serialize_arena<Mode>(b, a, root);
+  return std::move(b.buf_);
+}
+
+// Serializes with multiple threads. The layout is recorded sequentially
+// (pointer resolution depends on serialization order), then the threads copy
+// disjoint ranges of the image into the pre-sized target. The result is
+// byte-identical to serialize<Mode>(). Checksums are computed sequentially.
+template <mode const Mode = mode::NONE, typename Buf, typename T>
+void serialize_parallel(
+    buf<Buf>& t, T& value,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  constexpr auto const min_range_size = offset_t{1024 * 1024};
+
+  verify(t.size() == 0U, "serialize_parallel: target not empty");
+
+  auto r = recorder{};
+  serialization_context<recorder, Mode> rc{r};
+  auto const integrity_offset = serialize_root<Mode>(rc, value);
+  rc.resolve_pending();
+  r.sort_patches();
+
+  auto const size = static_cast<offset_t>(r.size());
+  t.buf_.resize(r.size());
+
+  auto const n_ranges = static_cast<offset_t>(std::max(n_threads, 1U));
+  auto const range_size = std::max(
+      min_range_size, to_next_multiple((size + n_ranges - 1) / n_ranges,
+                                       offset_t{sizeof(max_align_t)}));
+  auto const n = static_cast<std::size_t>((size + range_size - 1) / range_size);
+  parallel_for(n, static_cast<unsigned>(n), [&](std::size_t const i) {
+    auto const from = static_cast<offset_t>(i) * range_size;
+    r.fill(t.addr(from), from, std::min(size, from + range_size));
+  });
+
+  serialization_context<buf<Buf>, Mode> c{t};
+  write_checksums<Mode>(c, integrity_offset);
+}
+
+template <mode const Mode = mode::NONE, typename T>
+byte_buf serialize_parallel(
+    T& el, unsigned const n_threads = std::thread::hardware_concurrency()) {
+  auto b = buf{};
+  serialize_parallel<Mode>(b, el, n_threads);
+  return std::move(b.buf_);
+}
+
 // =============================================================================
 // DESERIALIZE
 // -----------------------------------------------------------------------------
@@ -566,6 +1178,38 @@ Arg checked_multiplication(Arg a1, Args... aN) {
   return a1;
 }
 
+// Part of a large vector, checked by a worker thread (deserialize_parallel).
+struct deserialize_task {
+  void (*fn_)(void const* ctx, void* begin, std::size_t n);
+  void* begin_;
+  std::size_t n_;
+  std::size_t size_;  // bytes
+};
+
+// Phase I tasks modify their range in place. They can only run concurrently
+// if no two ranges overlap, which a malformed image can violate (DEEP_CHECK
+// finds overlapping vectors only after phase I).
+inline bool tasks_disjoint(std::vector<deserialize_task> const& tasks) {
+  auto ranges = std::vector<std::pair<std::uintptr_t, std::uintptr_t>>{};
+  ranges.reserve(tasks.size());
+  for (auto const& t : tasks) {
+    auto const begin = reinterpret_cast<std::uintptr_t>(t.begin_);
+    ranges.emplace_back(begin, begin + t.size_);
+  }
+  std::sort(begin(ranges), end(ranges));
+  for (auto i = std::size_t{1U}; i < ranges.size(); ++i) {
+    if (ranges[i].first < ranges[i - 1U].second) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+void endian_swap_range(void const*, void* begin, std::size_t const n) {
+  endian_swap_n(static_cast<T*>(begin), n);
+}
+
 template <mode Mode>
 struct deserialization_context {
   static constexpr auto const MODE = Mode;
@@ -581,6 +1225,29 @@ struct deserialization_context {
     }
   }
 
+  // Integers stored contiguously (vectors, arrays, strings) are converted
+  // as one run, by the workers for large runs in deserialize_parallel.
+  // The range was already validated by check_state.
+  template <typename T>
+  void convert_endian_range(T* begin, std::size_t const n) const {
+    if constexpr (endian_conversion_necessary<MODE>() &&
+                  is_mode_disabled(MODE, mode::_PHASE_II)) {
+      constexpr auto const chunk_size = std::size_t{256U * 1024U} / sizeof(T);
+      if (tasks_ != nullptr && n >= 2U * chunk_size) {
+        for (auto i = std::size_t{0U}; i < n; i += chunk_size) {
+          auto const count = std::min(chunk_size, n - i);
+          tasks_->emplace_back(deserialize_task{
+              &endian_swap_range<T>, begin + i, count, count * sizeof(T)});
+        }
+      } else {
+        endian_swap_n(begin, n);
+      }
+    } else {
+      CISTA_UNUSED_PARAM(begin)
+      CISTA_UNUSED_PARAM(n)
+    }
+  }
+
   template <typename Ptr>
   void deserialize_ptr(Ptr** ptr) const {
     auto const offset =
@@ -651,6 +1318,55 @@ struct deserialization_context {
   }
 
   intptr_t from_, to_;
+
+  // Set while collecting work for parallel checking: large vectors are not
+  // walked but split into tasks.
+  std::vector<deserialize_task>* tasks_{nullptr};
+};
+
+// Dense per type index for the DEEP_CHECK visited bitmaps.
+inline std::atomic_size_t deep_check_type_count{0U};
+
+template <typename T>
+std::size_t deep_check_type_index() {
+  static auto const idx = deep_check_type_count++;
+  return idx;
+}
+
+// DEEP_CHECK visited set: one bit per aligned slot of [from, to) for every
+// pointer type, so marking a pointer as followed is a single bit operation.
+// Addresses outside of the image (unchecked mode) fall back to a std::set.
+// Shared by the workers of a parallel check.
+struct deep_check_visited {
+  using bitmap = std::unique_ptr<std::atomic<std::uint64_t>[]>;
+
+  deep_check_visited(intptr_t const from, intptr_t const to)
+      : from_{from}, to_{to} {}
+
+  // Thread safe, called once per type and context.
+  std::atomic<std::uint64_t>* get(std::size_t const type_idx,
+                                  std::size_t const alignment) {
+    auto const lock = std::lock_guard{mutex_};
+    if (type_idx >= bitmaps_.size()) {
+      bitmaps_.resize(type_idx + 1U);
+    }
+    auto& b = bitmaps_[type_idx];
+    if (b == nullptr) {
+      auto const n_slots = static_cast<std::size_t>(to_ - from_) / alignment;
+      b.reset(new std::atomic<std::uint64_t>[n_slots / 64U + 1U]());
+    }
+    return b.get();
+  }
+
+  bool add_fallback(std::size_t const type_idx, void const* v) {
+    auto const lock = std::lock_guard{mutex_};
+    return fallback_.emplace(type_idx, v).second;
+  }
+
+  intptr_t from_, to_;
+  std::mutex mutex_;
+  std::vector<bitmap> bitmaps_;
+  std::set<std::pair<std::size_t, void const*>> fallback_;
 };
 
 template <mode Mode>
@@ -661,15 +1377,50 @@ struct deep_check_context : public deserialization_context<Mode> {
 
   template <typename T>
   bool add_checked(T const* v) const {
-    return checked_.emplace(type_hash<T>(), static_cast<void const*>(v)).second;
+    auto const type_idx = deep_check_type_index<T>();
+    auto const pos = reinterpret_cast<intptr_t>(v);
+    if (pos < this->from_ || pos >= this->to_) {
+      return visited().add_fallback(type_idx, v);
+    }
+
+    if (type_idx >= bitmaps_.size()) {
+      bitmaps_.resize(type_idx + 1U);
+    }
+    auto& bitmap = bitmaps_[type_idx];
+    if (bitmap == nullptr) {
+      bitmap = visited().get(type_idx, alignof(T));
+    }
+
+    auto const slot = static_cast<std::size_t>(pos - this->from_) / alignof(T);
+    auto& word = bitmap[slot / 64U];
+    auto const bit = std::uint64_t{1U} << (slot % 64U);
+    if (concurrent_) {
+      return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0U;
+    } else {
+      auto const w = word.load(std::memory_order_relaxed);
+      word.store(w | bit, std::memory_order_relaxed);
+      return (w & bit) == 0U;
+    }
+  }
+
+  deep_check_visited& visited() const {
+    if (visited_ == nullptr) {
+      own_visited_ =
+          std::make_unique<deep_check_visited>(this->from_, this->to_);
+      visited_ = own_visited_.get();
+    }
+    return *visited_;
   }
 
-  std::set<std::pair<hash_t, void const*>> mutable checked_;
+  std::unique_ptr<deep_check_visited> mutable own_visited_;
+  deep_check_visited mutable* visited_{nullptr};
+  std::vector<std::atomic<std::uint64_t>*> mutable bitmaps_;
+  bool concurrent_{false};  // visited_ is shared with other threads
 };
 
 template <typename T, mode const Mode = mode::NONE>
 void check(std::uint8_t const* const from, std::uint8_t const* const to) {
-  verify(to - from > data_start(Mode), "invalid range");
+  verify(to - from > data_start(Mode) + trailer_size(Mode), "invalid range");
 
   if constexpr ((Mode & mode::WITH_VERSION) == mode::WITH_VERSION) {
     verify(convert_endian<Mode>(*reinterpret_cast<hash_t const*>(from)) ==
@@ -690,6 +1441,34 @@ void check(std::uint8_t const* const from, std::uint8_t const* const to) {
                    static_cast<std::size_t>(to - from - data_start(Mode))}),
            "invalid checksum");
   }
+
+  if constexpr (is_mode_enabled(Mode, mode::WITH_CHUNKED_INTEGRITY)) {
+    std::uint64_t header[2];  // integrity_hash, checksum
+    std::memcpy(&header, from + integrity_start(Mode), sizeof(header));
+    auto const algo = convert_endian<Mode>(header[0]);
+    verify(algo == static_cast<std::uint64_t>(integrity_hash::CISTA_HASH) ||
+               algo == static_cast<std::uint64_t>(integrity_hash::CRC32C),
+           "unknown integrity hash");
+    verify(convert_endian<Mode>(header[1]) ==
+               chunk_list_hash(
+                   std::string_view{
+                       reinterpret_cast<char const*>(from + data_start(Mode)),
+                       static_cast<std::size_t>(to - from - data_start(Mode))},
+                   integrity_hash{algo}),
+           "invalid checksum");
+  }
+
+  if constexpr (is_mode_enabled(Mode, mode::WITH_TRAILER_INTEGRITY)) {
+    auto const data_end = to - trailer_size(Mode);
+    auto csum = std::uint64_t{0U};
+    std::memcpy(&csum, data_end, sizeof(csum));
+    verify(convert_endian<Mode>(csum) ==
+               chunked_hash(std::string_view{
+                   reinterpret_cast<char const*>(from + data_start(Mode)),
+                   static_cast<std::size_t>(data_end - from -
+                                            data_start(Mode))}),
+           "invalid checksum");
+  }
 }
 
 // --- GENERIC ---
@@ -739,13 +1518,15 @@ void recurse(Ctx& c, T* el, Fn&& fn) {
 template <typename Ctx, typename T>
 void deserialize(Ctx const& c, T* el) {
   c.check_ptr(el);
-  if constexpr (is_mode_disabled(Ctx::MODE, mode::_PHASE_II)) {
-    convert_endian_and_ptr(c, el);
-  }
-  if constexpr (is_mode_disabled(Ctx::MODE, mode::UNCHECKED)) {
-    check_state(c, el);
+  if constexpr (!is_bulk_copyable_v<Ctx::MODE, T>) {
+    if constexpr (is_mode_disabled(Ctx::MODE, mode::_PHASE_II)) {
+      convert_endian_and_ptr(c, el);
+    }
+    if constexpr (is_mode_disabled(Ctx::MODE, mode::UNCHECKED)) {
+      check_state(c, el);
+    }
+    recurse(c, el, [&](auto* entry) { deserialize(c, entry); });
   }
-  recurse(c, el, [&](auto* entry) { deserialize(c, entry); });
 }
 
 // --- PAIR<A,B> ---
@@ -804,16 +1585,54 @@ void check_state(Ctx const& c,
                   static_cast<std::size_t>(el->allocated_size_), sizeof(T)));
   c.check_bool(el->self_allocated_);
   c.require(!el->self_allocated_, "vec self-allocated");
-  c.require(el->allocated_size_ == el->used_size_, "vec size mismatch");
-  c.require((el->size() == 0U) == (el->el_ == nullptr), "vec size=0 <=> ptr=0");
+  // Capacity > size only in images written by serialize_arena(): appending
+  // to such a vector in a mutable image writes into the image.
+  if constexpr (is_mode_enabled(Ctx::MODE, mode::ARENA)) {
+    c.require(el->allocated_size_ >= el->used_size_, "vec size mismatch");
+  } else {
+    c.require(el->allocated_size_ == el->used_size_, "vec size mismatch");
+  }
+  c.require((el->allocated_size_ == 0U) == (el->el_ == nullptr),
+            "vec capacity=0 <=> ptr=0");
+}
+
+template <typename Ctx, typename T>
+void deserialize_range(void const* ctx, void* begin, std::size_t const n) {
+  auto const& c = *static_cast<Ctx const*>(ctx);
+  for (auto i = std::size_t{0U}; i != n; ++i) {
+    deserialize(c, static_cast<T*>(begin) + i);
+  }
 }
 
 template <typename Ctx, typename T, template <typename> typename Ptr,
           bool Indexed, typename TemplateSizeType, typename Fn>
-void recurse(Ctx&, basic_vector<T, Ptr, Indexed, TemplateSizeType>* el,
+void recurse(Ctx& c, basic_vector<T, Ptr, Indexed, TemplateSizeType>* el,
              Fn&& fn) {
-  for (auto& m : *el) {  // NOLINT(clang-analyzer-core.NullDereference)
-    fn(&m);
+  if constexpr (is_bulk_copyable_v<Ctx::MODE, T> ||
+                is_mode_enabled(Ctx::MODE, mode::_LAZY)) {
+    // Data range was already validated by check_state: nothing to do.
+    // Lazy: elements are validated on access.
+    CISTA_UNUSED_PARAM(c)
+    CISTA_UNUSED_PARAM(el)
+    CISTA_UNUSED_PARAM(fn)
+  } else if constexpr (is_bulk_convertible_v<Ctx::MODE, T>) {
+    CISTA_UNUSED_PARAM(fn)
+    c.convert_endian_range(el->data(), el->size());
+  } else {
+    constexpr auto const chunk_size =
+        std::max(std::size_t{1U}, std::size_t{64U * 1024U} / sizeof(T));
+    if (c.tasks_ != nullptr && el->size() >= 2U * chunk_size) {
+      for (auto i = std::size_t{0U}; i < el->size(); i += chunk_size) {
+        auto const count = std::min(chunk_size, el->size() - i);
+        c.tasks_->emplace_back(deserialize_task{
+            &deserialize_range<std::remove_const_t<Ctx>, T>, el->data() + i,
+            count, count * sizeof(T)});
+      }
+    } else {
+      for (auto& m : *el) {  // NOLINT(clang-analyzer-core.NullDereference)
+        fn(&m);
+      }
+    }
   }
 }
 
@@ -840,14 +1659,14 @@ void check_state(Ctx const& c, generic_string<Ptr>* el) {
 }
 
 template <typename Ctx, typename Ptr, typename Fn>
-void recurse(Ctx&, generic_string<Ptr>* el, Fn&& fn) {
-  using Type = generic_string<Ptr>;
-  if constexpr (sizeof(typename Type::CharT) > 1) {
-    typename Type::CharT* s = el->data();
-    std::size_t const size = static_cast<std::size_t>(el->size());
-    for (std::size_t i = 0; i < size; ++i) {
-      fn(&s[i]);
-    }
+void recurse(Ctx& c, generic_string<Ptr>* el, Fn&&) {
+  using CharT = typename generic_string<Ptr>::CharT;
+  if constexpr (is_bulk_convertible_v<Ctx::MODE, CharT>) {
+    c.convert_endian_range(el->data(),
+                           static_cast<std::size_t>(el->size()));
+  } else {
+    CISTA_UNUSED_PARAM(c)
+    CISTA_UNUSED_PARAM(el)
   }
 }
 
@@ -895,7 +1714,10 @@ void check_state(Ctx const& c, basic_unique_ptr<T, Ptr>* el) {
 
 template <typename Ctx, typename T, typename Ptr, typename Fn>
 void recurse(Ctx&, basic_unique_ptr<T, Ptr>* el, Fn&& fn) {
-  if (el->el_ != nullptr) {
+  if constexpr (is_mode_enabled(Ctx::MODE, mode::_LAZY)) {
+    CISTA_UNUSED_PARAM(el)
+    CISTA_UNUSED_PARAM(fn)
+  } else if (el->el_ != nullptr) {
     fn(static_cast<T*>(el->el_));
   }
 }
@@ -996,8 +1818,14 @@ template <typename Ctx, typename T, template <typename> typename Ptr,
           typename Fn>
 void recurse(Ctx&, hash_storage<T, Ptr, GetKey, GetValue, Hash, Eq>* el,
              Fn&& fn) {
-  for (auto& m : *el) {
-    fn(&m);
+  if constexpr (is_bulk_copyable_v<Ctx::MODE, T> ||
+                is_mode_enabled(Ctx::MODE, mode::_LAZY)) {
+    CISTA_UNUSED_PARAM(el)
+    CISTA_UNUSED_PARAM(fn)
+  } else {
+    for (auto& m : *el) {
+      fn(&m);
+    }
   }
 }
 
@@ -1009,9 +1837,19 @@ void recurse(Ctx&, bitset<Size>* el, Fn&& fn) {
 
 // --- ARRAY<T> ---
 template <typename Ctx, typename T, std::size_t Size, typename Fn>
-void recurse(Ctx&, array<T, Size>* el, Fn&& fn) {
-  for (auto& m : *el) {
-    fn(&m);
+void recurse(Ctx& c, array<T, Size>* el, Fn&& fn) {
+  if constexpr (is_bulk_copyable_v<Ctx::MODE, T>) {
+    CISTA_UNUSED_PARAM(c)
+    CISTA_UNUSED_PARAM(el)
+    CISTA_UNUSED_PARAM(fn)
+  } else if constexpr (is_bulk_convertible_v<Ctx::MODE, T>) {
+    CISTA_UNUSED_PARAM(fn)
+    c.convert_endian_range(el->data(), Size);
+  } else {
+    CISTA_UNUSED_PARAM(c)
+    for (auto& m : *el) {
+      fn(&m);
+    }
   }
 }
 
@@ -1064,27 +1902,141 @@ void convert_endian_and_ptr(Ctx const& c,
   c.convert_endian(*reinterpret_cast<Rep*>(el));
 }
 
-template <typename T, mode const Mode = mode::NONE>
-T* deserialize(std::uint8_t* from, std::uint8_t* to = nullptr) {
+// Walks the object graph starting at el. With n_threads > 1, large vectors
+// are split into tasks which are checked concurrently after the walk.
+// Errors are deterministic: the exception thrown is the one a sequential walk
+// would have thrown. Phase I tasks run concurrently only if their ranges are
+// disjoint (otherwise one after another in walk order), so this is the error
+// of the first failing task in walk order. Phase II tasks share the visited
+// set (the task that checks an object first depends on timing), so a failing
+// phase II is repeated sequentially - it does not modify the image.
+template <typename Ctx, typename T>
+void deserialize_walk(Ctx& c, T* el, unsigned const n_threads) {
+  if (n_threads <= 1U) {
+    deserialize(c, el);
+    return;
+  }
+
+  auto tasks = std::vector<deserialize_task>{};
+  auto walk_error = std::exception_ptr{};
+  auto walk_error_pos = std::numeric_limits<std::size_t>::max();
+  c.tasks_ = &tasks;
+  try {
+    deserialize(c, el);
+  } catch (...) {
+    walk_error = std::current_exception();
+    walk_error_pos = tasks.size();  // tasks before the error ran before it
+  }
+  c.tasks_ = nullptr;
+  tasks.resize(std::min(tasks.size(), walk_error_pos));
+
+  constexpr auto const phase_ii = is_mode_enabled(Ctx::MODE, mode::_PHASE_II);
+  auto errors = std::vector<std::exception_ptr>(tasks.size());
+  auto next = std::atomic_size_t{0U};
+  auto first_error = std::atomic_size_t{tasks.size()};
+  auto const n_workers =
+      phase_ii || tasks_disjoint(tasks)
+          ? std::min(static_cast<std::size_t>(n_threads), tasks.size())
+          : std::min(std::size_t{1U}, tasks.size());
+  auto workers = std::vector<Ctx>{};
+  workers.reserve(n_workers);
+  while (workers.size() != n_workers) {
+    workers.emplace_back(reinterpret_cast<std::uint8_t const*>(c.from_),
+                         reinterpret_cast<std::uint8_t const*>(c.to_));
+  }
+  auto const run = [&](Ctx const& worker) {
+    for (auto i = next++; i < first_error.load(); i = next++) {
+      try {
+        tasks[i].fn_(&worker, tasks[i].begin_, tasks[i].n_);
+      } catch (...) {
+        errors[i] = std::current_exception();
+        for (auto prev = first_error.load();
+             i < prev && !first_error.compare_exchange_weak(prev, i);) {
+        }
+      }
+    }
+  };
+
+  if constexpr (phase_ii) {
+    for (auto& w : workers) {
+      w.visited_ = &c.visited();
+      w.concurrent_ = true;
+    }
+  }
+
+  run_workers(workers.size(), [&](std::size_t const i) { run(workers[i]); });
+
+  if constexpr (phase_ii) {
+    if (walk_error != nullptr || first_error.load() != tasks.size()) {
+      auto sequential = Ctx{reinterpret_cast<std::uint8_t const*>(c.from_),
+                            reinterpret_cast<std::uint8_t const*>(c.to_)};
+      deserialize(sequential, el);
+    }
+  }
+  if (first_error.load() != tasks.size()) {
+    std::rethrow_exception(errors[first_error.load()]);
+  }
+  if (walk_error != nullptr) {
+    std::rethrow_exception(walk_error);
+  }
+}
+
+template <typename T, mode const Mode>
+T* deserialize(std::uint8_t* from, std::uint8_t* to, unsigned const n_threads) {
   if constexpr (is_mode_enabled(Mode, mode::CAST)) {
     CISTA_UNUSED_PARAM(to)
     return reinterpret_cast<T*>(from);
   } else {
     check<T, Mode>(from, to);
     auto const el = reinterpret_cast<T*>(from + data_start(Mode));
+    auto data_end = to - trailer_size(Mode);
+    auto table_end = data_end;
+
+    if constexpr (is_mode_enabled(Mode, mode::WITH_RELOCATIONS)) {
+      auto const footer = static_cast<offset_t>(sizeof(std::uint64_t));
+      verify(data_end - from >= data_start(Mode) + footer,
+             "relocation table: missing");
+      auto table_start = offset_t{0};
+      std::memcpy(&table_start, data_end - footer, sizeof(table_start));
+      table_start = convert_endian<Mode>(table_start);
+      verify(table_start >= data_start(Mode) &&
+                 table_start <= data_end - footer - from,
+             "relocation table: out of bounds");
+      table_end = data_end - footer;
+      data_end = from + table_start;
+    }
 
-    deserialization_context<Mode> c{from, to};
-    deserialize(c, el);
+    if constexpr (is_mode_enabled(Mode, mode::WITH_RELOCATIONS) &&
+                  is_mode_enabled(Mode, mode::UNCHECKED) &&
+                  !endian_conversion_necessary<Mode>()) {
+      // Pointer fixup is all that is left to do: linear pass over the
+      // relocation table instead of walking the types.
+      auto const table = relocation_table<Mode>{data_end, table_end};
+      if constexpr (is_mode_enabled(Mode, mode::_CONST)) {
+        verify(table.n_slots() == 0U, "raw pointer deserialize is not const");
+      }
+      apply_relocations(from, table, n_threads);
+    } else {
+      CISTA_UNUSED_PARAM(table_end)
 
-    if constexpr ((Mode & mode::DEEP_CHECK) == mode::DEEP_CHECK) {
-      deep_check_context<Mode | mode::_PHASE_II> c1{from, to};
-      deserialize(c1, el);
+      deserialization_context<Mode> c{from, data_end};
+      deserialize_walk(c, el, n_threads);
+
+      if constexpr ((Mode & mode::DEEP_CHECK) == mode::DEEP_CHECK) {
+        deep_check_context<Mode | mode::_PHASE_II> c1{from, data_end};
+        deserialize_walk(c1, el, n_threads);
+      }
     }
 
     return el;
   }
 }
 
+template <typename T, mode const Mode = mode::NONE>
+T* deserialize(std::uint8_t* from, std::uint8_t* to = nullptr) {
+  return deserialize<T, Mode>(from, to, 1U);
+}
+
 template <typename T, mode const Mode = mode::NONE>
 T const* deserialize(std::uint8_t const* from,
                      std::uint8_t const* to = nullptr) {
@@ -1117,6 +2069,24 @@ auto deserialize(Container& c) {
   return deserialize<T, Mode>(&c[0], &c[0] + c.size());
 }
 
+// Like deserialize() but the pointer conversion and validation (and the
+// DEEP_CHECK phase) of large vectors runs on n_threads threads.
+template <typename T, mode const Mode = mode::NONE, typename Container>
+auto deserialize_parallel(
+    Container& c,
+    unsigned const n_threads = std::thread::hardware_concurrency()) {
+  using CharT = std::remove_pointer_t<decltype(&c[0])>;
+  auto const from = const_cast<std::uint8_t*>(
+      reinterpret_cast<std::uint8_t const*>(&c[0]));
+  if constexpr (std::is_const_v<CharT>) {
+    static_assert(!endian_conversion_necessary<Mode>(), "cannot be const");
+    return static_cast<T const*>(deserialize<T const, Mode | mode::_CONST>(
+        from, from + c.size(), n_threads));
+  } else {
+    return deserialize<T, Mode>(from, from + c.size(), n_threads);
+  }
+}
+
 template <typename T, mode const Mode = mode::NONE>
 T* unchecked_deserialize(std::uint8_t* from, std::uint8_t* to = nullptr) {
   return deserialize<T, Mode | mode::UNCHECKED>(from, to);
@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 
+#include "cista/chunked_hash.h"
 #include "cista/hash.h"
 #include "cista/offset_t.h"
 #include "cista/serialized_size.h"
@@ -30,6 +31,22 @@ struct buf {
         buf_.size() - static_cast<std::size_t>(start)});
   }
 
+  std::uint64_t chunked_checksum(offset_t const start = 0U) const noexcept {
+    return chunked_hash(std::string_view{
+        reinterpret_cast<char const*>(&buf_[static_cast<std::size_t>(start)]),
+        buf_.size() - static_cast<std::size_t>(start)});
+  }
+
+  std::uint64_t chunk_list_checksum(
+      offset_t const start = 0U,
+      integrity_hash const algo = DEFAULT_INTEGRITY_HASH) const {
+    return chunk_list_hash(
+        std::string_view{reinterpret_cast<char const*>(
+                             &buf_[static_cast<std::size_t>(start)]),
+                         buf_.size() - static_cast<std::size_t>(start)},
+        algo);
+  }
+
   template <typename T>
   void write(std::size_t const pos, T const& val) {
     verify(buf_.size() >= pos + serialized_size<T>(), "out of bounds write");
@@ -67,6 +84,7 @@ struct buf {
     return buf_[i];
   }
   std::size_t size() const noexcept { return buf_.size(); }
+  void reserve(std::size_t const size) { buf_.reserve(size); }
   void reset() { buf_.resize(0U); }
 
   Buf buf_;
@@ -14,14 +14,18 @@
 #endif
 
 #include <cinttypes>
+#include <cstring>
+#include <exception>
 #include <memory>
+#include <vector>
 
 #include "cista/buffer.h"
 #include "cista/chunk.h"
+#include "cista/chunked_hash.h"
 #include "cista/hash.h"
 #include "cista/offset_t.h"
 #include "cista/serialized_size.h"
-#include "cista/targets/file.h"
+#include "cista/targets/write_combiner.h"
 #include "cista/verify.h"
 
 #ifdef _WIN32
@@ -61,23 +65,41 @@ struct file {
     verify(f_ != nullptr && f_ != INVALID_HANDLE_VALUE, "invalid file handle");
   }
 
-  ~file() {
-    if (f_ != nullptr) {
-      CloseHandle(f_);
+  // Writes pending in the write combiner are flushed before closing. A
+  // failing flush or close is rethrown unless the stack is being unwound
+  // (then the data is lost: call flush() first to handle such errors).
+  ~file() noexcept(false) {
+    if (f_ == nullptr) {
+      return;
+    }
+    auto error = std::exception_ptr{};
+    try {
+      flush();
+    } catch (...) {
+      error = std::current_exception();
     }
+    auto const closed = CloseHandle(f_) != 0;
     f_ = nullptr;
+    if (std::uncaught_exceptions() == 0) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      verify(closed, "file close error");
+    }
   }
 
   file(file const&) = delete;
   file& operator=(file const&) = delete;
 
-  file(file&& o) : f_{o.f_}, size_{o.size_} {
+  file(file&& o) : f_{o.f_}, wc_{std::move(o.wc_)}, size_{o.size_} {
     o.f_ = nullptr;
     o.size_ = 0U;
   }
 
   file& operator=(file&& o) {
+    flush();
     f_ = o.f_;
+    wc_ = std::move(o.wc_);
     size_ = o.size_;
     o.f_ = nullptr;
     o.size_ = 0U;
@@ -88,6 +110,7 @@ struct file {
     if (f_ == nullptr) {
       return 0U;
     }
+    flush();
     LARGE_INTEGER filesize;
     verify(GetFileSizeEx(f_, &filesize), "file size error");
     return static_cast<std::size_t>(filesize.QuadPart);
@@ -95,7 +118,7 @@ struct file {
 
   buffer content() const {
     constexpr auto block_size = 8192u;
-    std::size_t const file_size = size();
+    std::size_t const file_size = size();  // flushes
 
     auto b = buffer(file_size);
 
@@ -112,39 +135,64 @@ struct file {
     return b;
   }
 
-  std::uint64_t checksum(offset_t const start = 0) const {
-    constexpr auto const block_size = 512U * 1024U;  // 512kB
-    auto c = BASE_HASH;
+  // Calls fn(std::string_view) for chunks of HASH_CHUNK_SIZE of the range
+  // [start, start + size).
+  template <typename Fn>
+  void for_each_hash_chunk(offset_t const start, std::size_t const size,
+                           Fn&& fn) const {
+    flush();
+    constexpr auto const block_size = HASH_CHUNK_SIZE;
     char buf[block_size];
-    chunk(block_size, size_ - static_cast<std::size_t>(start),
-          [&](auto const from, auto const size) {
-            OVERLAPPED overlapped{};
-            overlapped.Offset = static_cast<DWORD>(start + from);
+    chunk(block_size, size, [&](auto const from, auto const n) {
+      OVERLAPPED overlapped{};
+      overlapped.Offset = static_cast<DWORD>(start + from);
 #ifdef _WIN64
-            overlapped.OffsetHigh = static_cast<DWORD>((start + from) >> 32U);
+      overlapped.OffsetHigh = static_cast<DWORD>((start + from) >> 32U);
 #endif
-            DWORD bytes_read = {0};
-            verify(ReadFile(f_, buf, static_cast<DWORD>(size), &bytes_read,
-                            &overlapped),
-                   "checksum read error");
-            verify(bytes_read == size, "checksum read error bytes read");
-            c = hash(std::string_view{buf, size}, c);
-          });
+      DWORD bytes_read = {0};
+      verify(ReadFile(f_, buf, static_cast<DWORD>(n), &bytes_read, &overlapped),
+             "checksum read error");
+      verify(bytes_read == n, "checksum read error bytes read");
+      fn(std::string_view{buf, n});
+    });
+  }
+
+  std::uint64_t checksum(offset_t const start = 0) const {
+    auto c = BASE_HASH;
+    for_each_hash_chunk(start, size_ - static_cast<std::size_t>(start),
+                        [&](std::string_view s) { c = hash(s, c); });
     return c;
   }
 
+  // The checksum is already computed over chunks of HASH_CHUNK_SIZE.
+  std::uint64_t chunked_checksum(offset_t const start = 0) const {
+    return checksum(start);
+  }
+
+  std::uint64_t chunk_list_checksum(
+      offset_t const start = 0,
+      integrity_hash const algo = DEFAULT_INTEGRITY_HASH) const {
+    auto chunk_hashes = std::vector<hash_t>{};
+    for_each_hash_chunk(start, size_ - static_cast<std::size_t>(start),
+                        [&](std::string_view s) {
+                          chunk_hashes.emplace_back(integrity_hash_of(algo, s));
+                        });
+    return combine_chunk_hashes(algo, chunk_hashes);
+  }
+
+  std::uint64_t hash_range(integrity_hash const algo, std::size_t const start,
+                           std::size_t const size) const {
+    verify(size <= HASH_CHUNK_SIZE, "hash range too large");
+    auto h = hash_t{0U};
+    for_each_hash_chunk(
+        static_cast<offset_t>(start), size,
+        [&](std::string_view s) { h = integrity_hash_of(algo, s); });
+    return h;
+  }
+
   template <typename T>
   void write(std::size_t const pos, T const& val) {
-    OVERLAPPED overlapped{};
-    overlapped.Offset = static_cast<DWORD>(pos);
-#ifdef _WIN64
-    overlapped.OffsetHigh = pos >> 32u;
-#endif
-    DWORD bytes_written = {0};
-    verify(WriteFile(f_, &val, sizeof(T), &bytes_written, &overlapped),
-           "write(pos, val) write error");
-    verify(bytes_written == sizeof(T),
-           "write(pos, val) write error bytes written");
+    wc_.write(*this, size_, pos, &val, sizeof(T));
   }
 
   offset_t write(void const* ptr, std::size_t const size,
@@ -159,42 +207,59 @@ struct file {
                                 : curr_offset;
     }
 
-    std::uint8_t const buf[16U] = {0U};
-    auto const num_padding_bytes = static_cast<DWORD>(curr_offset - size_);
-    if (num_padding_bytes != 0U) {
-      verify(num_padding_bytes < 16U, "invalid padding size");
-      OVERLAPPED overlapped{};
-      overlapped.Offset = static_cast<std::uint32_t>(size_);
-#ifdef _WIN64
-      overlapped.OffsetHigh = static_cast<std::uint32_t>(size_ >> 32u);
-#endif
-      DWORD bytes_written = {0};
-      verify(WriteFile(f_, buf, num_padding_bytes, &bytes_written, &overlapped),
-             "write padding error");
-      verify(bytes_written == num_padding_bytes,
-             "write padding error bytes written");
-      size_ = curr_offset;
+    wc_.write(*this, size_, curr_offset, ptr, size);
+    size_ = curr_offset + size;
+    return static_cast<offset_t>(curr_offset);
+  }
+
+  // Writes buffered data and queued patches to the file.
+  void flush() const {
+    if (!wc_.empty()) {
+      wc_.flush(*this);
     }
+  }
 
-    constexpr auto block_size = 8192u;
-    chunk(block_size, size, [&](std::size_t const from, unsigned block_size) {
+  void write_at(std::size_t const pos, void const* data,
+                std::size_t const size) const {
+    chunk(MAX_IO_SIZE, size, [&](std::size_t const from, unsigned const n) {
       OVERLAPPED overlapped{};
-      overlapped.Offset = 0xFFFFFFFF;
-      overlapped.OffsetHigh = 0xFFFFFFFF;
+      overlapped.Offset = static_cast<DWORD>(pos + from);
+#ifdef _WIN64
+      overlapped.OffsetHigh = static_cast<DWORD>((pos + from) >> 32U);
+#endif
       DWORD bytes_written = {0};
-      verify(WriteFile(f_, reinterpret_cast<std::uint8_t const*>(ptr) + from,
-                       block_size, &bytes_written, &overlapped),
+      verify(WriteFile(f_, static_cast<std::uint8_t const*>(data) + from, n,
+                       &bytes_written, &overlapped),
              "write error");
-      verify(bytes_written == block_size, "write error bytes written");
+      verify(bytes_written == n, "write error bytes written");
     });
+  }
 
-    auto const offset = size_;
-    size_ += size;
+  // Files opened by open_file() are always readable.
+  bool readable() const noexcept { return true; }
 
-    return offset;
+  // Reads after the end of the file give zeros.
+  void read_at(std::size_t const pos, void* data,
+               std::size_t const size) const {
+    chunk(MAX_IO_SIZE, size, [&](std::size_t const from, unsigned const n) {
+      OVERLAPPED overlapped{};
+      overlapped.Offset = static_cast<DWORD>(pos + from);
+#ifdef _WIN64
+      overlapped.OffsetHigh = static_cast<DWORD>((pos + from) >> 32U);
+#endif
+      auto const dst = static_cast<std::uint8_t*>(data) + from;
+      DWORD bytes_read = {0};
+      if (!ReadFile(f_, dst, n, &bytes_read, &overlapped)) {
+        verify(GetLastError() == ERROR_HANDLE_EOF, "read error");
+      }
+      std::memset(dst + bytes_read, 0, n - bytes_read);
+    });
   }
 
+  static constexpr auto const MAX_IO_SIZE = 1U << 30U;
+
   HANDLE f_{nullptr};
+  write_combiner mutable wc_;
   std::size_t size_{0U};
 };
 }  // namespace cista
@@ -202,7 +267,9 @@ struct file {
 
 #include <cstdio>
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 namespace cista {
 
@@ -219,23 +286,41 @@ struct file {
     verify(f_ != nullptr, "null file pointer");
   }
 
-  ~file() {
-    if (f_ != nullptr) {
-      std::fclose(f_);
+  // Writes pending in the write combiner are flushed before closing. A
+  // failing flush or close is rethrown unless the stack is being unwound
+  // (then the data is lost: call flush() first to handle such errors).
+  ~file() noexcept(false) {
+    if (f_ == nullptr) {
+      return;
+    }
+    auto error = std::exception_ptr{};
+    try {
+      flush();
+    } catch (...) {
+      error = std::current_exception();
     }
+    auto const closed = std::fclose(f_) == 0;
     f_ = nullptr;
+    if (std::uncaught_exceptions() == 0) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      verify(closed, "file close error");
+    }
   }
 
   file(file const&) = delete;
   file& operator=(file const&) = delete;
 
-  file(file&& o) : f_{o.f_}, size_{o.size_} {
+  file(file&& o) : f_{o.f_}, wc_{std::move(o.wc_)}, size_{o.size_} {
     o.f_ = nullptr;
     o.size_ = 0U;
   }
 
   file& operator=(file&& o) {
+    flush();
     f_ = o.f_;
+    wc_ = std::move(o.wc_);
     size_ = o.size_;
     o.f_ = nullptr;
     o.size_ = 0U;
@@ -252,45 +337,77 @@ struct file {
     if (f_ == nullptr) {
       return 0U;
     }
+    flush();
     struct stat s;
     verify(fstat(fd(), &s) != -1, "fstat error");
     return static_cast<std::size_t>(s.st_size);
   }
 
   buffer content() {
-    auto b = buffer(size());
+    auto b = buffer(size());  // flushes
     verify(std::fread(b.data(), 1U, b.size(), f_) == b.size(), "read error");
     return b;
   }
 
-  std::uint64_t checksum(offset_t const start = 0) const {
+  // Calls fn(std::string_view) for chunks of HASH_CHUNK_SIZE of the range
+  // [start, start + size).
+  template <typename Fn>
+  void for_each_hash_chunk(offset_t const start, std::size_t const size,
+                           Fn&& fn) const {
+    flush();
     constexpr auto const block_size =
-        static_cast<std::size_t>(512U * 1024U);  // 512kB
-    verify(size_ >= static_cast<std::size_t>(start), "invalid checksum offset");
+        static_cast<std::size_t>(HASH_CHUNK_SIZE);
+    verify(size_ >= static_cast<std::size_t>(start) + size,
+           "invalid checksum offset");
     verify(!std::fseek(f_, static_cast<long>(start), SEEK_SET), "fseek error");
-    auto c = BASE_HASH;
     char buf[block_size];
-    chunk(block_size, size_ - static_cast<std::size_t>(start),
-          [&](auto const, auto const s) {
-            verify(std::fread(buf, 1U, s, f_) == s, "invalid read");
-            c = hash(std::string_view{buf, s}, c);
-          });
+    chunk(block_size, size, [&](auto const, auto const s) {
+      verify(std::fread(buf, 1U, s, f_) == s, "invalid read");
+      fn(std::string_view{buf, s});
+    });
+  }
+
+  std::uint64_t checksum(offset_t const start = 0) const {
+    auto c = BASE_HASH;
+    for_each_hash_chunk(start, size_ - static_cast<std::size_t>(start),
+                        [&](std::string_view s) { c = hash(s, c); });
     return c;
   }
 
+  // The checksum is already computed over chunks of HASH_CHUNK_SIZE.
+  std::uint64_t chunked_checksum(offset_t const start = 0) const {
+    return checksum(start);
+  }
+
+  std::uint64_t chunk_list_checksum(
+      offset_t const start = 0,
+      integrity_hash const algo = DEFAULT_INTEGRITY_HASH) const {
+    auto chunk_hashes = std::vector<hash_t>{};
+    for_each_hash_chunk(start, size_ - static_cast<std::size_t>(start),
+                        [&](std::string_view s) {
+                          chunk_hashes.emplace_back(integrity_hash_of(algo, s));
+                        });
+    return combine_chunk_hashes(algo, chunk_hashes);
+  }
+
+  std::uint64_t hash_range(integrity_hash const algo, std::size_t const start,
+                           std::size_t const size) const {
+    verify(size <= HASH_CHUNK_SIZE, "hash range too large");
+    auto h = hash_t{0U};
+    for_each_hash_chunk(
+        static_cast<offset_t>(start), size,
+        [&](std::string_view s) { h = integrity_hash_of(algo, s); });
+    return h;
+  }
+
   template <typename T>
   void write(std::size_t const pos, T const& val) {
-    verify(!std::fseek(f_, static_cast<long>(pos), SEEK_SET), "seek error");
-    verify(std::fwrite(reinterpret_cast<std::uint8_t const*>(&val), 1U,
-                       serialized_size<T>(), f_) == serialized_size<T>(),
-           "write error");
+    wc_.write(*this, size_, pos, &val, serialized_size<T>());
   }
 
   offset_t write(void const* ptr, std::size_t const size,
                  std::size_t alignment) {
     auto curr_offset = size_;
-    auto seek_offset = long{0};
-    auto seek_whence = int{SEEK_END};
     if (alignment > 1U) {
       auto unaligned_ptr = reinterpret_cast<void*>(size_);
       auto space = std::numeric_limits<std::size_t>::max();
@@ -299,16 +416,53 @@ struct file {
       if (aligned_ptr != nullptr) {
         curr_offset = reinterpret_cast<std::uintptr_t>(aligned_ptr);
       }
-      seek_offset = static_cast<long>(curr_offset);
-      seek_whence = SEEK_SET;
     }
-    verify(!std::fseek(f_, seek_offset, seek_whence), "seek error");
-    verify(std::fwrite(ptr, 1U, size, f_) == size, "write error");
+    wc_.write(*this, size_, curr_offset, ptr, size);
     size_ = curr_offset + size;
     return static_cast<offset_t>(curr_offset);
   }
 
+  // Writes buffered data and queued patches to the file.
+  void flush() const {
+    if (!wc_.empty()) {
+      wc_.flush(*this);
+    }
+  }
+
+  void write_at(std::size_t pos, void const* data, std::size_t size) const {
+    auto src = static_cast<std::uint8_t const*>(data);
+    while (size != 0U) {
+      auto const n = ::pwrite(fd(), src, size, static_cast<off_t>(pos));
+      verify(n > 0, "write error");
+      src += n;
+      pos += static_cast<std::size_t>(n);
+      size -= static_cast<std::size_t>(n);
+    }
+  }
+
+  bool readable() const {
+    auto const flags = ::fcntl(fd(), F_GETFL);
+    return flags != -1 && (flags & O_ACCMODE) != O_WRONLY;
+  }
+
+  // Reads after the end of the file give zeros.
+  void read_at(std::size_t pos, void* data, std::size_t size) const {
+    auto dst = static_cast<std::uint8_t*>(data);
+    while (size != 0U) {
+      auto const n = ::pread(fd(), dst, size, static_cast<off_t>(pos));
+      verify(n >= 0, "read error");
+      if (n == 0) {
+        std::memset(dst, 0, size);
+        return;
+      }
+      dst += n;
+      pos += static_cast<std::size_t>(n);
+      size -= static_cast<std::size_t>(n);
+    }
+  }
+
   FILE* f_{nullptr};
+  write_combiner mutable wc_;
   std::size_t size_{0U};
 };
 
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+
+#include "cista/aligned_alloc.h"
+#include "cista/chunked_hash.h"
+#include "cista/endian/bulk_swap.h"
+#include "cista/offset_t.h"
+#include "cista/serialized_size.h"
+#include "cista/unused_param.h"
+#include "cista/verify.h"
+
+namespace cista {
+
+// Target that records the layout of an image instead of writing it:
+// which memory is copied to which position and which values are patched
+// into the copied blocks afterwards. emit() replays the image strictly in
+// order, so it can be written to sinks that cannot seek.
+//
+// Block sources are referenced, not copied: they have to stay valid until
+// emit() is done. Only small blocks (header fields) are copied.
+// Blocks written with write_swapped() are byte swapped while replaying.
+struct recorder {
+  static constexpr auto const INLINE_SIZE = std::size_t{16U};
+  static constexpr auto const SWAP_BUF_SIZE = std::size_t{4096U};
+
+  struct block {
+    offset_t pos_;
+    std::size_t size_;
+    std::uint8_t const* src_;  // nullptr: stored in inline_data_
+    std::size_t inline_pos_;
+    std::size_t swap_width_;  // 0: copied as is
+  };
+
+  struct patch {
+    offset_t pos_;
+    std::uint64_t value_;
+    std::size_t size_;
+  };
+
+  template <typename T>
+  void write(std::size_t const pos, T const& val) {
+    static_assert(serialized_size<T>() <= sizeof(std::uint64_t));
+    auto p = patch{static_cast<offset_t>(pos), 0U, serialized_size<T>()};
+    std::memcpy(&p.value_, &val, serialized_size<T>());
+    patches_.emplace_back(p);
+  }
+
+  offset_t write(void const* ptr, std::size_t const num_bytes,
+                 std::size_t const alignment = 0U) {
+    return write_swapped(ptr, num_bytes, alignment, 0U);
+  }
+
+  // Records num_bytes of integers with width bytes each that are written
+  // with their byte order swapped.
+  offset_t write_swapped(void const* ptr, std::size_t const num_bytes,
+                         std::size_t const alignment,
+                         std::size_t const width) {
+    auto start = size_;
+    if (alignment > 1U && size_ != 0U) {
+      start = to_next_multiple(size_, alignment);
+    }
+    size_ = start + num_bytes;
+
+    auto const src = static_cast<std::uint8_t const*>(ptr);
+    if (num_bytes <= INLINE_SIZE) {
+      blocks_.emplace_back(block{static_cast<offset_t>(start), num_bytes,
+                                 nullptr, inline_data_.size(), 0U});
+      inline_data_.resize(inline_data_.size() + num_bytes);
+      copy_source(
+          block{static_cast<offset_t>(start), num_bytes, src, 0U, width},
+          &inline_data_[inline_data_.size() - num_bytes], 0U, num_bytes);
+    } else {
+      blocks_.emplace_back(
+          block{static_cast<offset_t>(start), num_bytes, src, 0U, width});
+    }
+    return static_cast<offset_t>(start);
+  }
+
+  std::uint64_t checksum(offset_t const start = 0U) const noexcept {
+    CISTA_UNUSED_PARAM(start)
+    return 0U;
+  }
+
+  std::uint64_t chunked_checksum(offset_t const start = 0U) const noexcept {
+    CISTA_UNUSED_PARAM(start)
+    return 0U;
+  }
+
+  std::uint64_t chunk_list_checksum(
+      offset_t const start = 0U,
+      integrity_hash const algo = DEFAULT_INTEGRITY_HASH) const noexcept {
+    CISTA_UNUSED_PARAM(start)
+    CISTA_UNUSED_PARAM(algo)
+    return 0U;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  // Patches are recorded in write order. Sorting has to be stable:
+  // later patches to a position win.
+  void sort_patches() {
+    std::stable_sort(
+        begin(patches_), end(patches_),
+        [](patch const& a, patch const& b) { return a.pos_ < b.pos_; });
+  }
+
+  // Calls fn(std::uint8_t const* data, std::size_t size) for consecutive
+  // pieces of the image: block contents with all patches applied and zero
+  // bytes for alignment padding. Requires sort_patches().
+  template <typename Fn>
+  void emit(Fn&& fn) const {
+    static constexpr std::uint8_t const zeros[INLINE_SIZE] = {0U};
+
+    auto curr = offset_t{0};
+    auto patch_it = begin(patches_);
+    for (auto const& b : blocks_) {
+      for (; curr < b.pos_;) {
+        auto const n = std::min(static_cast<std::size_t>(b.pos_ - curr),
+                                INLINE_SIZE);
+        fn(zeros, n);
+        curr += static_cast<offset_t>(n);
+      }
+
+      auto const block_end = b.pos_ + static_cast<offset_t>(b.size_);
+      for (; patch_it != end(patches_) && patch_it->pos_ < block_end;
+           ++patch_it) {
+        if (std::next(patch_it) != end(patches_) &&
+            std::next(patch_it)->pos_ == patch_it->pos_) {
+          continue;  // overwritten by a later patch
+        }
+        verify(patch_it->pos_ >= curr &&
+                   patch_it->pos_ + static_cast<offset_t>(patch_it->size_) <=
+                       block_end,
+               "recorder: patch outside of block");
+        if (patch_it->pos_ != curr) {
+          emit_source(b, static_cast<std::size_t>(curr - b.pos_),
+                      static_cast<std::size_t>(patch_it->pos_ - curr), fn);
+        }
+        fn(reinterpret_cast<std::uint8_t const*>(&patch_it->value_),
+           patch_it->size_);
+        curr = patch_it->pos_ + static_cast<offset_t>(patch_it->size_);
+      }
+      if (curr != block_end) {
+        emit_source(b, static_cast<std::size_t>(curr - b.pos_),
+                    static_cast<std::size_t>(block_end - curr), fn);
+      }
+      curr = block_end;
+    }
+    verify(patch_it == end(patches_), "recorder: patch outside of image");
+  }
+
+  // Writes the image bytes [from, to) to dst (dst[0] = image[from]).
+  // Disjoint ranges can be filled concurrently. Requires sort_patches().
+  void fill(std::uint8_t* dst, offset_t const from, offset_t const to) const {
+    auto curr = from;
+    auto block_it = std::upper_bound(
+        begin(blocks_), end(blocks_), from,
+        [](offset_t const pos, block const& b) { return pos < b.pos_; });
+    if (block_it != begin(blocks_)) {
+      --block_it;
+    }
+    for (; block_it != end(blocks_) && curr < to; ++block_it) {
+      auto const& b = *block_it;
+      auto const copy_from = std::max(curr, b.pos_);
+      auto const copy_to =
+          std::min(to, b.pos_ + static_cast<offset_t>(b.size_));
+      if (copy_from < copy_to) {
+        std::memset(dst + (curr - from), 0,
+                    static_cast<std::size_t>(copy_from - curr));
+        copy_source(b, dst + (copy_from - from),
+                    static_cast<std::size_t>(copy_from - b.pos_),
+                    static_cast<std::size_t>(copy_to - copy_from));
+        curr = copy_to;
+      }
+    }
+    std::memset(dst + (curr - from), 0, static_cast<std::size_t>(to - curr));
+
+    auto patch_it = std::lower_bound(
+        begin(patches_), end(patches_),
+        from - static_cast<offset_t>(sizeof(std::uint64_t)),
+        [](patch const& p, offset_t const pos) { return p.pos_ < pos; });
+    for (; patch_it != end(patches_) && patch_it->pos_ < to; ++patch_it) {
+      auto const patch_end =
+          patch_it->pos_ + static_cast<offset_t>(patch_it->size_);
+      auto const copy_from = std::max(from, patch_it->pos_);
+      auto const copy_to = std::min(to, patch_end);
+      if (copy_from < copy_to) {
+        std::memcpy(dst + (copy_from - from),
+                    reinterpret_cast<std::uint8_t const*>(&patch_it->value_) +
+                        (copy_from - patch_it->pos_),
+                    static_cast<std::size_t>(copy_to - copy_from));
+      }
+    }
+  }
+
+  std::uint8_t const* source(block const& b) const noexcept {
+    return b.src_ == nullptr ? &inline_data_[b.inline_pos_] : b.src_;
+  }
+
+  // Copies the block bytes [offset, offset + n) as they appear in the image.
+  void copy_source(block const& b, std::uint8_t* dst, std::size_t const offset,
+                   std::size_t const n) const noexcept {
+    if (b.swap_width_ == 0U) {
+      std::memcpy(dst, source(b) + offset, n);
+    } else {
+      copy_endian_swapped(dst, source(b), offset, n, b.swap_width_);
+    }
+  }
+
+  template <typename Fn>
+  void emit_source(block const& b, std::size_t offset, std::size_t n,
+                   Fn&& fn) const {
+    if (b.swap_width_ == 0U) {
+      fn(source(b) + offset, n);
+      return;
+    }
+    std::uint8_t swapped[SWAP_BUF_SIZE];
+    while (n != 0U) {
+      auto const size = std::min(n, SWAP_BUF_SIZE);
+      copy_source(b, swapped, offset, size);
+      fn(static_cast<std::uint8_t const*>(swapped), size);
+      offset += size;
+      n -= size;
+    }
+  }
+
+  std::vector<block> blocks_;
+  std::vector<patch> patches_;
+  std::vector<std::uint8_t> inline_data_;
+  std::size_t size_{0U};
+};
+
+}  // namespace cista
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cinttypes>
+
+#include "cista/aligned_alloc.h"
+#include "cista/chunked_hash.h"
+#include "cista/offset_t.h"
+#include "cista/unused_param.h"
+
+namespace cista {
+
+// Target that only tracks the size the written data would occupy.
+// Alignment is computed on offsets (like the file target). This matches buf
+// as long as the buffer base address satisfies the largest alignment used.
+struct size_counter {
+  template <typename T>
+  void write(std::size_t const pos, T const& val) noexcept {
+    CISTA_UNUSED_PARAM(pos)
+    CISTA_UNUSED_PARAM(val)
+  }
+
+  offset_t write(void const* ptr, std::size_t const num_bytes,
+                 std::size_t const alignment = 0U) noexcept {
+    CISTA_UNUSED_PARAM(ptr)
+    auto start = size_;
+    if (alignment > 1U && size_ != 0U) {
+      start = to_next_multiple(size_, alignment);
+    }
+    size_ = start + num_bytes;
+    return static_cast<offset_t>(start);
+  }
+
+  std::uint64_t checksum(offset_t const start = 0U) const noexcept {
+    CISTA_UNUSED_PARAM(start)
+    return 0U;
+  }
+
+  std::uint64_t chunked_checksum(offset_t const start = 0U) const noexcept {
+    CISTA_UNUSED_PARAM(start)
+    return 0U;
+  }
+
+  std::uint64_t chunk_list_checksum(
+      offset_t const start = 0U,
+      integrity_hash const algo = DEFAULT_INTEGRITY_HASH) const noexcept {
+    CISTA_UNUSED_PARAM(start)
+    CISTA_UNUSED_PARAM(algo)
+    return 0U;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  std::size_t size_{0U};
+};
+
+}  // namespace cista
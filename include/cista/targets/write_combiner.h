@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace cista {
+
+// Write combining for file targets. Serialization appends data and
+// back-patches small fields (offsets, sizes, checksums) at earlier
+// positions. Instead of one seek + write per field:
+//   - appended data is collected in a buffer at the end of the file,
+//     writes into this buffer are applied in memory
+//   - small writes to data that was already written out are queued and
+//     applied in batches sorted by position: patches close to each other
+//     are applied with a single read-modify-write of the covered range
+//
+// IO provides write_at(pos, data, size), read_at(pos, data, size) and
+// readable(). Patches to write-only handles are written one by one.
+struct write_combiner {
+  static constexpr auto const BUFFER_SIZE = std::size_t{8U * 1024U * 1024U};
+  static constexpr auto const MAX_PATCH_SIZE = std::size_t{8U};
+  static constexpr auto const MAX_PATCHES = std::size_t{1U << 20U};
+  static constexpr auto const PATCH_GAP = std::size_t{4096U};
+  static constexpr auto const MAX_PATCH_RANGE = std::size_t{1U << 20U};
+  static constexpr auto const MAX_INSERT_DISTANCE = 16U;
+
+  struct patch {
+    std::uint64_t pos_;
+    std::uint32_t seq_;
+    std::uint8_t size_;
+    std::uint8_t data_[MAX_PATCH_SIZE];
+  };
+
+  bool empty() const noexcept { return buf_.empty() && patches_.empty(); }
+
+  // end: file size including buffered data.
+  template <typename IO>
+  void write(IO const& io, std::size_t const end, std::size_t const pos,
+             void const* data, std::size_t const size) {
+    if (size == 0U) {
+      return;
+    }
+    auto const src = static_cast<std::uint8_t const*>(data);
+    if (!buf_.empty() && pos >= start_) {
+      auto const offset = pos - start_;
+      if (offset + size <= buf_.size()) {
+        std::memcpy(buf_.data() + offset, src, size);
+        return;
+      }
+      if (offset + size <= BUFFER_SIZE) {  // The buffer is the file end.
+        buf_.resize(offset + size);
+        std::memcpy(buf_.data() + offset, src, size);
+        return;
+      }
+      flush_buffer(io);
+    }
+
+    if (buf_.empty() && pos >= end && size < BUFFER_SIZE) {
+      buf_.reserve(BUFFER_SIZE);
+      buf_.assign(src, src + size);
+      start_ = pos;
+      return;
+    }
+
+    if (size <= MAX_PATCH_SIZE && pos + size <= (buf_.empty() ? end : start_)) {
+      auto p = patch{};
+      p.pos_ = pos;
+      p.seq_ = static_cast<std::uint32_t>(patches_.size());
+      p.size_ = static_cast<std::uint8_t>(size);
+      std::memcpy(p.data_, src, size);
+      insert(p);
+      if (patches_.size() == MAX_PATCHES) {
+        apply_patches(io);
+      }
+      return;
+    }
+
+    flush(io);
+    io.write_at(pos, src, size);
+  }
+
+  // Patches arrive almost sorted (fields of one object are written in
+  // arbitrary order, objects in increasing order). Keep them sorted with
+  // a bounded insertion step, fall back to sorting the whole batch.
+  void insert(patch const& p) {
+    patches_.push_back(p);
+    if (!sorted_) {
+      return;
+    }
+    auto const first = begin(patches_);
+    auto it = std::prev(end(patches_));
+    for (auto i = 0U; it != first && std::prev(it)->pos_ > p.pos_; ++i, --it) {
+      if (i == MAX_INSERT_DISTANCE) {
+        sorted_ = false;
+        return;
+      }
+      std::iter_swap(it, std::prev(it));
+    }
+  }
+
+  // Drops everything that was not written if writing fails.
+  template <typename IO>
+  void flush(IO const& io) {
+    try {
+      flush_buffer(io);
+      apply_patches(io);
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+
+  void clear() noexcept {
+    buf_.clear();
+    patches_.clear();
+    sorted_ = true;
+  }
+
+  template <typename IO>
+  void flush_buffer(IO const& io) {
+    if (!buf_.empty()) {
+      io.write_at(start_, buf_.data(), buf_.size());
+      start_ += buf_.size();
+      buf_.clear();
+    }
+  }
+
+  template <typename IO>
+  void apply_patches(IO const& io) {
+    if (!patches_.empty() && !io.readable()) {
+      std::sort(begin(patches_), end(patches_),
+                [](patch const& a, patch const& b) { return a.seq_ < b.seq_; });
+      for (auto const& p : patches_) {
+        io.write_at(p.pos_, p.data_, p.size_);
+      }
+      clear();
+      return;
+    }
+
+    if (!sorted_) {
+      std::sort(begin(patches_), end(patches_),
+                [](patch const& a, patch const& b) {
+                  return a.pos_ < b.pos_ ||
+                         (a.pos_ == b.pos_ && a.seq_ < b.seq_);
+                });
+    }
+
+    for (auto it = begin(patches_); it != end(patches_);) {
+      auto const from = it->pos_;
+      auto to = it->pos_ + it->size_;
+      auto overlap = false;
+      auto last = std::next(it);
+      for (; last != end(patches_); ++last) {
+        if (last->pos_ < to) {
+          overlap = true;
+        } else if (last->pos_ > to + PATCH_GAP ||
+                   to - from >= MAX_PATCH_RANGE) {
+          break;
+        }
+        to = std::max(to, last->pos_ + last->size_);
+      }
+
+      if (last == std::next(it)) {
+        io.write_at(from, it->data_, it->size_);
+      } else {
+        if (overlap) {  // Later writes have to win.
+          std::sort(it, last, [](patch const& a, patch const& b) {
+            return a.seq_ < b.seq_;
+          });
+        }
+        range_.resize(to - from);
+        io.read_at(from, range_.data(), range_.size());
+        for (; it != last; ++it) {
+          std::memcpy(range_.data() + (it->pos_ - from), it->data_, it->size_);
+        }
+        io.write_at(from, range_.data(), range_.size());
+      }
+      it = last;
+    }
+    clear();
+  }
+
+  std::size_t start_{0U};
+  std::vector<std::uint8_t> buf_;
+  std::vector<patch> patches_;
+  std::vector<std::uint8_t> range_;
+  bool sorted_{true};
+};
+
+}  // namespace cista
@@ -182,8 +182,11 @@ hash_t type_hash(
 
 template <typename T>
 hash_t type_hash() {
-  auto done = std::map<hash_t, unsigned>{};
-  return type_hash(T{}, BASE_HASH, done);
+  static auto const h = []() {
+    auto done = std::map<hash_t, unsigned>{};
+    return type_hash(T{}, BASE_HASH, done);
+  }();
+  return h;
 }
 
 }  // namespace cista
@@ -0,0 +1,173 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/arena.h"
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+
+namespace arena_test {
+
+struct entry {
+  std::uint32_t id_;
+  data::string name_;
+  data::vector<std::uint64_t> values_;
+};
+
+struct root {
+  data::vector<entry> entries_;
+  data::hash_map<data::string, std::uint32_t> by_name_;
+  data::hash_set<std::uint32_t> empty_;
+  data::unique_ptr<entry> first_;
+  data::vector<data::vector<std::uint8_t>> nested_;
+};
+
+inline void fill(root& r, std::uint32_t const n) {
+  for (auto i = 0U; i != n; ++i) {
+    auto e = entry{};
+    e.id_ = i;
+    e.name_ = "entry number " + std::to_string(i) + " (not a short string)";
+    for (auto j = 0U; j != i % 7U; ++j) {
+      e.values_.push_back(i * j);
+    }
+    r.by_name_.emplace(e.name_, i);
+    r.entries_.emplace_back(std::move(e));
+  }
+  r.first_ = data::make_unique<entry>();
+  r.first_->id_ = 42U;
+  r.first_->name_ = "the first entry";
+  r.nested_.resize(3U);
+  r.nested_[2U].push_back(7U);
+}
+
+inline void check(root const& r, std::uint32_t const n) {
+  REQUIRE(r.entries_.size() == n);
+  auto mismatches = 0U;
+  for (auto i = 0U; i != n; ++i) {
+    auto const& e = r.entries_[i];
+    auto const name =
+        "entry number " + std::to_string(i) + " (not a short string)";
+    auto const it = r.by_name_.find(name);
+    if (e.id_ != i || e.name_ != name || e.values_.size() != i % 7U ||
+        (!e.values_.empty() && e.values_.back() != i * (i % 7U - 1U)) ||
+        it == r.by_name_.end() || it->second != i) {
+      ++mismatches;
+    }
+  }
+  CHECK(mismatches == 0U);
+  CHECK(r.empty_.empty());
+  CHECK(r.empty_.find(1U) == r.empty_.end());
+  REQUIRE(r.first_ != nullptr);
+  CHECK(r.first_->id_ == 42U);
+  CHECK(r.first_->name_ == "the first entry");
+  REQUIRE(r.nested_.size() == 3U);
+  CHECK(r.nested_[0U].empty());
+  CHECK(r.nested_[2U][0U] == 7U);
+}
+
+}  // namespace arena_test
+
+using namespace arena_test;
+
+TEST_CASE("arena serialize") {
+  constexpr auto const n = 1000U;
+  constexpr auto const MODE = cista::mode::ARENA | cista::mode::WITH_VERSION |
+                              cista::mode::WITH_INTEGRITY;
+
+  auto a = cista::arena{64U * 1024U * 1024U};
+  auto const r = a.create<root>();
+  {
+    auto const scope = cista::arena_scope{a};
+    fill(*r, n);
+  }
+  check(*r, n);
+  CHECK(a.contains(r->entries_.data()));
+  CHECK(a.contains(r->entries_[3U].name_.data()));
+  CHECK(!r->entries_.self_allocated_);
+
+  auto const buf = cista::serialize_arena<MODE>(a, *r);
+  check(*cista::deserialize<root, MODE>(buf), n);
+  auto copy = buf;
+  check(*cista::deserialize<root, MODE | cista::mode::DEEP_CHECK>(copy), n);
+
+  {
+    auto f = cista::file{"arena.bin", "w+"};
+    cista::serialize_arena<MODE>(f, a, *r);
+  }
+  {
+    auto f = cista::file{"arena.bin", "r"};
+    auto const content = f.content();
+    REQUIRE(content.size() == buf.size());
+    CHECK(std::memcmp(content.data(), buf.data(), buf.size()) == 0);
+  }
+
+  // Same contents as the regular serializer.
+  auto heap = root{};
+  fill(heap, n);
+  auto const heap_buf = cista::serialize<MODE>(heap);
+  check(*cista::deserialize<root, MODE>(heap_buf), n);
+
+  CHECK_THROWS(cista::serialize_arena<MODE>(a, r->by_name_));
+}
+
+static_assert(cista::is_offset_only_v<root>);
+static_assert(cista::is_offset_only_v<data::vector<data::ptr<entry>>>);
+static_assert(!cista::is_offset_only_v<cista::raw::vector<int>>);
+static_assert(!cista::is_offset_only_v<cista::raw::string>);
+static_assert(!cista::is_offset_only_v<data::vector<cista::raw::string>>);
+static_assert(!cista::is_offset_only_v<cista::optional<int*>>);
+
+TEST_CASE("arena vector capacity") {
+  struct values {
+    data::vector<std::uint64_t> v_;
+  };
+
+  auto a = cista::arena{4096U};
+  auto const r = a.create<values>();
+  {
+    auto const scope = cista::arena_scope{a};
+    for (auto i = 0U; i != 5U; ++i) {
+      r->v_.push_back(i);
+    }
+  }
+  REQUIRE(r->v_.allocated_size_ > r->v_.used_size_);
+
+  constexpr auto const MODE = cista::mode::ARENA;
+  auto const buf = cista::serialize_arena(a, *r);
+  auto const d = cista::deserialize<values, MODE>(buf);
+  CHECK(d->v_.size() == 5U);
+  CHECK(d->v_.back() == 4U);
+
+  // Spare capacity is only accepted in arena mode.
+  CHECK_THROWS(cista::deserialize<values>(buf));
+
+  // Capacity outside of the image or below the size.
+  auto const capacity_offset = cista_member_offset(values, v_) +
+                               cista_member_offset(decltype(r->v_),
+                                                   allocated_size_);
+  for (auto const capacity : {std::uint32_t{1000U}, std::uint32_t{4U}}) {
+    auto copy = buf;
+    std::memcpy(&copy[capacity_offset], &capacity, sizeof(capacity));
+    CHECK_THROWS(cista::deserialize<values, MODE>(copy));
+  }
+}
+
+TEST_CASE("arena limits") {
+  auto a = cista::arena{4096U};
+  auto const r = a.create<root>();
+  {
+    auto const scope = cista::arena_scope{a};
+    CHECK_THROWS_AS(r->nested_.resize(1000U), std::bad_alloc);
+  }
+
+  // Heap allocated data in the arena: not a valid image.
+  auto b = cista::arena{4096U};
+  auto const s = b.create<root>();
+  s->first_ = data::make_unique<entry>();
+  CHECK(s->first_.self_allocated_);
+  auto const buf = cista::serialize_arena(b, *s);
+  CHECK_THROWS(cista::deserialize<root, cista::mode::ARENA>(buf));
+}
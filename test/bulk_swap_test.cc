@@ -0,0 +1,189 @@
+#include <numeric>
+
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/endian/bulk_swap.h"
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+
+namespace bulk_swap_test {
+
+struct integers {
+  data::vector<std::uint16_t> u16_;
+  data::vector<std::int32_t> i32_;
+  data::vector<std::uint64_t> u64_;
+  data::array<std::uint32_t, 13U> array_;
+  data::vector<data::array<std::int16_t, 3U>> arrays_;
+  data::u16string short_;
+  data::u16string long_;  // 4 byte multiple: keeps the u32string aligned
+  data::u32string u32_;
+};
+
+inline integers make_integers(std::uint32_t const n) {
+  auto x = integers{};
+  for (auto i = 0U; i != n; ++i) {
+    x.u16_.push_back(static_cast<std::uint16_t>(i * 0x0102U));
+    x.i32_.push_back(-static_cast<std::int32_t>(i * 0x01020304U / 2U));
+    x.u64_.push_back(i * 0x0102030405060708ULL);
+  }
+  for (auto i = 0U; i != x.array_.size(); ++i) {
+    x.array_[i] = i * 0xA1B2C3D4U;
+  }
+  x.arrays_.resize(8U);
+  x.arrays_[3U][1U] = 0x1234;
+  x.short_ = u"short";
+  x.long_ = u"a char16_t string that is too long for the SSO";
+  x.u32_ = U"a char32_t string that is too long for the SSO";
+  return x;
+}
+
+inline void check_integers(integers const& x, std::uint32_t const n) {
+  REQUIRE(x.u16_.size() == n);
+  REQUIRE(x.i32_.size() == n);
+  REQUIRE(x.u64_.size() == n);
+  auto mismatches = 0U;
+  for (auto i = 0U; i != n; ++i) {
+    if (x.u16_[i] != static_cast<std::uint16_t>(i * 0x0102U) ||
+        x.i32_[i] != -static_cast<std::int32_t>(i * 0x01020304U / 2U) ||
+        x.u64_[i] != i * 0x0102030405060708ULL) {
+      ++mismatches;
+    }
+  }
+  CHECK(mismatches == 0U);
+  for (auto i = 0U; i != x.array_.size(); ++i) {
+    CHECK(x.array_[i] == i * 0xA1B2C3D4U);
+  }
+  CHECK(x.arrays_[3U][1U] == 0x1234);
+  CHECK(x.short_ == u"short");
+  CHECK(x.long_ == u"a char16_t string that is too long for the SSO");
+  CHECK(x.u32_ == U"a char32_t string that is too long for the SSO");
+}
+
+template <typename T>
+std::vector<std::uint8_t> scalar_swap(std::vector<std::uint8_t> const& in,
+                                      std::size_t const offset,
+                                      std::size_t const n) {
+  auto out = std::vector<std::uint8_t>(n * sizeof(T));
+  for (auto i = 0U; i != n; ++i) {
+    auto x = T{};
+    std::memcpy(&x, &in[offset + i * sizeof(T)], sizeof(T));
+    x = cista::endian_swap(x);
+    std::memcpy(&out[i * sizeof(T)], &x, sizeof(T));
+  }
+  return out;
+}
+
+template <typename T>
+void check_swap(std::vector<std::uint8_t> const& in) {
+  for (auto const offset : {0U, 1U, 3U}) {
+    for (auto const n : {0U, 1U, 7U, 8U, 15U, 16U, 63U, 64U, 129U, 1000U}) {
+      auto const expected = scalar_swap<T>(in, offset, n);
+
+      auto out = std::vector<std::uint8_t>(n * sizeof(T));
+      cista::endian_swap_n(out.data(), &in[offset], n, sizeof(T));
+      CHECK(out == expected);
+
+      auto in_place = std::vector<std::uint8_t>(
+          begin(in) + offset,
+          begin(in) + static_cast<std::ptrdiff_t>(offset + n * sizeof(T)));
+      cista::endian_swap_n(in_place.data(), in_place.data(), n, sizeof(T));
+      CHECK(in_place == expected);
+
+      auto partial = std::vector<std::uint8_t>(n * sizeof(T));
+      for (auto const from : {0U, 1U, 5U, 9U}) {
+        if (from + from % 3U <= partial.size()) {
+          auto const size = partial.size() - from - (from % 3U);
+          cista::copy_endian_swapped(partial.data(), &in[offset], from, size,
+                                     sizeof(T));
+          CHECK(std::equal(partial.data(), partial.data() + size,
+                           expected.data() + from));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace bulk_swap_test
+
+using namespace bulk_swap_test;
+
+TEST_CASE("bulk endian swap") {
+  auto in = std::vector<std::uint8_t>(9000U);
+  std::iota(begin(in), end(in), std::uint8_t{0U});
+
+  check_swap<std::uint16_t>(in);
+  check_swap<std::uint32_t>(in);
+  check_swap<std::uint64_t>(in);
+
+  auto v = std::vector<std::uint32_t>{0x01020304U, 0xA1B2C3D4U};
+  cista::endian_swap_n(v.data(), v.size());
+  CHECK(v[0] == 0x04030201U);
+  CHECK(v[1] == 0xD4C3B2A1U);
+}
+
+TEST_CASE("bulk endian conversion serialize / deserialize") {
+  constexpr auto const MODE =
+      cista::mode::SERIALIZE_BIG_ENDIAN | cista::mode::WITH_VERSION;
+  constexpr auto const n = 70'000U;  // u64_: converted by two workers
+
+  auto x = make_integers(n);
+  auto const buf = cista::serialize<MODE>(x);
+
+  // Big endian in the image.
+  auto const first = std::array<std::uint8_t, 8U>{0x01U, 0x02U, 0x03U, 0x04U,
+                                                  0x05U, 0x06U, 0x07U, 0x08U};
+  CHECK(std::search(begin(buf), end(buf), begin(first), end(first)) !=
+        end(buf));
+
+  CHECK(cista::serialize_parallel<MODE>(x, 3U) == buf);
+
+  auto streamed = cista::byte_buf{};
+  cista::serialize_stream<MODE>(
+      [&](std::uint8_t const* data, std::size_t const size) {
+        streamed.insert(end(streamed), data, data + size);
+      },
+      x);
+  CHECK(streamed == buf);
+
+  {
+    auto f = cista::file{"bulk_swap.bin", "w+"};
+    cista::serialize<MODE>(f, x);
+  }
+  {
+    auto f = cista::file{"bulk_swap.bin", "r"};
+    auto const content = f.content();
+    REQUIRE(content.size() == buf.size());
+    CHECK(std::memcmp(content.data(), buf.data(), buf.size()) == 0);
+  }
+
+  auto copy = buf;
+  check_integers(*cista::deserialize<integers, MODE>(copy), n);
+
+  copy = buf;
+  check_integers(*cista::deserialize_parallel<integers, MODE>(copy, 3U), n);
+
+  constexpr auto const DEEP = MODE | cista::mode::DEEP_CHECK;
+  auto deep = cista::serialize<DEEP>(x);
+  check_integers(*cista::deserialize<integers, DEEP>(deep), n);
+}
+
+TEST_CASE("bulk endian conversion of an empty long string") {
+  constexpr auto const MODE = cista::mode::SERIALIZE_BIG_ENDIAN;
+
+  // Not short, but empty: no payload, null pointer in the image.
+  auto s = data::u32string{};
+  s.h_.is_short_ = false;
+  s.h_.self_allocated_ = false;
+  s.h_.ptr_ = U"";
+  s.h_.size_ = 0U;
+
+  auto buf = cista::serialize<MODE>(s);
+  CHECK(cista::serialize_parallel<MODE>(s, 2U) == buf);
+  auto const d = cista::deserialize<data::u32string, MODE>(buf);
+  CHECK(d->empty());
+}
@@ -0,0 +1,158 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+
+namespace chunked_integrity_test {
+
+struct payload {
+  std::uint32_t id_;
+  data::vector<std::uint64_t> values_;
+  data::string name_;
+};
+
+inline payload make_payload() {
+  auto p = payload{};
+  p.id_ = 42U;
+  p.values_.resize(1'000'000U);  // 8 MB: 16 hash chunks
+  for (auto i = 0U; i != p.values_.size(); ++i) {
+    p.values_[i] = i * 3ULL;
+  }
+  p.name_ = "a name that does not fit the short string buffer";
+  return p;
+}
+
+}  // namespace chunked_integrity_test
+
+using namespace chunked_integrity_test;
+
+TEST_CASE("crc32c") {
+  CHECK(cista::crc32c("") == 0U);
+  CHECK(cista::crc32c("123456789") == 0xE3069283U);
+  CHECK(cista::crc32c("56789", cista::crc32c("1234")) == 0xE3069283U);
+
+  auto s = std::string(32768U + 13U, '\0');
+  for (auto i = 0U; i != s.size(); ++i) {
+    s[i] = static_cast<char>(i * 131U + (i >> 7U));
+  }
+  for (auto const offset : {0U, 1U, 3U, 7U}) {
+    for (auto const size : {0U, 1U, 5U, 8U, 63U, 4096U, 12288U, 32768U}) {
+      auto const data =
+          reinterpret_cast<std::uint8_t const*>(s.data()) + offset;
+      CHECK(cista::crc32c_detail::hardware(~0U, data, size) ==
+            cista::crc32c_detail::portable(~0U, data, size));
+    }
+  }
+}
+
+TEST_CASE("chunk list hash is independent of the thread count") {
+  auto s = std::string(5U * cista::HASH_CHUNK_SIZE + 17U, '\0');
+  for (auto i = 0U; i != s.size(); ++i) {
+    s[i] = static_cast<char>(i * 7U);
+  }
+
+  for (auto const algo :
+       {cista::integrity_hash::CISTA_HASH, cista::integrity_hash::CRC32C}) {
+    auto const h = cista::chunk_list_hash(s, algo, 1U);
+    for (auto const n_threads : {0U, 2U, 3U, 6U, 64U}) {
+      CHECK(cista::chunk_list_hash(s, algo, n_threads) == h);
+    }
+    CHECK(cista::chunk_list_hash(std::string_view{}, algo, 4U) ==
+          cista::chunk_list_hash(std::string_view{}, algo, 1U));
+
+    auto changed = s;
+    changed[3U * cista::HASH_CHUNK_SIZE] ^= 1;
+    CHECK(cista::chunk_list_hash(changed, algo) != h);
+  }
+}
+
+TEST_CASE("chunked integrity") {
+  constexpr auto const MODE =
+      cista::mode::WITH_VERSION | cista::mode::WITH_CHUNKED_INTEGRITY;
+
+  auto p = make_payload();
+  auto buf = cista::serialize<MODE>(p);
+  CHECK(cista::serialize_parallel<MODE>(p, 4U) == buf);
+
+  {
+    auto f = cista::file{"chunked_integrity.bin", "w+"};
+    cista::serialize<MODE>(f, p);
+  }
+  {
+    auto f = cista::file{"chunked_integrity.bin", "r"};
+    auto const content = f.content();
+    REQUIRE(content.size() == buf.size());
+    CHECK(std::memcmp(content.data(), buf.data(), buf.size()) == 0);
+  }
+
+  auto const d = cista::deserialize<payload, MODE>(buf);
+  CHECK(d->id_ == 42U);
+  CHECK(d->values_.size() == 1'000'000U);
+  CHECK(d->values_.back() == 999'999U * 3ULL);
+
+  // The header records the hash function: images written with another
+  // integrity hash can be checked, unknown hashes are rejected.
+  auto const algo_pos = sizeof(cista::hash_t);
+  auto const csum_pos = algo_pos + sizeof(std::uint64_t);
+  auto const data_pos = csum_pos + sizeof(std::uint64_t);
+  auto other = cista::serialize<MODE>(p);
+  auto const algo =
+      static_cast<std::uint64_t>(cista::integrity_hash::CISTA_HASH);
+  auto const csum = cista::chunk_list_hash(
+      std::string_view{reinterpret_cast<char const*>(other.data() + data_pos),
+                       other.size() - data_pos},
+      cista::integrity_hash::CISTA_HASH);
+  std::memcpy(&other[algo_pos], &algo, sizeof(algo));
+  std::memcpy(&other[csum_pos], &csum, sizeof(csum));
+  CHECK(cista::deserialize<payload, MODE>(other)->id_ == 42U);
+
+  auto unknown = cista::serialize<MODE>(p);
+  unknown[algo_pos] = 7U;
+  CHECK_THROWS(cista::deserialize<payload, MODE>(unknown));
+
+  auto corrupted = cista::serialize<MODE>(p);
+  corrupted[corrupted.size() / 2U] ^= 1U;
+  CHECK_THROWS(cista::deserialize<payload, MODE>(corrupted));
+
+  constexpr auto const BE_MODE =
+      MODE | cista::mode::SERIALIZE_BIG_ENDIAN | cista::mode::DEEP_CHECK;
+  auto be_buf = cista::serialize<BE_MODE>(p);
+  CHECK(cista::deserialize<payload, BE_MODE>(be_buf)->values_[7U] == 21U);
+}
+
+TEST_CASE("chunked integrity computed while writing") {
+  constexpr auto const MODE = cista::mode::WITH_CHUNKED_INTEGRITY;
+
+  // Forward pointers are patched after the chunks containing them were
+  // hashed: these chunks have to be hashed again.
+  struct forward_refs {
+    data::vector<data::ptr<std::uint64_t>> refs_;
+    data::indexed_vector<std::uint64_t> values_;
+  } x;
+  x.values_.resize(1'000'000U);
+  for (auto i = 0U; i != x.values_.size(); i += 1'000U) {
+    x.values_[i] = i;
+    x.refs_.push_back(&x.values_[i]);
+  }
+
+  auto const buf = cista::serialize<MODE>(x);
+  CHECK(cista::serialize_parallel<MODE>(x, 2U) == buf);
+
+  {
+    auto f = cista::file{"chunked_integrity_refs.bin", "w+"};
+    cista::serialize<MODE>(f, x);
+  }
+  auto f = cista::file{"chunked_integrity_refs.bin", "r"};
+  auto const content = f.content();
+  REQUIRE(content.size() == buf.size());
+  CHECK(std::memcmp(content.data(), buf.data(), buf.size()) == 0);
+
+  auto copy = buf;
+  auto const d = cista::deserialize<forward_refs, MODE>(copy);
+  CHECK(*d->refs_[999U] == 999'000U);
+}
@@ -0,0 +1,227 @@
+#include <random>
+
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/compressed.h"
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+namespace lz = cista::lz;
+
+namespace compressed_test {
+
+struct node {
+  std::uint32_t id_;
+  data::string name_;
+  data::vector<std::uint32_t> edges_;
+  data::unique_ptr<node> next_;
+};
+
+struct graph {
+  data::indexed_vector<node> nodes_;
+  data::array<std::uint16_t, 4> flags_;
+  data::ptr<node> last_;
+};
+
+inline void fill(graph& g, std::uint32_t const n) {
+  for (auto i = 0U; i != n; ++i) {
+    auto& x = g.nodes_.emplace_back();
+    x.id_ = i;
+    x.name_ = i % 2U == 0U ? "n" + std::to_string(i)
+                           : "node with a long name " + std::to_string(i);
+    x.edges_ = {i, i + 1U, i + 2U};
+  }
+  g.nodes_[7U].next_ = data::make_unique<node>();
+  g.nodes_[7U].next_->id_ = 99U;
+  g.flags_ = {1U, 2U, 3U, 4U};
+  g.last_ = &g.nodes_.back();
+}
+
+}  // namespace compressed_test
+
+using namespace compressed_test;
+
+TEST_CASE("lz round trip") {
+  auto rng = std::mt19937{42U};
+  auto const check = [](std::vector<std::uint8_t> const& in) {
+    auto c = std::vector<std::uint8_t>(lz::compress_bound(in.size()));
+    auto const c_size = lz::compress(in.data(), in.size(), c.data(), c.size());
+    REQUIRE(c_size != 0U);
+    auto out = std::vector<std::uint8_t>(in.size());
+    CHECK(lz::decompress(c.data(), c_size, out.data(), out.size()) ==
+          in.size());
+    CHECK(out == in);
+    return c_size;
+  };
+
+  check({});
+  check({1U, 2U, 3U});
+
+  auto zeros = std::vector<std::uint8_t>(100000U);
+  CHECK(check(zeros) < 1000U);
+
+  auto random = std::vector<std::uint8_t>(100000U);
+  for (auto& b : random) {
+    b = static_cast<std::uint8_t>(rng());
+  }
+  CHECK(check(random) <= lz::compress_bound(random.size()));
+
+  auto text = std::vector<std::uint8_t>{};
+  for (auto i = 0U; text.size() < 100000U; ++i) {
+    auto const s = "word" + std::to_string(rng() % 500U) + " ";
+    text.insert(end(text), begin(s), end(s));
+  }
+  CHECK(check(text) < text.size() / 2U);
+
+  // Too small output buffers are detected.
+  auto c = std::vector<std::uint8_t>(lz::compress_bound(text.size()));
+  auto const c_size =
+      lz::compress(text.data(), text.size(), c.data(), c.size());
+  CHECK(lz::compress(text.data(), text.size(), c.data(), 100U) == 0U);
+  auto out = std::vector<std::uint8_t>(text.size() - 1U);
+  CHECK(lz::decompress(c.data(), c_size, out.data(), out.size()) ==
+        lz::DECOMPRESS_ERROR);
+
+  // Malformed input never leaves the buffers.
+  out.resize(text.size());
+  for (auto i = 0U; i != 1000U; ++i) {
+    auto corrupt = std::vector<std::uint8_t>(c.begin(), c.begin() + c_size);
+    corrupt[rng() % corrupt.size()] = static_cast<std::uint8_t>(rng());
+    corrupt.resize(corrupt.size() - rng() % 16U);
+    lz::decompress(corrupt.data(), corrupt.size(), out.data(), out.size());
+  }
+}
+
+TEST_CASE("compressed image") {
+  constexpr auto const MODE = cista::mode::WITH_VERSION;
+  constexpr auto const n = 20000U;
+
+  auto g = graph{};
+  fill(g, n);
+  auto const buf = cista::serialize<MODE>(g);
+  auto const compressed = cista::serialize_compressed<MODE>(g, 4096U);
+  CHECK(compressed.size() < buf.size() / 2U);
+  CHECK(cista::decompress(compressed) == buf);
+  CHECK(cista::serialize_compressed<MODE>(g, 4096U, 1U) == compressed);
+  CHECK(cista::compress(buf, 4096U, 3U) == compressed);
+
+  auto const img = cista::compressed_image{compressed, 8U};
+  CHECK(img.size() == buf.size());
+  auto const root = cista::view_compressed<graph, MODE>(img);
+  auto const nodes = root.get(&graph::nodes_);
+  REQUIRE(nodes.size() == n);
+
+  auto const x = nodes[12345U];
+  CHECK(x.get(&node::id_) == 12345U);
+  CHECK(x.get(&node::name_).str() == "node with a long name 12345");
+  CHECK(nodes[12344U].get<1>().str() == "n12344");
+  CHECK(nodes[12344U].get<1>().size() == 6U);
+  auto const edges = x.get(&node::edges_);
+  REQUIRE(edges.size() == 3U);
+  CHECK(edges[2U] == 12347U);
+  CHECK(!x.get(&node::next_));
+  REQUIRE(nodes[7U].get(&node::next_));
+  CHECK((*nodes[7U].get(&node::next_)).get(&node::id_) == 99U);
+  CHECK((*root.get(&graph::last_)).get(&node::id_) == n - 1U);
+  CHECK(root.get(&graph::flags_)[3U] == 4U);
+  CHECK_THROWS(nodes.at(n));
+
+  // Random access decompresses only a few blocks, the cache stays bounded.
+  CHECK(img.n_decompressed() < 16U);
+  auto sum = std::uint64_t{0U};
+  for (auto const e : nodes) {
+    sum += e.get(&node::id_);
+  }
+  CHECK(sum == std::uint64_t{n} * (n - 1U) / 2U);
+  CHECK(img.cache_.size() == 8U);
+
+  CHECK_THROWS(cista::view_compressed<node, MODE>(img));
+}
+
+TEST_CASE("compressed image corrupt") {
+  auto v = data::vector<std::uint64_t>{};
+  for (auto i = 0U; i != 10000U; ++i) {
+    v.push_back(i % 100U);
+  }
+  auto compressed = cista::serialize_compressed(v, 1024U);
+
+  auto const good = cista::compressed_image{compressed};
+  CHECK(cista::view_compressed<data::vector<std::uint64_t>>(good)[9999U] ==
+        99U);
+
+  compressed[compressed.size() - 10U] ^= 0xFFU;
+  auto const bad = cista::compressed_image{compressed};
+  auto const view = cista::view_compressed<data::vector<std::uint64_t>>(bad);
+  CHECK(view[0U] == 0U);
+  CHECK_THROWS(static_cast<std::uint64_t>(view[9999U]));
+  CHECK_THROWS(cista::decompress(compressed));
+
+  compressed.resize(100U);
+  CHECK_THROWS(cista::compressed_image{compressed});
+}
+
+TEST_CASE("compressed image untrusted header") {
+  auto v = data::vector<std::uint64_t>{};
+  for (auto i = 0U; i != 10000U; ++i) {
+    v.push_back(i % 100U);
+  }
+  auto const compressed = cista::serialize_compressed(v, 1024U);
+
+  auto const error = [](cista::byte_buf const& c) {
+    try {
+      cista::compressed_image{c};
+    } catch (std::exception const& e) {
+      return std::string{e.what()};
+    }
+    return std::string{};
+  };
+  auto const with_header = [&](auto&& modify) {
+    auto c = compressed;
+    auto h = cista::compressed_header{};
+    std::memcpy(&h, c.data(), sizeof(h));
+    cista::convert_compressed_endian(h);
+    modify(h);
+    cista::convert_compressed_endian(h);
+    std::memcpy(c.data(), &h, sizeof(h));
+    return c;
+  };
+  auto const with_block = [&](std::size_t const i, auto&& modify) {
+    auto c = compressed;
+    auto const pos =
+        sizeof(cista::compressed_header) + i * sizeof(cista::compressed_block);
+    auto b = cista::compressed_block{};
+    std::memcpy(&b, c.data() + pos, sizeof(b));
+    cista::convert_compressed_endian(b);
+    modify(b);
+    cista::convert_compressed_endian(b);
+    std::memcpy(c.data() + pos, &b, sizeof(b));
+    return c;
+  };
+
+  CHECK(error(compressed).empty());
+
+  // Block size beyond the maximum (allocated for every cached block).
+  CHECK(error(with_header([](cista::compressed_header& h) {
+          h.block_size_ = std::uint64_t{1U} << 32U;
+          h.size_ = h.block_size_ * h.n_blocks_;
+        })) == "compressed: invalid block size");
+
+  // A stored block of one byte cannot expand to a block of 1 KiB.
+  CHECK(error(with_block(0U, [](cista::compressed_block& b) {
+          b.size_ = 1U;
+        })) == "compressed: invalid block size");
+
+  // Stored size larger than the block.
+  CHECK(error(with_block(0U, [](cista::compressed_block& b) {
+          b.size_ = 1025U;
+        })) == "compressed: invalid block size");
+
+  // Blocks sharing their data.
+  CHECK(error(with_block(1U, [](cista::compressed_block& b) {
+          b.offset_ = 0U;
+        })) == "compressed: block out of bounds");
+}
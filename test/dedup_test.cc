@@ -0,0 +1,113 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace dedup_test {
+
+template <template <typename> typename Ptr>
+struct containers {
+  using string = cista::basic_string<Ptr<char const>>;
+  template <typename T>
+  using vector = cista::basic_vector<T, Ptr>;
+  template <typename T>
+  using indexed_vector = cista::basic_vector<T, Ptr, true>;
+  template <typename T>
+  using ptr = Ptr<T>;
+};
+
+using offset_containers = containers<cista::offset::ptr>;
+using raw_containers = containers<cista::raw::ptr>;
+
+template <typename Ns>
+struct stop {
+  typename Ns::string name_;
+  typename Ns::template vector<std::uint32_t> tags_;
+  typename Ns::template vector<std::uint8_t> bytes_;
+};
+
+template <typename Ns>
+struct timetable {
+  typename Ns::template vector<stop<Ns>> stops_;
+  typename Ns::template indexed_vector<std::uint32_t> indexed_;
+  typename Ns::template ptr<std::uint32_t> first_;
+};
+
+template <typename Ns>
+timetable<Ns> make_timetable() {
+  auto t = timetable<Ns>{};
+  for (auto i = 0U; i != 1000U; ++i) {
+    auto s = stop<Ns>{};
+    s.name_ = "Central Station, Platform " + std::to_string(i % 10U);
+    s.tags_ = {i % 3U, 7U, 8U, 9U};
+    s.bytes_ = {0U, 0U, 0U, 0U, 7U, 0U, 0U, 0U};
+    t.stops_.emplace_back(std::move(s));
+  }
+  t.indexed_ = {1U, 2U, 3U};
+  t.first_ = &t.indexed_[1U];
+  return t;
+}
+
+template <typename Ns>
+void check_timetable(timetable<Ns> const& t) {
+  REQUIRE(t.stops_.size() == 1000U);
+  auto mismatches = 0U;
+  for (auto i = 0U; i != t.stops_.size(); ++i) {
+    auto const& s = t.stops_[i];
+    if (s.name_ != "Central Station, Platform " + std::to_string(i % 10U) ||
+        s.tags_.size() != 4U || s.tags_[0U] != i % 3U || s.tags_[3U] != 9U ||
+        s.bytes_.size() != 8U || s.bytes_[4U] != 7U) {
+      ++mismatches;
+    }
+  }
+  CHECK(mismatches == 0U);
+  REQUIRE(t.first_ != nullptr);
+  CHECK(*t.first_ == 2U);
+  CHECK(t.first_ == &t.indexed_[1U]);
+}
+
+}  // namespace dedup_test
+
+using namespace dedup_test;
+
+TEST_CASE("dedup offset") {
+  using data = offset_containers;
+  constexpr auto const MODE = cista::mode::WITH_VERSION;
+  constexpr auto const DEDUP = MODE | cista::mode::DEDUP;
+
+  auto t = make_timetable<data>();
+  auto const buf = cista::serialize<MODE>(t);
+  auto const dedup_buf = cista::serialize<DEDUP>(t);
+
+  // 10 names + 3 tag vectors + (at most) one byte vector instead of 1000 each.
+  CHECK(dedup_buf.size() + 1000U * (32U + 16U) < buf.size());
+  CHECK(cista::serialized_total_size<DEDUP>(t) == dedup_buf.size());
+  CHECK(cista::serialize_parallel<DEDUP>(t, 2U) == dedup_buf);
+
+  auto const d = cista::deserialize<timetable<data>, DEDUP>(dedup_buf);
+  check_timetable(*d);
+  CHECK(d->stops_[0U].name_.data() == d->stops_[10U].name_.data());
+  CHECK(d->stops_[0U].tags_.data() == d->stops_[3U].tags_.data());
+  CHECK(d->stops_[0U].tags_.data() != d->stops_[1U].tags_.data());
+
+  auto copy = dedup_buf;
+  check_timetable(
+      *cista::deserialize<timetable<data>, DEDUP | cista::mode::DEEP_CHECK>(
+          copy));
+}
+
+TEST_CASE("dedup raw") {
+  using data = raw_containers;
+  constexpr auto const DEDUP = cista::mode::DEDUP;
+
+  auto t = make_timetable<data>();
+  auto buf = cista::serialize<DEDUP>(t);
+  CHECK(buf.size() < cista::serialize(t).size());
+
+  auto const d = cista::deserialize<timetable<data>, DEDUP>(buf);
+  check_timetable(*d);
+  CHECK(d->stops_[0U].name_.data() == d->stops_[10U].name_.data());
+}
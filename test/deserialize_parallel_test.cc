@@ -0,0 +1,223 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace deserialize_parallel_test {
+
+struct offset_data {
+  template <typename T>
+  using vector = cista::offset::vector<T>;
+  template <typename T>
+  using indexed_vector = cista::offset::indexed_vector<T>;
+  template <typename T>
+  using ptr = cista::offset::ptr<T>;
+  using string = cista::offset::string;
+};
+
+struct raw_data {
+  template <typename T>
+  using vector = cista::raw::vector<T>;
+  template <typename T>
+  using indexed_vector = cista::raw::indexed_vector<T>;
+  template <typename T>
+  using ptr = cista::raw::ptr<T>;
+  using string = cista::raw::string;
+};
+
+template <typename Data>
+struct node {
+  std::uint32_t id_;
+  typename Data::template vector<typename Data::template ptr<node>> edges_;
+  typename Data::string name_;
+  typename Data::template indexed_vector<std::uint64_t> values_;
+  typename Data::template ptr<std::uint64_t> best_value_;
+};
+
+template <typename Data>
+struct graph {
+  typename Data::template vector<typename Data::template ptr<node<Data>>>
+      roots_;
+  typename Data::template indexed_vector<node<Data>> nodes_;
+};
+
+template <typename Data>
+graph<Data> make_graph(std::uint32_t const n) {
+  auto g = graph<Data>{};
+  g.nodes_.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    auto& x = g.nodes_[i];
+    x.id_ = i;
+    x.edges_.push_back(&g.nodes_[(i * 7U) % n]);
+    x.name_ = "node " + std::to_string(i) + " with a long enough name";
+    x.values_.resize(i % 8U);
+    for (auto j = 0U; j != x.values_.size(); ++j) {
+      x.values_[j] = i * j;
+    }
+    if (i % 10U == 0U) {
+      g.roots_.push_back(&x);
+    }
+  }
+  for (auto i = 0U; i != n; ++i) {
+    auto& target = g.nodes_[(i * 13U) % n];
+    g.nodes_[i].best_value_ =
+        target.values_.empty() ? nullptr : &target.values_.back();
+  }
+  return g;
+}
+
+template <typename Data>
+void check_graph(graph<Data> const& g, std::uint32_t const n) {
+  REQUIRE(g.nodes_.size() == n);
+  CHECK(g.roots_.size() == (n + 9U) / 10U);
+  for (auto i = 0U; i != n; ++i) {
+    auto const& x = g.nodes_[i];
+    CHECK(x.id_ == i);
+    CHECK(x.edges_[0]->id_ == (i * 7U) % n);
+    CHECK(x.name_ == "node " + std::to_string(i) + " with a long enough name");
+    CHECK(x.values_.size() == i % 8U);
+    auto const& target = g.nodes_[(i * 13U) % n];
+    CHECK(x.best_value_ ==
+          (target.values_.empty() ? nullptr : &target.values_.back()));
+  }
+}
+
+}  // namespace deserialize_parallel_test
+
+using namespace deserialize_parallel_test;
+
+TEST_CASE("deserialize parallel offset") {
+  using data = offset_data;
+  constexpr auto const n = 5'000U;
+  constexpr auto const MODE = cista::mode::DEEP_CHECK;
+
+  auto g = make_graph<data>(n);
+  auto const buf = cista::serialize<MODE>(g);
+  for (auto const n_threads : {1U, 2U, 3U, 8U}) {
+    auto copy = buf;
+    check_graph(*cista::deserialize_parallel<graph<data>, MODE>(copy, n_threads),
+                n);
+    CHECK(copy == buf);
+  }
+
+  auto const& const_buf = buf;
+  check_graph(*cista::deserialize_parallel<graph<data>, MODE>(const_buf, 4U),
+              n);
+}
+
+TEST_CASE("deserialize parallel raw") {
+  using data = raw_data;
+  constexpr auto const n = 5'000U;
+  constexpr auto const MODE =
+      cista::mode::SERIALIZE_BIG_ENDIAN | cista::mode::DEEP_CHECK;
+
+  auto g = make_graph<data>(n);
+  auto const buf = cista::serialize<MODE>(g);
+  for (auto const n_threads : {1U, 2U, 3U, 8U}) {
+    auto copy = buf;
+    check_graph(*cista::deserialize_parallel<graph<data>, MODE>(copy, n_threads),
+                n);
+  }
+}
+
+TEST_CASE("deserialize parallel reports the first error") {
+  using data = offset_data;
+  constexpr auto const n = 5'000U;
+
+  auto g = make_graph<data>(n);
+  auto const buf = cista::serialize(g);
+
+  // Offsets are not touched by offset deserialization: find the positions of
+  // the best_value_ pointers in a deserialized copy.
+  auto copy = buf;
+  auto const d = cista::deserialize<graph<data>>(copy);
+  auto const pos = [&](std::uint32_t const i) {
+    return static_cast<std::size_t>(
+        reinterpret_cast<std::uint8_t const*>(&d->nodes_[i].best_value_) -
+        copy.data());
+  };
+  auto const corrupt = [&](cista::byte_buf& b, std::uint32_t const i,
+                           cista::offset_t const offset) {
+    std::memcpy(&b[pos(i)], &offset, sizeof(offset));
+  };
+
+  auto corrupted = buf;
+  corrupt(corrupted, 4'900U, std::numeric_limits<cista::offset_t>::max() / 2);
+  corrupt(corrupted, 1'000U, 1);
+  corrupt(corrupted, 3'000U, -static_cast<cista::offset_t>(pos(3'000U)) - 8);
+
+  auto const error = [&](unsigned const n_threads) {
+    auto x = corrupted;
+    try {
+      cista::deserialize_parallel<graph<data>>(x, n_threads);
+    } catch (std::exception const& e) {
+      return std::string{e.what()};
+    }
+    return std::string{};
+  };
+
+  REQUIRE(error(1U) == "ptr alignment");
+  for (auto const n_threads : {2U, 3U, 8U}) {
+    for (auto run = 0U; run != 10U; ++run) {
+      CHECK(error(n_threads) == "ptr alignment");
+    }
+  }
+}
+
+TEST_CASE("deserialize parallel overlapping vectors") {
+  struct two_vectors {
+    cista::raw::vector<std::uint64_t> a_, b_;
+  };
+  constexpr auto const MODE = cista::mode::SERIALIZE_BIG_ENDIAN;
+  constexpr auto const n = 100'000U;
+
+  auto x = two_vectors{};
+  for (auto i = 0U; i != n; ++i) {
+    x.a_.push_back(i);
+    x.b_.push_back(i);
+  }
+  auto buf = cista::serialize<MODE>(x);
+
+  // Let b_ point to the data of a_ (offsets are relative to the pointer):
+  // both are converted in place, overlapping tasks must not run concurrently.
+  auto const b_pos = static_cast<cista::offset_t>(
+      reinterpret_cast<std::uint8_t const*>(&x.b_) -
+      reinterpret_cast<std::uint8_t const*>(&x));
+  auto a_offset = cista::offset_t{};
+  std::memcpy(&a_offset, &buf[0], sizeof(a_offset));
+  auto const b_offset = cista::convert_endian<MODE>(
+      cista::convert_endian<MODE>(a_offset) - b_pos);
+  std::memcpy(&buf[static_cast<std::size_t>(b_pos)], &b_offset,
+              sizeof(b_offset));
+
+  auto sequential = buf;
+  auto const expected =
+      cista::deserialize_parallel<two_vectors, MODE>(sequential, 1U);
+  REQUIRE(expected->a_.data() == expected->b_.data());
+  for (auto const n_threads : {2U, 4U, 8U}) {
+    for (auto run = 0U; run != 5U; ++run) {
+      auto copy = buf;
+      auto const d =
+          cista::deserialize_parallel<two_vectors, MODE>(copy, n_threads);
+      CHECK(d->a_.data() == d->b_.data());
+      CHECK(d->a_ == expected->a_);
+    }
+  }
+}
+
+TEST_CASE("deserialize parallel task ranges") {
+  auto data = std::array<std::uint64_t, 16U>{};
+  auto const task = [&](std::size_t const i, std::size_t const n) {
+    return cista::deserialize_task{nullptr, &data[i], n,
+                                   n * sizeof(std::uint64_t)};
+  };
+  CHECK(cista::tasks_disjoint({}));
+  CHECK(cista::tasks_disjoint({task(8U, 8U), task(0U, 8U)}));
+  CHECK(cista::tasks_disjoint({task(4U, 4U), task(0U, 4U), task(8U, 8U)}));
+  CHECK_FALSE(cista::tasks_disjoint({task(8U, 8U), task(0U, 9U)}));
+  CHECK_FALSE(cista::tasks_disjoint({task(0U, 16U), task(4U, 1U)}));
+  CHECK_FALSE(cista::tasks_disjoint({task(2U, 2U), task(2U, 2U)}));
+}
@@ -0,0 +1,116 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/endian_view.h"
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+
+namespace endian_view_test {
+
+struct node {
+  std::uint32_t id_;
+  double weight_;
+  data::string name_;
+  data::vector<std::uint64_t> values_;
+  data::ptr<node> next_;
+};
+
+struct graph {
+  data::indexed_vector<node> nodes_;
+  data::array<std::int16_t, 3U> coords_;
+  data::unique_ptr<node> root_;
+  data::u16string label_;
+  data::string short_name_;
+};
+
+inline graph make_graph() {
+  auto g = graph{};
+  g.nodes_.resize(3U);
+  for (auto i = 0U; i != g.nodes_.size(); ++i) {
+    auto& n = g.nodes_[i];
+    n.id_ = 0x01020300U + i;
+    n.weight_ = 0.5 * i;
+    n.name_ = "node " + std::to_string(i) + " with a name longer than SSO";
+    n.values_ = {i, i * 0x0102030405060708ULL};
+  }
+  g.nodes_[0U].next_ = &g.nodes_[2U];
+  g.coords_ = {-1, 2, -300};
+  g.root_ = data::make_unique<node>();
+  g.root_->id_ = 77U;
+  g.label_ = u"a label too long for the short string buffer";
+  g.short_name_ = "short";
+  return g;
+}
+
+template <cista::mode Mode, typename Container>
+void check_view(Container const& buf) {
+  auto const g = cista::view<graph, Mode>(buf);
+
+  auto const nodes = g.get(&graph::nodes_);
+  REQUIRE(nodes.size() == 3U);
+  for (auto i = 0U; i != nodes.size(); ++i) {
+    auto const n = nodes[i];
+    CHECK(n.get(&node::id_) == 0x01020300U + i);
+    CHECK(n.get(&node::weight_).get() == 0.5 * i);
+    CHECK(n.get(&node::name_).view() ==
+          "node " + std::to_string(i) + " with a name longer than SSO");
+    auto const values = n.template get<3U>();
+    REQUIRE(values.size() == 2U);
+    CHECK(values[1U] == i * 0x0102030405060708ULL);
+  }
+
+  auto const next = nodes[0U].get(&node::next_);
+  REQUIRE(next);
+  CHECK((*next).get(&node::id_) == 0x01020302U);
+  CHECK(!nodes[1U].get(&node::next_));
+
+  auto sum = std::uint64_t{0U};
+  for (auto const n : nodes) {
+    for (auto const v : n.get(&node::values_)) {
+      sum += v;
+    }
+  }
+  CHECK(sum == 3U + 3U * 0x0102030405060708ULL);
+
+  auto const coords = g.get(&graph::coords_);
+  CHECK(coords[0U] == -1);
+  CHECK(coords[2U] == -300);
+  CHECK_THROWS(coords.at(3U));
+
+  CHECK((*g.get(&graph::root_)).get(&node::id_) == 77U);
+  CHECK(g.get(&graph::label_).str() ==
+        u"a label too long for the short string buffer");
+  CHECK(g.get(&graph::label_)[2U] == u'l');
+  CHECK(g.get(&graph::short_name_).view() == "short");
+}
+
+}  // namespace endian_view_test
+
+using namespace endian_view_test;
+
+TEST_CASE("endian view") {
+  constexpr auto const BE =
+      cista::mode::SERIALIZE_BIG_ENDIAN | cista::mode::WITH_VERSION;
+  constexpr auto const LE = cista::mode::WITH_VERSION;
+
+  auto g = make_graph();
+  auto const be_buf = cista::serialize<BE>(g);
+  auto const le_buf = cista::serialize<LE>(g);
+
+  check_view<BE>(be_buf);
+  check_view<LE>(le_buf);
+
+  CHECK_THROWS(cista::view<graph, LE>(be_buf.data(), be_buf.data() + 8U));
+
+  // Read-only mapping: nothing is written.
+  {
+    auto f = cista::file{"endian_view.bin", "w+"};
+    cista::serialize<BE>(f, g);
+  }
+  auto const m = cista::mmap{"endian_view.bin", cista::mmap::protection::READ};
+  check_view<BE>(m);
+}
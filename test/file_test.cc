@@ -1,12 +1,23 @@
+#include <array>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <random>
+#include <string_view>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "doctest.h"
 
 #ifdef SINGLE_HEADER
 #include "cista.h"
 #else
+#include "cista/load.h"
 #include "cista/reflection/for_each_field.h"
+#include "cista/serialization.h"
 #include "cista/targets/file.h"
 #endif
 
@@ -50,3 +61,149 @@ TEST_CASE("file") {
   f.read(reinterpret_cast<char*>(&number), sizeof(number));
   CHECK(number == 77);
 }
+
+TEST_CASE("file write combining") {
+  // Random appends and patches (overlapping, behind and inside the write
+  // buffer) give the same contents as the same writes to memory.
+  auto rng = std::mt19937{7U};
+  auto expected = std::vector<std::uint8_t>{};
+  {
+    file f{"test_wc.bin", "w+"};
+    for (auto i = 0U; i != 4000U; ++i) {
+      if (expected.empty() || rng() % 4U == 0U) {
+        auto const size = rng() % 2U == 0U ? rng() % 64U : rng() % 100000U;
+        auto const alignment = std::size_t{1U} << (rng() % 4U);
+        auto data = std::vector<std::uint8_t>(size);
+        for (auto& b : data) {
+          b = static_cast<std::uint8_t>(rng());
+        }
+        auto const pos = static_cast<std::size_t>(
+            f.write(data.data(), data.size(), alignment));
+        CHECK(pos % alignment == 0U);
+        expected.resize(pos + size);
+        std::copy(begin(data), end(data), begin(expected) + pos);
+      } else if (expected.size() >= 32U) {
+        auto const pos = rng() % (expected.size() - 31U);
+        if (rng() % 8U == 0U) {
+          auto val = std::array<std::uint8_t, 32U>{};
+          val.fill(static_cast<std::uint8_t>(rng()));
+          f.write(pos, val);
+          std::memcpy(&expected[pos], &val, sizeof(val));
+        } else {
+          auto const val = std::uint64_t{rng()} << 32U | rng();
+          f.write(pos, val);
+          std::memcpy(&expected[pos], &val, sizeof(val));
+        }
+      }
+    }
+    CHECK(f.size() == expected.size());
+    CHECK(f.checksum() ==
+          hash(std::string_view{reinterpret_cast<char const*>(expected.data()),
+                                expected.size()}));
+  }
+
+  auto const b = file{"test_wc.bin", "r"}.content();
+  REQUIRE(b.size() == expected.size());
+  CHECK(std::memcmp(b.data(), expected.data(), b.size()) == 0);
+}
+
+TEST_CASE("file serialize equals buf") {
+  namespace data = cista::offset;
+  struct entry {
+    std::uint32_t id_;
+    data::string name_;
+    data::vector<std::uint32_t> values_;
+  };
+  using entries_t = data::vector<entry>;
+
+  auto e = entries_t{};
+  for (auto i = 0U; i != 100000U; ++i) {
+    e.push_back(entry{i, "entry with a long name " + std::to_string(i),
+                      data::vector<std::uint32_t>{i, i + 1U}});
+  }
+
+  constexpr auto const MODE = mode::WITH_VERSION | mode::WITH_INTEGRITY;
+  auto const buf = serialize<MODE>(e);
+  {
+    file f{"test_serialize.bin", "w+"};
+    serialize<MODE>(f, e);
+    CHECK(f.size() == buf.size());
+  }
+  auto b = file{"test_serialize.bin", "r"}.content();
+  REQUIRE(b.size() == buf.size());
+  CHECK(std::memcmp(b.data(), buf.data(), buf.size()) == 0);
+  CHECK(deserialize<entries_t, MODE>(b)->at(99999U).values_[1U] == 100000U);
+
+  // Write-only handle: patches are written without reading the file.
+  auto const plain = serialize(e);
+  {
+    file f{"test_serialize.bin", "w"};
+    serialize(f, e);
+  }
+  b = file{"test_serialize.bin", "r"}.content();
+  REQUIRE(b.size() == plain.size());
+  CHECK(std::memcmp(b.data(), plain.data(), plain.size()) == 0);
+}
+
+TEST_CASE("file parallel load") {
+  auto rng = std::mt19937{3U};
+  for (auto const size : {0U, 1U, 4095U, 4096U, 1000000U, 3U * 1024U * 1024U}) {
+    auto data = std::vector<std::uint8_t>(size);
+    for (auto& b : data) {
+      b = static_cast<std::uint8_t>(rng());
+    }
+    {
+      auto f = file{"test_load.bin", "w+"};
+      f.write(data.data(), data.size(), 0U);
+    }
+
+    auto opt = load_options{};
+    opt.chunk_size_ = 64U * 1024U;
+    opt.n_threads_ = 4U;
+    for (auto const huge_pages : {false, true}) {
+      for (auto const direct : {false, true}) {
+        opt.huge_pages_ = huge_pages;
+        opt.direct_ = direct;
+        auto const b = load_file("test_load.bin", opt);
+        REQUIRE(b.size() == size);
+        CHECK((size == 0U ||
+               std::memcmp(b.data(), data.data(), data.size()) == 0));
+      }
+    }
+  }
+  CHECK_THROWS(load_file("does_not_exist.bin"));
+  std::remove("test_load.bin");
+}
+
+#ifndef _WIN32
+TEST_CASE("file flush error on close") {
+  // Replaces the file descriptor with a read-only one: flushing the write
+  // combiner fails.
+  auto const break_fd = [](file const& f) {
+    auto const read_only = ::open("/dev/null", O_RDONLY);
+    REQUIRE(read_only != -1);
+    REQUIRE(::dup2(read_only, f.fd()) == f.fd());
+    ::close(read_only);
+  };
+  auto const value = std::uint64_t{77U};
+
+  auto const write_and_close = [&]() {
+    auto f = file{"test_close.bin", "w+"};
+    f.write(&value, sizeof(value), 0U);
+    break_fd(f);
+  };
+  CHECK_THROWS_AS(write_and_close(), std::runtime_error);
+
+  // Not thrown while the stack is unwound.
+  try {
+    auto g = file{"test_close.bin", "w+"};
+    g.write(&value, sizeof(value), 0U);
+    break_fd(g);
+    throw std::logic_error{"unwinding"};
+  } catch (std::logic_error const& e) {
+    CHECK(std::string_view{e.what()} == "unwinding");
+  }
+
+  std::remove("test_close.bin");
+}
+#endif
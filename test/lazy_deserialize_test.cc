@@ -0,0 +1,143 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/lazy.h"
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+
+namespace lazy_deserialize_test {
+
+struct node {
+  std::uint32_t id_;
+  data::string name_;
+  data::vector<std::uint64_t> values_;
+  data::ptr<node> next_;
+};
+
+struct graph {
+  data::indexed_vector<node> nodes_;
+  data::array<std::int16_t, 3U> coords_;
+  data::unique_ptr<node> root_;
+  data::vector<data::vector<std::uint32_t>> nested_;
+};
+
+inline graph make_graph() {
+  auto g = graph{};
+  g.nodes_.resize(3U);
+  for (auto i = 0U; i != g.nodes_.size(); ++i) {
+    auto& n = g.nodes_[i];
+    n.id_ = i;
+    n.name_ = "node " + std::to_string(i) + " with a name longer than SSO";
+    n.values_ = {i, i * 10U};
+  }
+  g.nodes_[0U].next_ = &g.nodes_[2U];
+  g.coords_ = {-1, 2, -300};
+  g.root_ = data::make_unique<node>();
+  g.root_->id_ = 77U;
+  g.nested_.resize(2U);
+  g.nested_[1U] = {1U, 2U, 3U};
+  return g;
+}
+
+}  // namespace lazy_deserialize_test
+
+using namespace lazy_deserialize_test;
+
+TEST_CASE("lazy deserialize") {
+  constexpr auto const MODE = cista::mode::WITH_VERSION;
+
+  auto g = make_graph();
+  auto const buf = cista::serialize<MODE>(g);
+
+  auto const img = cista::lazy_deserialize<graph, MODE>(buf);
+  auto const root = img.root();
+
+  auto const nodes = root.get(&graph::nodes_);
+  REQUIRE(nodes.size() == 3U);
+  for (auto i = 0U; i != nodes.size(); ++i) {
+    auto const n = nodes[i];
+    CHECK(n.get(&node::id_) == i);
+    CHECK(n.get(&node::name_).view() ==
+          "node " + std::to_string(i) + " with a name longer than SSO");
+    auto const values = n.template get<2U>();
+    REQUIRE(values.size() == 2U);
+    CHECK(values[1U] == i * 10U);
+  }
+  CHECK_THROWS(nodes[3U]);
+
+  auto const next = nodes[0U].get(&node::next_);
+  REQUIRE(next);
+  CHECK((*next).get(&node::id_) == 2U);
+  CHECK(!nodes[1U].get(&node::next_));
+
+  auto sum = std::uint64_t{0U};
+  for (auto const n : nodes) {
+    for (auto const v : n.get(&node::values_)) {
+      sum += v;
+    }
+  }
+  CHECK(sum == 33U);
+
+  CHECK(root.get(&graph::coords_)[2U] == -300);
+  CHECK((*root.get(&graph::root_)).get(&node::id_) == 77U);
+  CHECK(root.get(&graph::nested_)[1U][2U] == 3U);
+  CHECK(root.get(&graph::nested_).deep()[1U].size() == 3U);
+}
+
+TEST_CASE("lazy deserialize corrupted subtree") {
+  constexpr auto const MODE = cista::mode::WITH_VERSION;
+
+  auto g = make_graph();
+  auto buf = cista::serialize<MODE>(g);
+
+  // Corrupt the size of the values of the last node.
+  {
+    auto copy = buf;
+    auto const d = cista::deserialize<graph, MODE>(copy);
+    auto const offset = reinterpret_cast<std::uint8_t const*>(
+                            &d->nodes_[2U].values_.used_size_) -
+                        copy.data();
+    auto const huge = std::uint32_t{0x10000000U};
+    std::memcpy(&buf[static_cast<std::size_t>(offset)], &huge, sizeof(huge));
+  }
+
+  auto copy = buf;
+  CHECK_THROWS(cista::deserialize<graph, MODE>(copy));
+
+  // Opening and reading the intact parts works.
+  auto const img = cista::lazy_deserialize<graph, MODE>(buf);
+  auto const nodes = (*img).get(&graph::nodes_);
+  CHECK(nodes[0U].get(&node::id_) == 0U);
+  CHECK(nodes[1U].get(&node::values_)[1U] == 10U);
+
+  // Reaching the corrupted node (directly or via a pointer) fails, every
+  // time.
+  CHECK_THROWS(nodes[2U]);
+  CHECK_THROWS(nodes[2U]);
+  CHECK_THROWS(*nodes[0U].get(&node::next_));
+  CHECK_THROWS(img.root().deep());
+}
+
+TEST_CASE("lazy visited bits are allocated on first touch") {
+  constexpr auto const n_slots = std::size_t{1U} << 30U;
+  auto bits = cista::lazy_visited_bits{n_slots};
+  auto const n_allocated = [&]() {
+    auto n = 0U;
+    for (auto i = std::size_t{0U}; i != bits.n_pages_; ++i) {
+      n += bits.pages_[i].load() != nullptr ? 1U : 0U;
+    }
+    return n;
+  };
+  CHECK(n_allocated() == 0U);
+
+  bits.word(n_slots - 1U) |= 1U;
+  bits.word(0U) |= 2U;
+  bits.word(63U) |= 4U;
+  CHECK(n_allocated() == 2U);
+  CHECK(bits.word(n_slots - 1U) == 1U);
+  CHECK(bits.word(1U) == 6U);
+}
@@ -0,0 +1,351 @@
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/io.h"
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+
+namespace mmap_paging_test {
+
+struct db {
+  data::vector<std::uint64_t> ids_;
+  data::vector<data::string> names_;
+};
+
+}  // namespace mmap_paging_test
+
+using namespace mmap_paging_test;
+
+TEST_CASE("mmap paging options") {
+  constexpr auto const n = 100000U;
+  auto const path = "mmap_paging_test.bin";
+  {
+    auto d = db{};
+    for (auto i = 0U; i != n; ++i) {
+      d.ids_.push_back(i);
+      d.names_.emplace_back("name " + std::to_string(i));
+    }
+    cista::write(path, d);
+  }
+
+  auto opt = cista::mmap_options{};
+  opt.advice_ = cista::advice::RANDOM;
+  opt.populate_ = true;
+  opt.prefault_threads_ = 2U;
+  {
+    auto const d = cista::read_mmap<db>(path, opt);
+    CHECK(d->ids_.at(n - 1U) == n - 1U);
+    CHECK(d->names_.at(123U) == "name 123");
+
+    // Sub-ranges: only one vector's data.
+    auto const ids_size = d->ids_.size() * sizeof(std::uint64_t);
+    CHECK(cista::prefault(d->ids_, 3U) >= ids_size / cista::page_size());
+    CHECK(cista::prefault(d->ids_, 3U) <= ids_size / cista::page_size() + 1U);
+    cista::advise(d->ids_, cista::advice::WILLNEED);
+    cista::advise(d->ids_.data() + 1U, 10U, cista::advice::SEQUENTIAL);
+    cista::lock_pages(d->ids_.data(), 100U);
+    cista::unlock_pages(d->ids_.data(), 100U);
+    CHECK(cista::prefault(d->ids_.data(), 0U) == 0U);
+  }
+
+  {
+    auto const m = cista::mmap{path, cista::mmap::protection::READ};
+    auto const n_pages =
+        (m.size() + cista::page_size() - 1U) / cista::page_size();
+    CHECK(m.prefault() == n_pages);
+    CHECK(m.prefault(m.size() - 1U) == 1U);
+    m.advise(0U, m.size(), cista::advice::SEQUENTIAL);
+    m.lock(1U, 4096U);
+    m.unlock(1U, 4096U);
+    CHECK_THROWS(m.advise(m.size(), 1U, cista::advice::RANDOM));
+    CHECK_THROWS(m.lock(1U, m.size()));
+  }
+
+  // Small file: locking counts against RLIMIT_MEMLOCK.
+  {
+    auto d = db{};
+    d.ids_ = {1U, 2U, 3U};
+    cista::write(path, d);
+  }
+  opt.lock_ = true;
+  opt.prefault_threads_ = 0U;
+  CHECK(cista::read_mmap<db>(path, opt)->ids_[2U] == 3U);
+
+  std::remove(path);
+}
+
+TEST_CASE("advise dontneed keeps neighbouring pages") {
+  auto const page = cista::page_size();
+  auto m = cista::mmap{nullptr, cista::mmap::protection::ANONYMOUS};
+  m.resize(4U * page);
+  std::memset(m.data(), 0xAB, m.size());
+
+  // Less than a whole page: nothing is dropped.
+  m.advise(page + 1U, page - 2U, cista::advice::DONTNEED);
+  // Covers page 1 completely, pages 0 and 2 partially.
+  m.advise(page - 100U, page + 200U, cista::advice::DONTNEED);
+
+  auto kept = true;
+  for (auto i = 0U; i != page; ++i) {
+    kept = kept && m[i] == 0xABU && m[2U * page + i] == 0xABU &&
+           m[3U * page + i] == 0xABU;
+  }
+  CHECK(kept);
+#if defined(__linux__)
+  CHECK(m[page] == 0U);  // Private anonymous pages read back as zeros.
+  CHECK(m[2U * page - 1U] == 0U);
+#endif
+}
+
+TEST_CASE("mmap anonymous huge pages") {
+  auto opt = cista::mmap_options{};
+  opt.huge_pages_ = cista::huge_pages::EXPLICIT;
+  auto m = cista::mmap{nullptr, cista::mmap::protection::ANONYMOUS, opt};
+  CHECK(m.size() == 0U);
+
+  m.resize(3U * 1024U * 1024U);
+  for (auto i = 0U; i != m.size(); ++i) {
+    m[i] = static_cast<std::uint8_t>(i);
+  }
+  m.resize(20U * 1024U * 1024U);
+  auto equal = true;
+  for (auto i = 0U; i != 3U * 1024U * 1024U; ++i) {
+    equal = equal && m[i] == static_cast<std::uint8_t>(i);
+  }
+  CHECK(equal);
+
+  // Serialize into huge page backed memory.
+  auto d = db{};
+  d.ids_ = {4U, 5U, 6U};
+  auto b = cista::buf<cista::mmap>{
+      cista::mmap{nullptr, cista::mmap::protection::ANONYMOUS, opt}};
+  cista::serialize(b, d);
+  CHECK(cista::deserialize<db>(b)->ids_[2U] == 6U);
+}
+
+TEST_CASE("huge page allocations") {
+  auto const threshold = cista::huge_page_threshold();
+  cista::huge_page_threshold() = cista::HUGE_PAGE_SIZE;
+
+  auto v = data::vector<std::uint64_t>{};
+  v.resize(1024U * 1024U);
+  v.back() = 7U;
+  auto m = data::hash_map<std::uint64_t, std::uint64_t>{};
+  for (auto i = 0U; i != 200000U; ++i) {
+    m[i] = i;
+  }
+
+#if defined(__linux__)
+  CHECK(reinterpret_cast<std::uintptr_t>(v.data()) % cista::HUGE_PAGE_SIZE ==
+        0U);
+  CHECK(reinterpret_cast<std::uintptr_t>(m.entries_.get()) %
+            cista::HUGE_PAGE_SIZE ==
+        0U);
+#endif
+  CHECK(v.back() == 7U);
+  CHECK(m.at(199999U) == 199999U);
+
+  cista::huge_page_threshold() = threshold;
+}
+
+TEST_CASE("mmap growth policy") {
+  using cista::growth_policy;
+  CHECK(growth_policy::power_of_two().grow(0U, 1000U) == 1024U);
+  CHECK(growth_policy::fixed_chunk(1000U).grow(0U, 1001U) == 2000U);
+  CHECK(growth_policy::geometric(1.5).grow(1000U, 1001U) == 1500U);
+  CHECK(growth_policy::geometric(1.5).grow(1000U, 2000U) == 2000U);
+  CHECK(growth_policy::exact().grow(1000U, 1001U) == 1001U);
+  CHECK_THROWS(growth_policy::geometric(1.0));
+
+  auto const path = "mmap_growth_test.bin";
+  auto opt = cista::mmap_options{};
+  opt.growth_ = growth_policy::fixed_chunk(1024U * 1024U);
+  {
+    auto m = cista::mmap{path, cista::mmap::protection::WRITE, opt};
+    for (auto i = 0U; i != 5U * 256U + 1U; ++i) {
+      m.resize((i + 1U) * 4096U);
+      std::memset(m.data() + i * 4096U, static_cast<int>(i % 256U), 4096U);
+    }
+    CHECK(m.capacity() == 6U * 1024U * 1024U);
+    CHECK(m[5U * 1024U * 1024U] == 0U);
+    CHECK(m[4096U] == 1U);
+  }
+  {
+    auto const m = cista::mmap{path, cista::mmap::protection::READ};
+    CHECK(m.size() == (5U * 256U + 1U) * 4096U);
+    CHECK(m[5U * 1024U * 1024U + 4095U] == 0U);
+    CHECK(m[3U * 4096U] == 3U);
+  }
+
+  // serialize() reserves the total size: one exact mapping.
+  auto d = db{};
+  for (auto i = 0U; i != 10000U; ++i) {
+    d.ids_.push_back(i);
+    d.names_.emplace_back("a name longer than the short string buffer");
+  }
+  opt.growth_ = growth_policy::exact();
+  {
+    auto b = cista::buf<cista::mmap>{
+        cista::mmap{path, cista::mmap::protection::WRITE, opt}};
+    cista::serialize(b, d);
+    CHECK(b.buf_.capacity() == b.size());
+  }
+  auto const expected = cista::serialize(d);
+  auto const written = cista::file{path, "r"}.content();
+  REQUIRE(written.size() == expected.size());
+  CHECK(std::memcmp(written.data(), expected.data(), expected.size()) == 0);
+
+  std::remove(path);
+}
+
+TEST_CASE("mmap dirty ranges") {
+  auto const path = "mmap_dirty_test.bin";
+  {
+    auto m = cista::mmap{path, cista::mmap::protection::WRITE};
+    m.resize(100000U);
+    CHECK(m.sync_dirty() == 100000U);
+    CHECK(m.dirty_ranges().empty());
+
+    m.mark_dirty(10U, 10U);
+    m.mark_dirty(5000U, 10U);
+    m.mark_dirty(15U, 20U);
+    m.resize(200000U);
+    using ranges_t = std::vector<std::pair<std::size_t, std::size_t>>;
+    CHECK(m.dirty_ranges() ==
+          ranges_t{{10U, 35U}, {5000U, 5010U}, {100000U, 200000U}});
+
+    // Many scattered ranges are coarsened.
+    for (auto i = 0U; i != 5000U; ++i) {
+      m.mark_dirty((i * 7919U) % 199990U, 4U);
+    }
+    CHECK(m.dirty_ranges().size() <= 512U);
+    CHECK(m.dirty_ranges().front().first <= 10U);
+    CHECK(m.dirty_ranges().back().second == 200000U);
+    m.sync(0U, 10U, true);
+    CHECK_THROWS(m.sync(0U, m.capacity() + 1U));
+    m.sync(true);
+    CHECK(m.dirty_ranges().empty());
+  }
+
+  auto opt = cista::mmap_options{};
+  opt.close_sync_ = cista::close_sync::DIRTY;
+  opt.async_ = true;
+  {
+    auto v = cista::mmap_vec<std::uint32_t>{
+        cista::mmap{path, cista::mmap::protection::WRITE, opt}};
+    for (auto i = 0U; i != 1000U; ++i) {
+      v.push_back(i);
+    }
+    CHECK(v.sync_dirty() == 4000U);
+    v[7U] = 77U;
+    v.mark_dirty(7U);
+    v.push_back(1000U);
+    CHECK(v.mmap_.dirty_ranges() ==
+          std::vector<std::pair<std::size_t, std::size_t>>{{28U, 32U},
+                                                          {4000U, 4004U}});
+    v.sync(0U, 10U);
+
+    // Appends into reserved space.
+    v.reserve(v.size() + 100U);
+    v.sync_dirty();
+    v.emplace_back(42U);
+    v.emplace_back(43U);
+    v.resize(v.size() + 2U);
+    CHECK(v.mmap_.dirty_ranges() ==
+          std::vector<std::pair<std::size_t, std::size_t>>{{4004U, 4020U}});
+    v.resize(1001U);
+  }
+
+  // Sync and unmap in the background.
+  auto f = cista::flusher{};
+  opt.flusher_ = &f;
+  {
+    auto v = cista::mmap_vec<std::uint32_t>{
+        cista::mmap{path, cista::mmap::protection::MODIFY, opt}};
+    CHECK(v.size() == 1001U);
+    CHECK(v[7U] == 77U);
+    v.push_back(1001U);
+  }
+  f.wait();
+  {
+    auto const m = cista::mmap{path, cista::mmap::protection::READ};
+    REQUIRE(m.size() == 1002U * sizeof(std::uint32_t));
+    auto x = std::uint32_t{};
+    std::memcpy(&x, m.data() + 1001U * sizeof(std::uint32_t), sizeof(x));
+    CHECK(x == 1001U);
+  }
+
+  std::remove(path);
+}
+
+TEST_CASE("flusher errors") {
+  auto n_done = 0U;
+  {
+    auto f = cista::flusher{};
+    f.defer([]() { throw std::runtime_error{"first"}; });
+    f.defer([]() { throw std::runtime_error{"second"}; });
+    f.defer([&]() { ++n_done; });
+    try {
+      f.wait();
+      CHECK(false);
+    } catch (std::runtime_error const& e) {
+      CHECK(std::string_view{e.what()} == "first");
+    }
+    CHECK(n_done == 1U);
+    f.wait();  // Reported once.
+  }
+
+  auto const run = [&]() {
+    auto f = cista::flusher{};
+    f.defer([]() { throw std::runtime_error{"not waited for"}; });
+  };
+  CHECK_THROWS_AS(run(), std::runtime_error);
+}
+
+#ifndef _WIN32
+TEST_CASE("flusher reports a failing deferred close") {
+  auto const path = "mmap_paging_test_close.bin";
+  auto f = cista::flusher{};
+  auto opt = cista::mmap_options{};
+  opt.flusher_ = &f;
+  {
+    auto m = cista::mmap{path, cista::mmap::protection::WRITE, opt};
+    m.resize(100U);
+
+    // Replace the file descriptor of the mapping with a read-only one:
+    // truncating the file to the used size fails.
+    struct stat s {};
+    REQUIRE(::stat(path, &s) == 0);
+    auto fd = -1;
+    for (auto i = 0; i != 1024 && fd == -1; ++i) {
+      struct stat x {};
+      if (::fstat(i, &x) == 0 && x.st_dev == s.st_dev &&
+          x.st_ino == s.st_ino) {
+        fd = i;
+      }
+    }
+    REQUIRE(fd != -1);
+    auto const read_only = ::open("/dev/null", O_RDONLY);
+    REQUIRE(read_only != -1);
+    REQUIRE(::dup2(read_only, fd) == fd);
+    ::close(read_only);
+  }
+  CHECK_THROWS_AS(f.wait(), std::runtime_error);
+  f.wait();  // Reported once.
+  std::remove(path);
+}
+#endif
@@ -227,4 +227,34 @@ TEST_CASE("graph offset indexed vec serialize endian test") {
   CHECK(*g->node_names_[0] == "NODE A");
   CHECK(*g->node_names_[1] == "NODE B");
   CHECK(*g->node_names_[2] == "NODE C");
-}
\ No newline at end of file
+}
+
+TEST_CASE("many indexed vectors forward and backward pointers") {
+  struct holder {
+    data::vector<data::ptr<unsigned>> forward_;
+    data::vector<data::indexed_vector<unsigned>> vecs_;
+    data::vector<data::ptr<unsigned>> backward_;
+  };
+
+  constexpr auto const n = 200U;
+
+  holder h;
+  h.vecs_.resize(n);
+  for (auto i = n; i != 0U; --i) {  // descending addresses (unsorted)
+    for (auto j = 0U; j != 3U; ++j) {
+      h.vecs_[i - 1U].push_back((i - 1U) * 10U + j);
+    }
+  }
+  for (auto i = 0U; i != n; ++i) {
+    h.forward_.push_back(&h.vecs_[(i * 7U) % n][i % 3U]);
+    h.backward_.push_back(&h.vecs_[(i * 13U) % n][(i + 1U) % 3U]);
+  }
+
+  auto b = cista::serialize(h);
+  auto const d = cista::deserialize<holder>(b);
+  for (auto i = 0U; i != n; ++i) {
+    CHECK(*d->forward_[i] == (i * 7U) % n * 10U + i % 3U);
+    CHECK(*d->backward_[i] == (i * 13U) % n * 10U + (i + 1U) % 3U);
+    CHECK(d->forward_[i].get() == &d->vecs_[(i * 7U) % n][i % 3U]);
+  }
+}
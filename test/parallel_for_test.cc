@@ -0,0 +1,50 @@
+#include <atomic>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/parallel_for.h"
+#endif
+
+TEST_CASE("parallel for") {
+  for (auto const n_threads : {0U, 1U, 3U, 8U}) {
+    for (auto const n : {0U, 1U, 2U, 1000U}) {
+      auto calls = std::vector<std::atomic_size_t>(n);
+      cista::parallel_for(n, n_threads,
+                          [&](std::size_t const i) { ++calls[i]; });
+      for (auto const& c : calls) {
+        CHECK(c.load() == 1U);
+      }
+    }
+  }
+}
+
+TEST_CASE("parallel for errors") {
+  try {
+    cista::parallel_for(1000U, 4U, [&](std::size_t const i) {
+      if (i == 10U) {
+        throw std::runtime_error{"item 10"};
+      }
+    });
+    CHECK(false);
+  } catch (std::runtime_error const& e) {
+    CHECK(std::string_view{e.what()} == "item 10");
+  }
+
+  // The calling thread fails: the other workers are joined before unwinding.
+  auto n_done = std::atomic_size_t{0U};
+  CHECK_THROWS_AS(cista::run_workers(4U,
+                                     [&](std::size_t const worker) {
+                                       if (worker == 0U) {
+                                         throw std::runtime_error{"worker 0"};
+                                       }
+                                       ++n_done;
+                                     }),
+                  std::runtime_error);
+  CHECK(n_done.load() == 3U);
+}
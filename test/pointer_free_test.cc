@@ -0,0 +1,110 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace pointer_free_test {
+
+struct pod {
+  std::uint32_t a_;
+  std::int16_t b_;
+  double c_;
+  cista::array<std::uint8_t, 3U> d_;
+};
+
+struct nested {
+  pod p_;
+  cista::pair<std::uint64_t, float> q_;
+  std::chrono::seconds r_;
+};
+
+struct with_ptr {
+  std::uint32_t a_;
+  cista::offset::ptr<pod> p_;
+};
+
+struct with_vec {
+  std::uint32_t a_;
+  cista::offset::vector<pod> v_;
+};
+
+struct custom {
+  std::uint32_t a_;
+};
+
+template <typename Ctx>
+void serialize(Ctx&, custom const*, cista::offset_t const) {}
+
+}  // namespace pointer_free_test
+
+using namespace pointer_free_test;
+
+TEST_CASE("is pointer free") {
+  static_assert(cista::is_pointer_free_v<int>);
+  static_assert(cista::is_pointer_free_v<pod>);
+  static_assert(cista::is_pointer_free_v<nested>);
+  static_assert(cista::is_pointer_free_v<cista::array<nested, 4U>>);
+  static_assert(
+      cista::is_pointer_free_v<cista::tuple<int, pod, cista::bitset<17U>>>);
+  static_assert(!cista::is_pointer_free_v<custom>);
+  static_assert(!cista::is_pointer_free_v<int*>);
+  static_assert(!cista::is_pointer_free_v<cista::offset::ptr<int>>);
+  static_assert(!cista::is_pointer_free_v<with_ptr>);
+  static_assert(!cista::is_pointer_free_v<with_vec>);
+  static_assert(!cista::is_pointer_free_v<cista::offset::string>);
+  static_assert(!cista::is_pointer_free_v<cista::optional<int>>);
+  static_assert(!cista::is_pointer_free_v<cista::indexed<pod>>);
+  static_assert(
+      !cista::is_pointer_free_v<cista::array<cista::raw::vector<int>, 2U>>);
+}
+
+TEST_CASE("pointer free vector serialization") {
+  namespace data = cista::offset;
+
+  auto v = data::vector<nested>{};
+  for (auto i = 0U; i != 1000U; ++i) {
+    v.push_back(nested{
+        pod{i, static_cast<std::int16_t>(-i), i / 2.0, {1U, 2U, 3U}},
+        {i * 3U, 1.5F},
+        std::chrono::seconds{i}});
+  }
+
+  auto check = [&](data::vector<nested> const& x) {
+    REQUIRE(x.size() == v.size());
+    for (auto i = 0U; i != x.size(); ++i) {
+      CHECK(x[i].p_.a_ == i);
+      CHECK(x[i].p_.b_ == static_cast<std::int16_t>(-i));
+      CHECK(x[i].p_.c_ == i / 2.0);
+      CHECK(x[i].p_.d_[2] == 3U);
+      CHECK(x[i].q_.first == i * 3U);
+      CHECK(x[i].r_ == std::chrono::seconds{i});
+    }
+  };
+
+  auto buf = cista::serialize(v);
+  check(*cista::deserialize<data::vector<nested>>(buf));
+
+  constexpr auto const BE = cista::mode::SERIALIZE_BIG_ENDIAN;
+  auto be_buf = cista::serialize<BE>(v);
+  auto const be = cista::deserialize<data::vector<nested>, BE>(be_buf);
+  REQUIRE(be->size() == v.size());
+  for (auto i = 0U; i != be->size(); ++i) {
+    CHECK((*be)[i].p_.a_ == i);
+    CHECK((*be)[i].q_.first == i * 3U);
+  }
+}
+
+TEST_CASE("pointer free vector range check") {
+  namespace data = cista::offset;
+
+  auto v = data::vector<pod>{};
+  v.resize(100U);
+  auto buf = cista::serialize(v);
+  CHECK_NOTHROW(cista::deserialize<data::vector<pod>>(buf));
+
+  buf.resize(buf.size() - 1U);
+  CHECK_THROWS(cista::deserialize<data::vector<pod>>(buf));
+}
@@ -0,0 +1,148 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace relocations_test {
+
+namespace data = cista::raw;
+
+struct node {
+  std::uint32_t id_;
+  data::vector<data::ptr<node>> edges_;
+  data::string name_;
+  data::unique_ptr<std::uint64_t> extra_;
+  node* parent_;
+};
+
+struct graph {
+  data::vector<node*> roots_;
+  data::indexed_vector<node> nodes_;
+  data::hash_map<data::string, std::uint32_t> index_;
+  data::cstring label_;
+};
+
+inline graph make_graph(std::uint32_t const n) {
+  auto g = graph{};
+  g.nodes_.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    auto& x = g.nodes_[i];
+    x.id_ = i;
+    x.edges_.push_back(&g.nodes_[(i * 7U) % n]);
+    x.edges_.push_back(&g.nodes_[(i + 1U) % n]);
+    x.name_ = "node " + std::to_string(i) + " with a long enough name";
+    if (i % 3U == 0U) {
+      x.extra_ = data::make_unique<std::uint64_t>(i * 10ULL);
+    }
+    g.index_.emplace(x.name_, i);
+  }
+  for (auto i = 1U; i < n; ++i) {
+    g.nodes_[i].parent_ = &g.nodes_[i / 2U];
+  }
+  for (auto i = 0U; i < n; i += 100U) {
+    g.roots_.push_back(&g.nodes_[i]);
+  }
+  g.label_ = data::cstring{"a label longer than the short buffer"};
+  return g;
+}
+
+inline void check_graph(graph const& g, std::uint32_t const n) {
+  REQUIRE(g.nodes_.size() == n);
+  CHECK(g.roots_.size() == (n + 99U) / 100U);
+  CHECK(g.roots_.back()->id_ == ((n - 1U) / 100U) * 100U);
+  CHECK(g.nodes_[0].parent_ == nullptr);
+  for (auto i = 0U; i != n; ++i) {
+    auto const& x = g.nodes_[i];
+    CHECK(x.id_ == i);
+    CHECK(x.edges_[0]->id_ == (i * 7U) % n);
+    CHECK(x.edges_[1]->id_ == (i + 1U) % n);
+    CHECK((i == 0U || x.parent_->id_ == i / 2U));
+    CHECK((i % 3U != 0U || *x.extra_ == i * 10ULL));
+    CHECK((i % 3U == 0U || x.extra_.get() == nullptr));
+    CHECK(g.index_.at(x.name_) == i);
+  }
+  CHECK(g.label_.view() == "a label longer than the short buffer");
+}
+
+}  // namespace relocations_test
+
+using namespace relocations_test;
+
+TEST_CASE("relocation table unchecked raw deserialization") {
+  constexpr auto const n = 10'000U;  // multiple relocation segments
+  constexpr auto const MODE = cista::mode::WITH_RELOCATIONS;
+
+  auto g = make_graph(n);
+  auto buf = cista::serialize<MODE>(g);
+  CHECK(buf.size() == cista::serialized_total_size<MODE>(g));
+
+  auto walked = buf;
+  check_graph(*cista::deserialize<graph, MODE>(walked), n);
+
+  auto relocated = buf;
+  check_graph(*cista::unchecked_deserialize<graph, MODE>(relocated), n);
+
+  constexpr auto const UNCHECKED = MODE | cista::mode::UNCHECKED;
+  for (auto const n_threads : {2U, 3U, 64U}) {
+    auto parallel = buf;
+    check_graph(
+        *cista::deserialize_parallel<graph, UNCHECKED>(parallel, n_threads), n);
+  }
+}
+
+TEST_CASE("relocation table truncated") {
+  using table_t = cista::relocation_table<cista::mode::NONE>;
+  auto const make = [](std::uint64_t const n_segments) {
+    auto t = std::array<std::uint64_t, 6U>{};
+    t[0] = n_segments * cista::RELOCATION_SEGMENT_SIZE;
+    t[1] = n_segments;
+    return t;
+  };
+  auto const table = [](std::array<std::uint64_t, 6U> const& t) {
+    auto const from = reinterpret_cast<std::uint8_t const*>(t.data());
+    return table_t{from, from + sizeof(t)};
+  };
+
+  // 48 bytes: the header and two segment entries.
+  CHECK(table(make(2U)).n_segments() == 2U);
+  CHECK_THROWS(table(make(3U)));
+}
+
+TEST_CASE("relocation table with integrity and streaming") {
+  constexpr auto const n = 1'000U;
+  constexpr auto const MODE =
+      cista::mode::WITH_TRAILER_INTEGRITY | cista::mode::WITH_RELOCATIONS;
+
+  auto g = make_graph(n);
+  auto buf = cista::serialize<MODE>(g);
+
+  auto streamed = cista::byte_buf{};
+  cista::serialize_stream<MODE>(
+      [&](std::uint8_t const* ptr, std::size_t const size) {
+        streamed.insert(end(streamed), ptr, ptr + size);
+      },
+      g);
+  CHECK(streamed == buf);
+  CHECK(cista::serialize_parallel<MODE>(g, 2U) == buf);
+
+  check_graph(*cista::unchecked_deserialize<graph, MODE>(streamed), n);
+
+  buf[buf.size() - 16U] ^= 0x01U;  // table position
+  CHECK_THROWS(cista::deserialize<graph, MODE>(buf));
+}
+
+TEST_CASE("relocation table in offset mode is empty") {
+  namespace o = cista::offset;
+  constexpr auto const MODE =
+      cista::mode::WITH_RELOCATIONS | cista::mode::UNCHECKED;
+
+  auto v = o::vector<o::string>{};
+  v.emplace_back("a string that is not short at all");
+  auto const buf = cista::serialize<MODE>(v);
+  auto const d = cista::deserialize<o::vector<o::string>, MODE>(buf);
+  REQUIRE(d->size() == 1U);
+  CHECK(d->front().view() == "a string that is not short at all");
+}
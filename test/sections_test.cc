@@ -0,0 +1,107 @@
+#include <cstdio>
+
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/sections.h"
+#include "cista/serialization.h"
+#endif
+
+namespace data = cista::offset;
+
+namespace sections_test {
+
+struct stop {
+  std::uint32_t id_;
+  data::string name_;
+};
+
+struct stops {
+  data::vector<stop> stops_;
+};
+
+struct routes {
+  data::vector<data::vector<std::uint32_t>> stop_seq_;
+};
+
+}  // namespace sections_test
+
+using namespace sections_test;
+
+TEST_CASE("sections write and load") {
+  constexpr auto const MODE = cista::mode::WITH_VERSION;
+  constexpr auto const path = "sections.bin";
+
+  auto s = stops{};
+  for (auto i = 0U; i != 100U; ++i) {
+    s.stops_.push_back(stop{i, "stop " + std::to_string(i)});
+  }
+  auto r = routes{};
+  r.stop_seq_.push_back({1U, 2U, 3U});
+  r.stop_seq_.push_back({4U, 5U});
+  auto const names = data::vector<data::string>{"a", "b", "c"};
+
+  {
+    auto sections = std::vector<cista::section>{};
+    sections.emplace_back(cista::make_section<MODE>("stops", s));
+    sections.emplace_back(cista::make_section<MODE>("routes", r, 4096U));
+    sections.emplace_back(cista::make_section("names", names));
+    cista::write_sections(path, sections, 2U);
+    CHECK_THROWS(cista::make_section("names", names, 3U));
+    sections.emplace_back(cista::make_section("names", names));
+    CHECK_THROWS(cista::write_sections(path, sections));
+  }
+
+  auto const f = cista::sections_file{path};
+  CHECK(f.contains("stops"));
+  CHECK(f.contains("names"));
+  CHECK(!f.contains("stop"));
+  CHECK(f.find("routes")->offset_ % 4096U == 0U);
+
+  {
+    auto const l = f.load<routes, MODE>("routes");
+    REQUIRE(l->stop_seq_.size() == 2U);
+    CHECK(l->stop_seq_[0U][2U] == 3U);
+    CHECK(l->stop_seq_[1U][1U] == 5U);
+  }
+  {
+    auto const l = f.load<stops, MODE | cista::mode::DEEP_CHECK>("stops");
+    REQUIRE(l->stops_.size() == 100U);
+    CHECK(l->stops_[42U].id_ == 42U);
+    CHECK(l->stops_[42U].name_ == "stop 42");
+  }
+  {
+    auto const l = f.load<data::vector<data::string>>("names");
+    REQUIRE(l->size() == 3U);
+    CHECK((*l)[2U] == "c");
+  }
+
+  CHECK_THROWS(f.load<routes>("unknown"));
+  CHECK_THROWS(f.load<stops, MODE>("routes"));
+  CHECK_THROWS(f.load<routes>("routes"));
+}
+
+TEST_CASE("sections integrity") {
+  constexpr auto const path = "sections_corrupt.bin";
+
+  auto const a = data::vector<std::uint64_t>{1U, 2U, 3U};
+  auto const b = data::vector<std::uint64_t>{4U, 5U, 6U};
+  cista::write_sections(path, {cista::make_section("a", a),
+                               cista::make_section("b", b)});
+
+  auto offset = std::size_t{0U};
+  {
+    auto const f = cista::sections_file{path};
+    offset = f.find("b")->offset_;
+  }
+  {
+    auto m = cista::mmap{path, cista::mmap::protection::MODIFY};
+    m.data()[offset] ^= 0xFFU;
+  }
+
+  auto const f = cista::sections_file{path};
+  CHECK(f.load<data::vector<std::uint64_t>>("a")->at(2U) == 3U);
+  CHECK_THROWS(f.load<data::vector<std::uint64_t>>("b"));
+}
@@ -0,0 +1,78 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace serialize_parallel_test {
+
+namespace data = cista::offset;
+
+struct node {
+  std::uint32_t id_;
+  data::vector<data::ptr<node>> edges_;
+  data::string name_;
+  data::indexed_vector<std::uint64_t> values_;
+  data::ptr<std::uint64_t> best_value_;
+};
+
+struct graph {
+  data::vector<data::ptr<node>> roots_;
+  data::indexed_vector<node> nodes_;
+  data::hash_map<data::string, std::uint32_t> index_;
+};
+
+inline graph make_graph(std::uint32_t const n) {
+  auto g = graph{};
+  g.nodes_.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    auto& x = g.nodes_[i];
+    x.id_ = i;
+    x.edges_.push_back(&g.nodes_[(i * 7U) % n]);
+    x.name_ = "node " + std::to_string(i) + " with a long enough name";
+    x.values_.resize(i % 512U);
+    for (auto j = 0U; j != x.values_.size(); ++j) {
+      x.values_[j] = i * j;
+    }
+    g.index_.emplace(x.name_, i);
+    if (i % 10U == 0U) {
+      g.roots_.push_back(&x);
+    }
+  }
+  for (auto i = 0U; i != n; ++i) {
+    auto& target = g.nodes_[(i * 13U) % n];
+    g.nodes_[i].best_value_ =
+        target.values_.empty() ? nullptr : &target.values_.back();
+  }
+  return g;
+}
+
+}  // namespace serialize_parallel_test
+
+using namespace serialize_parallel_test;
+
+TEST_CASE("serialize parallel is byte identical") {
+  auto g = make_graph(5'000U);  // ~10 MB
+
+  auto const seq = cista::serialize(g);
+  for (auto const n_threads : {1U, 2U, 3U, 8U}) {
+    CHECK(cista::serialize_parallel(g, n_threads) == seq);
+  }
+
+  constexpr auto const MODE =
+      cista::mode::WITH_VERSION | cista::mode::WITH_INTEGRITY;
+  auto const buf = cista::serialize_parallel<MODE>(g, 4U);
+  CHECK(buf == cista::serialize<MODE>(g));
+
+  auto const d = cista::deserialize<graph, MODE>(buf);
+  REQUIRE(d->nodes_.size() == 5'000U);
+  CHECK(d->nodes_[4'999U].values_.size() == 4'999U % 512U);
+  CHECK(d->index_.at(d->nodes_[42U].name_) == 42U);
+
+  constexpr auto const TRAILER = cista::mode::SERIALIZE_BIG_ENDIAN |
+                                 cista::mode::WITH_TRAILER_INTEGRITY;
+  CHECK(cista::serialize_parallel<TRAILER>(g, 4U) ==
+        cista::serialize<TRAILER>(g));
+}
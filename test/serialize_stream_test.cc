@@ -0,0 +1,131 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace serialize_stream_test {
+
+namespace data = cista::offset;
+
+struct node {
+  std::uint32_t id_;
+  data::vector<data::ptr<node>> edges_;
+  data::string name_;
+  data::indexed_vector<std::uint32_t> labels_;
+  data::ptr<std::uint32_t> best_label_;
+};
+
+struct graph {
+  data::vector<data::ptr<node>> roots_;  // forward references
+  data::indexed_vector<node> nodes_;
+  data::hash_map<data::string, std::uint32_t> index_;
+};
+
+inline graph make_graph(std::uint32_t const n) {
+  auto g = graph{};
+  g.nodes_.resize(n);
+  for (auto i = 0U; i != n; ++i) {
+    auto& x = g.nodes_[i];
+    x.id_ = i;
+    x.edges_.push_back(&g.nodes_[(i * 7U) % n]);
+    x.edges_.push_back(&g.nodes_[(i + 1U) % n]);
+    x.name_ = "node " + std::to_string(i) + " with a long enough name";
+    x.labels_ = {i, i * 2U, i * 3U};
+    g.index_.emplace(x.name_, i);
+    if (i % 10U == 0U) {
+      g.roots_.push_back(&x);
+    }
+  }
+  for (auto i = 0U; i != n; ++i) {
+    g.nodes_[i].best_label_ = &g.nodes_[(i * 13U) % n].labels_[i % 3U];
+  }
+  return g;
+}
+
+template <cista::mode const Mode, typename T>
+cista::byte_buf stream(T& g) {
+  auto out = cista::byte_buf{};
+  cista::serialize_stream<Mode>(
+      [&](std::uint8_t const* data, std::size_t const size) {
+        out.insert(end(out), data, data + size);
+      },
+      g);
+  return out;
+}
+
+inline void check_graph(graph const& g, std::uint32_t const n) {
+  REQUIRE(g.nodes_.size() == n);
+  CHECK(g.roots_.size() == (n + 9U) / 10U);
+  CHECK(g.roots_[1]->id_ == 10U);
+  for (auto i = 0U; i != n; ++i) {
+    auto const& x = g.nodes_[i];
+    CHECK(x.id_ == i);
+    CHECK(x.edges_[0]->id_ == (i * 7U) % n);
+    CHECK(*x.best_label_ == g.nodes_[(i * 13U) % n].labels_[i % 3U]);
+    CHECK(g.index_.at(x.name_) == i);
+  }
+}
+
+}  // namespace serialize_stream_test
+
+using namespace serialize_stream_test;
+
+TEST_CASE("serialize stream equals serialize") {
+  auto g = make_graph(500U);
+
+  CHECK(stream<cista::mode::NONE>(g) == cista::serialize(g));
+
+  constexpr auto const TRAILER = cista::mode::WITH_VERSION |
+                                 cista::mode::WITH_TRAILER_INTEGRITY |
+                                 cista::mode::DEEP_CHECK;
+  auto const buf = stream<TRAILER>(g);
+  CHECK(buf == cista::serialize<TRAILER>(g));
+  CHECK(buf.size() == cista::serialized_total_size<TRAILER>(g));
+  check_graph(*cista::deserialize<graph, TRAILER>(buf), 500U);
+}
+
+TEST_CASE("serialize stream trailer integrity over multiple chunks") {
+  constexpr auto const MODE = cista::mode::WITH_STATIC_VERSION |
+                              cista::mode::WITH_TRAILER_INTEGRITY;
+  auto g = make_graph(20'000U);
+  auto buf = stream<MODE>(g);
+  REQUIRE(buf.size() > 2U * cista::HASH_CHUNK_SIZE);
+  CHECK(buf == cista::serialize<MODE>(g));
+  check_graph(*cista::deserialize<graph, MODE>(buf), 20'000U);
+
+  auto corrupted = buf;
+  corrupted[corrupted.size() / 2U] ^= 0xFFU;
+  CHECK_THROWS(cista::deserialize<graph, MODE>(corrupted));
+
+  auto truncated = buf;
+  truncated.resize(truncated.size() - 1U);
+  CHECK_THROWS(cista::deserialize<graph, MODE>(truncated));
+}
+
+TEST_CASE("serialize stream big endian") {
+  constexpr auto const MODE = cista::mode::SERIALIZE_BIG_ENDIAN |
+                              cista::mode::WITH_TRAILER_INTEGRITY;
+  auto g = make_graph(100U);
+  auto buf = stream<MODE>(g);
+  CHECK(buf == cista::serialize<MODE>(g));
+  check_graph(*cista::deserialize<graph, MODE>(buf), 100U);
+}
+
+TEST_CASE("serialize stream non-owning cstring") {
+  auto const s = std::string{"a string that is not owned by the cstring"};
+  auto v = data::vector<data::cstring>{};
+  v.emplace_back(std::string_view{s}.substr(0U, 20U),
+                 data::cstring::non_owning);
+  v.emplace_back(s, data::cstring::owning);
+
+  auto const buf = stream<cista::mode::NONE>(v);
+  CHECK(buf == cista::serialize(v));
+
+  auto const d = cista::deserialize<data::vector<data::cstring>>(buf);
+  CHECK(d->at(0).view() == s.substr(0U, 20U));
+  CHECK(std::string_view{d->at(0).c_str()} == s.substr(0U, 20U));
+  CHECK(d->at(1).view() == s);
+}
@@ -0,0 +1,98 @@
+#include "doctest.h"
+
+#ifdef SINGLE_HEADER
+#include "cista.h"
+#else
+#include "cista/serialization.h"
+#endif
+
+namespace serialized_total_size_test {
+
+template <typename Ctx>
+struct item {
+  std::uint8_t flag_;
+  cista::indexed<typename Ctx::string> name_;
+  typename Ctx::template vector<std::uint64_t> values_;
+  typename Ctx::template ptr<typename Ctx::string> ref_;
+};
+
+template <typename Ctx>
+struct root {
+  typename Ctx::template vector<item<Ctx>> items_;
+  typename Ctx::template hash_map<typename Ctx::string, std::uint32_t> index_;
+  typename Ctx::template unique_ptr<std::uint16_t> extra_;
+};
+
+struct offset_ctx {
+  using string = cista::offset::string;
+  template <typename T>
+  using vector = cista::offset::vector<T>;
+  template <typename T>
+  using ptr = cista::offset::ptr<T>;
+  template <typename K, typename V>
+  using hash_map = cista::offset::hash_map<K, V>;
+  template <typename T>
+  using unique_ptr = cista::offset::unique_ptr<T>;
+};
+
+struct raw_ctx {
+  using string = cista::raw::string;
+  template <typename T>
+  using vector = cista::raw::vector<T>;
+  template <typename T>
+  using ptr = cista::raw::ptr<T>;
+  template <typename K, typename V>
+  using hash_map = cista::raw::hash_map<K, V>;
+  template <typename T>
+  using unique_ptr = cista::raw::unique_ptr<T>;
+};
+
+template <typename Ctx>
+root<Ctx> make_root() {
+  auto r = root<Ctx>{};
+  for (auto i = 0U; i != 100U; ++i) {
+    auto& it = r.items_.emplace_back();
+    it.flag_ = static_cast<std::uint8_t>(i);
+    it.name_ = i % 2U == 0U ? "short" : "a string that does not fit inline";
+    for (auto j = 0U; j != i % 7U; ++j) {
+      it.values_.push_back(j);
+    }
+    r.index_.emplace(it.name_, i);
+  }
+  for (auto i = 0U; i != 100U; ++i) {
+    r.items_[i].ref_ = &r.items_[(i * 13U) % 100U].name_;
+  }
+  r.extra_ = typename Ctx::template unique_ptr<std::uint16_t>{
+      new std::uint16_t{42U}, true};
+  return r;
+}
+
+template <cista::mode const Mode, typename T>
+void check_size(T& value) {
+  CHECK(cista::serialized_total_size<Mode>(value) ==
+        cista::serialize<Mode>(value).size());
+}
+
+}  // namespace serialized_total_size_test
+
+using namespace serialized_total_size_test;
+
+TEST_CASE("serialized total size matches serialize") {
+  auto o = make_root<offset_ctx>();
+  check_size<cista::mode::NONE>(o);
+  check_size<cista::mode::WITH_VERSION | cista::mode::WITH_INTEGRITY>(o);
+  check_size<cista::mode::WITH_STATIC_VERSION>(o);
+  check_size<cista::mode::SERIALIZE_BIG_ENDIAN>(o);
+
+  auto r = make_root<raw_ctx>();
+  check_size<cista::mode::NONE>(r);
+  check_size<cista::mode::WITH_VERSION | cista::mode::WITH_INTEGRITY>(r);
+}
+
+TEST_CASE("serialized total size of scalars and empty containers") {
+  auto i = std::uint64_t{7U};
+  CHECK(cista::serialized_total_size(i) == sizeof(i));
+
+  auto v = cista::offset::vector<int>{};
+  check_size<cista::mode::NONE>(v);
+}